@@ -1,40 +1,83 @@
 #ifndef AUDIO_H
 #define AUDIO_H
 
+#include <AudioBackend.h>
+#include <AudioCallbackMonitor.h>
+#include <DriftController.h>
+#include <MicCapture.h>
 #include <QObject>
-#include <portaudio.h>
+#include <RxChain.h>
+#include <WavRecorder.h>
+#include <atomic>
+#include <memory>
 
 class Console;
 class AudioProcessor;
+class QTimer;
 
 class Audio : public QObject {
     Q_OBJECT
 
 public:
+    static const int SUMMARY_INTERVAL_MS = 10000;   // Callback timing log line
+    static const int RECEIVE_LATENCY_MS = 40;       // Receive ring fill to hold
+
     explicit Audio(Console* console, QObject* parent = nullptr);
     ~Audio();
 
+    // Picks the backend initialize() opens (see AudioBackend::create()) and
+    // its device/file settings; the rate and buffer size come from
+    // initialize(). Defaults to PortAudio on the default output device.
+    bool setBackend(const QString& name, const AudioBackend::Config& options = AudioBackend::Config());
     bool initialize(int sampleRate, int bufferSize);
     void start();
     void stop();
     bool startPlayback(const QString& filename, int id);
-    bool startRecording(const QString& filename, int channels, int sampleRate);
+    bool startRecording(const QString& filename, int channels, int sampleRate,
+                        WavRecorder::Encoding encoding = WavRecorder::Encoding::Int16);
     void stopPlayback(int id);
     void stopRecording();
     void setPlaybackEnabled(bool enabled);
     void setPreamp(double gain);
+    // Demodulated receive audio, mono at the stream rate, drained by the
+    // callback into both channels through a DriftController, which holds
+    // the ring at RECEIVE_LATENCY_MS (at least two buffers plus one RxChain
+    // block) against the radio/sound card clock drift. Set before start().
+    void setReceiveAudio(AudioRingBuffer* ring);
+    // Times the callback ran the receive ring dry and rebuffered.
+    quint64 getReceiveUnderruns() const;
+    // Measured radio vs sound card clock drift and the ring's fill.
+    DriftController::Stats getReceiveDrift() const;
+    // Callbacks that ran short of WAV playback audio before the end of the file.
+    quint64 getPlaybackUnderruns() const;
+    // Callback timing histograms and host xrun counts since initialize().
+    AudioCallbackMonitor::Stats getCallbackStats() const;
+    // Mic samples from the stream's first input channel, stamped against
+    // the output stream, for transmit and monitoring. Empty unless the
+    // backend options ask for input channels. The consumer side belongs
+    // to a single reader thread.
+    MicCapture& micCapture();
 
 private:
-    static int audioCallback(const void* input, void* output, unsigned long frameCount,
-                             const PaStreamCallbackTimeInfo* timeInfo,
-                             PaStreamCallbackFlags statusFlags, void* userData);
+    void audioCallback(const float* input, float* output, unsigned long frameCount,
+                       const AudioBackend::Timing& timing);
 
     Console* console_;
     bool initialized_;
-    PaStream* stream_;
+    std::unique_ptr<AudioBackend> backend_;
+    AudioBackend::Config backendConfig_;
     bool playbackEnabled_;
     double preampGain_;
     AudioProcessor* processor_; // Added
+    AudioRingBuffer* receiveAudio_;
+    DriftController drift_;
+    MicCapture mic_;
+    int sampleRate_;
+    int inputChannels_;
+    int64_t outputFrames_;          // Callback thread: output frames so far
+    AudioCallbackMonitor monitor_;
+    QTimer* summaryTimer_;
+    void drainReceiveAudio(float* out, unsigned long frameCount);
 };
 
 #endif // AUDIO_H
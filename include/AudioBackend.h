@@ -0,0 +1,69 @@
+#ifndef AUDIOBACKEND_H
+#define AUDIOBACKEND_H
+
+#include <QString>
+#include <functional>
+#include <memory>
+
+// Where the audio stream comes from and goes to. Audio drives everything
+// through this interface, so the same pipeline runs against a sound card
+// (PortAudioBackend), a clock thread and no hardware at all
+// (NullAudioBackend), or WAV files as fast as the CPU allows
+// (FileAudioBackend) for soak tests and benchmarks on headless machines.
+//
+// Every backend calls the callback from one thread of its own, with the
+// same real-time rules as a PortAudio callback: no locks, no allocation,
+// no blocking.
+class AudioBackend {
+public:
+    // Host timing for one callback, in seconds on the backend's clock.
+    // outputDacTime is when the first output frame reaches the DAC and
+    // inputAdcTime when the first input frame left the ADC; either is 0
+    // when the backend does not know (unpaced file runs, no input). flags
+    // uses AudioCallbackMonitor::Flag bits.
+    struct Timing {
+        double currentTime = 0.0;
+        double outputDacTime = 0.0;
+        double inputAdcTime = 0.0;
+        unsigned long flags = 0;
+    };
+
+    // input: frames x inputChannels interleaved, or nullptr when there is no
+    // input. output: frames x outputChannels interleaved, to be filled.
+    using Callback = std::function<void(const float* input, float* output, unsigned long frames,
+                                        const Timing& timing)>;
+
+    struct Config {
+        int sampleRate = 48000;
+        int framesPerBuffer = 512;
+        int outputChannels = 2;
+        int inputChannels = 0;
+        QString outputDevice;       // PortAudio: part of the device name; empty = default
+        QString inputDevice;        // PortAudio: as outputDevice, used when inputChannels > 0
+        double outputLatency = 0.0; // PortAudio: suggested latency, s; 0 = the device's low default
+        double inputLatency = 0.0;
+        QString outputFile;         // File: WAV written with the output; empty = discard
+        QString inputFile;          // File: WAV fed as input, looped; empty = silence
+        double speed = 0.0;         // File: multiple of real time; 0 = as fast as possible
+    };
+
+    virtual ~AudioBackend() = default;
+
+    virtual const char* name() const = 0;
+    // Returns false, with the reason logged, if the stream cannot be
+    // opened. Closes any stream already open first.
+    virtual bool open(const Config& config, Callback callback) = 0;
+    virtual bool start() = 0;
+    // Returns once the callback can no longer run.
+    virtual void stop() = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+    virtual bool isRunning() const = 0;
+    // Now, on the clock Timing uses.
+    virtual double streamTime() const = 0;
+
+    // "portaudio", "null" or "file"; nullptr for anything else.
+    static std::unique_ptr<AudioBackend> create(const QString& name);
+};
+
+#endif // AUDIOBACKEND_H
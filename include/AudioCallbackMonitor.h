@@ -0,0 +1,96 @@
+#ifndef AUDIOCALLBACKMONITOR_H
+#define AUDIOCALLBACKMONITOR_H
+
+#include <LatencyHistogram.h>
+#include <atomic>
+#include <cstdint>
+
+// Timing and xrun instrumentation for the audio callback. The callback
+// brackets its work with begin() and end(); they read the monotonic clock,
+// bump atomic counters and record into LatencyHistograms, so they never
+// lock or allocate. Per callback it records:
+//
+//   duration  time spent between begin() and end()
+//   jitter    |time since the previous begin() - that callback's nominal
+//             period (frames / sample rate)|
+//   headroom  time left before the buffer reaches the DAC, from the
+//             host's timestamps (output DAC time - current time - duration);
+//             callbacks that overrun it count as deadline misses
+//
+// plus the host's input/output underflow and overflow flags. stats() can be
+// polled from any thread; logSummary() logs what changed since its previous
+// call and is meant for a periodic timer. Headroom percentiles near zero, or
+// deadline misses, say the buffer is too small; a large minimum headroom
+// says it could be smaller.
+class AudioCallbackMonitor {
+public:
+    // Same bit values as PortAudio's PaStreamCallbackFlags.
+    enum Flag : unsigned long {
+        InputUnderflow = 0x1,
+        InputOverflow = 0x2,
+        OutputUnderflow = 0x4,
+        OutputOverflow = 0x8,
+        PrimingOutput = 0x10,
+    };
+
+    struct Stats {
+        uint64_t callbacks = 0;
+        uint64_t inputUnderflows = 0;
+        uint64_t inputOverflows = 0;
+        uint64_t outputUnderflows = 0;
+        uint64_t outputOverflows = 0;
+        uint64_t deadlineMisses = 0;
+        LatencyHistogram::Snapshot duration;   // ns
+        LatencyHistogram::Snapshot jitter;     // ns
+        LatencyHistogram::Snapshot headroom;   // ns; only callbacks with host timestamps
+
+        uint64_t xruns() const;
+        // What happened between earlier and this snapshot.
+        Stats since(const Stats& earlier) const;
+    };
+
+    AudioCallbackMonitor();
+
+    AudioCallbackMonitor(const AudioCallbackMonitor&) = delete;
+    AudioCallbackMonitor& operator=(const AudioCallbackMonitor&) = delete;
+
+    // Control thread, while the stream is stopped. restart() forgets the
+    // previous callback so the gap across a stop/start is not counted as
+    // jitter.
+    void setSampleRate(int rate);
+    int sampleRate() const;
+    void restart();
+
+    // Real-time. currentTime and outputDacTime are the host's stream
+    // timestamps in seconds; pass 0 for both when it has none.
+    void begin(unsigned long frames, double currentTime, double outputDacTime, unsigned long flags);
+    void end();
+
+    Stats stats() const;
+    // Control thread: logs one line for the interval since the last call.
+    void logSummary();
+
+private:
+    int sampleRate_;
+
+    // Real-time thread only.
+    int64_t startNs_;
+    int64_t lastStartNs_;
+    int64_t lastPeriodNs_;
+    int64_t deadlineNs_;            // DAC time - current time; <= 0 if unknown
+
+    LatencyHistogram duration_;
+    LatencyHistogram jitter_;
+    LatencyHistogram headroom_;
+    std::atomic<uint64_t> callbacks_;
+    std::atomic<uint64_t> inputUnderflows_;
+    std::atomic<uint64_t> inputOverflows_;
+    std::atomic<uint64_t> outputUnderflows_;
+    std::atomic<uint64_t> outputOverflows_;
+    std::atomic<uint64_t> deadlineMisses_;
+
+    Stats lastSummary_;             // logSummary() only
+    int64_t lastSummaryNs_;
+};
+
+#endif // AUDIOCALLBACKMONITOR_H
@@ -3,57 +3,69 @@
 
 #include <QObject>
 #include <QString>
+#include <PlaybackMixer.h>
+#include <WavRecorder.h>
+#include <atomic>
 #include <portaudio.h>
-#include <vector>
 
+class DspThread;
+
+// WAV playback into, and recording from, the audio stream. Playback streams
+// are mixed by a PlaybackMixer whose rings a disk thread keeps topped up;
+// recording goes through a WavRecorder, which has its own writer thread.
+// Both convert between the file's rate and the stream's off the callback.
+// The audio callback only touches rings and atomics, so it never
+// blocks or allocates, and none of the control calls wait on it.
 class AudioProcessor : public QObject {
     Q_OBJECT
 
 public:
+    static const int OUTPUT_CHANNELS = 2;
+    static const int DEFAULT_RATE = 48000;
+    static const Resampler::Quality PLAYBACK_QUALITY = Resampler::Quality::High;
+    static const Resampler::Quality RECORDING_QUALITY = Resampler::Quality::High;
+
     explicit AudioProcessor(QObject* parent = nullptr);
     ~AudioProcessor();
 
-    bool startPlayback(const QString& filename, int id);
-    bool startRecording(const QString& filename, int channels, int sampleRate);
+    // The audio stream's rate. Playback is converted to it and recordings
+    // are converted from it; set before the stream starts.
+    void setStreamRate(int rate);
+    int getStreamRate() const;
+
+    // Several streams can play at once, each under its own id; starting an
+    // id that is already playing replaces it. Files at any rate play.
+    bool startPlayback(const QString& filename, int id,
+                       const PlaybackMixer::Options& options = PlaybackMixer::Options());
+    // A sine tone for seconds, or until stopped when seconds is 0.
+    bool startTone(int id, double frequency, double amplitude, double seconds = 0.0,
+                   const PlaybackMixer::Options& options = PlaybackMixer::Options());
+    // Records the stream's input at sampleRate, whatever the stream rate.
+    bool startRecording(const QString& filename, int channels, int sampleRate,
+                        WavRecorder::Encoding encoding = WavRecorder::Encoding::Int16);
     void stopPlayback(int id);
     void stopRecording();
+    void setPlaybackGain(int id, double gain);
     void setPreamp(double gain);
+    // Mixer time in frames, for PlaybackMixer::Options::startFrame.
+    quint64 getPlaybackClock() const;
+
+    // Callbacks that found a playback stream short before its end.
+    quint64 getPlaybackUnderruns() const;
+    // Recorded frames dropped because the writer thread fell behind.
+    quint64 getRecordingDropped() const;
 
-    // Callback interface for PortAudio
-    int processAudio(float* input, float* output, unsigned long frameCount);
+    // Callback interface. Output is interleaved stereo; input, if any, is
+    // inputChannels interleaved and is what gets recorded, mapped onto the
+    // recording's channels.
+    int processAudio(const float* input, int inputChannels, float* output, unsigned long frameCount);
 
 private:
-    struct WavHeader {
-        char riff[4];
-        uint32_t chunkSize;
-        char wave[4];
-        char fmt[4];
-        uint32_t subchunk1Size;
-        uint16_t audioFormat;
-        uint16_t numChannels;
-        uint32_t sampleRate;
-        uint32_t byteRate;
-        uint16_t blockAlign;
-        uint16_t bitsPerSample;
-        char data[4];
-        uint32_t subchunk2Size;
-    };
-
-    struct PlaybackState {
-        FILE* file;
-        WavHeader header;
-        std::vector<float> buffer;
-        size_t bufferPos;
-        bool active;
-        int id;
-    };
-
-    PlaybackState playback_;
-    FILE* recordingFile_;
-    WavHeader recordingHeader_;
-    double preampGain_;
-    bool writeWavHeader(FILE* file, int channels, int sampleRate);
-    bool readWavHeader(FILE* file, WavHeader& header);
+    DspThread* diskThread_;
+    PlaybackMixer mixer_;
+    WavRecorder recorder_;
+    std::atomic<float> preampGain_;
+    int streamRate_;
 };
 
 #endif // AUDIOPROCESSOR_H
@@ -25,6 +25,11 @@ public:
     void setFilterBandwidth(int bandwidth);
     void tci_cmd(const QString& command, QTcpSocket* client); // Added
 
+signals:
+    // mode: "LSB", "USB", "AM" or "CW"
+    void rxModeChanged(const QString& mode);
+    void filterBandwidthChanged(int bandwidth);
+
 private:
     int sampleRate_;
     QString appDataPath_;
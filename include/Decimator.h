@@ -0,0 +1,120 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <cstdint>
+#include <vector>
+
+// Multi-stage complex decimator from the wideband I/Q rate down to a
+// channel rate (48k/24k/12k). Power-of-two ratios only:
+//
+//   ratio 2..8: 0-2 wide half-bands -> final half-band
+//   ratio >=16: CIC (order 4, ratio/4) -> CIC-compensating FIR /2 -> final half-band
+//
+// The CIC only comes in at ratio/4 >= 4, where its own alias rejection is
+// better than 70 dB; below that the half-band cascade is cheaper anyway.
+//
+// The CIC runs in wrapping 64-bit integer arithmetic, so it is exact and
+// never drifts. Its fixed-point scale leaves headroom for +/-1.0 full scale
+// and no more: inputs beyond that are clipped there and counted in
+// clippedSamples(), since they would wrap the integrators. The half-band
+// stages are float and take any level, but callers should not rely on it. The FIR stages are polyphase: only the kept outputs are
+// computed, and the half-bands skip their zero taps. Coefficient tables are
+// designed once per ratio and shared between instances.
+//
+// Not thread-safe; configure() and process() belong to the DSP thread.
+class Decimator {
+public:
+    static const int CIC_ORDER = 4;
+    static const int MAX_RATIO = 64;
+
+    Decimator();
+    ~Decimator();
+
+    // Returns false (and keeps the previous setup) unless inputRate/outputRate
+    // is a power of two no larger than MAX_RATIO.
+    bool configure(int inputRate, int outputRate);
+    void reset();
+
+    int inputRate() const;
+    int outputRate() const;
+    int ratio() const;
+    // Delay of the whole chain, in output samples and in seconds.
+    double groupDelaySamples() const;
+    double groupDelaySeconds() const;
+    // Upper bound on outputs produced by one process() call.
+    int maxOutput(int inputCount) const;
+
+    // iq: count interleaved complex input samples, full scale +/-1.0. out:
+    // interleaved complex output, at least maxOutput(count) samples.
+    // Returns samples written.
+    int process(const float* iq, int count, float* out);
+    // I or Q values clipped to full scale at the CIC input since configure().
+    uint64_t clippedSamples() const;
+
+    struct Design;
+
+private:
+    struct CicStage {
+        int ratio = 1;
+        int phase = 0;
+        float inputScale = 1.0f;
+        float outputScale = 1.0f;
+        uint64_t clipped = 0;
+        uint64_t integrators[2][CIC_ORDER] = {};
+        uint64_t combs[2][CIC_ORDER] = {};
+        void setup(int r);
+        void reset();
+        int process(const float* inI, const float* inQ, int n, float* outI, float* outQ);
+    };
+
+    // Dense FIR decimating by factor, evaluated only at kept outputs.
+    struct FirStage {
+        const std::vector<float>* taps = nullptr;
+        int factor = 2;
+        int phase = 0;
+        int index = 0;
+        std::vector<float> historyI; // Doubled so the window is always contiguous
+        std::vector<float> historyQ;
+        void setup(const std::vector<float>* t, int f);
+        void reset();
+        int process(const float* inI, const float* inQ, int n, float* outI, float* outQ);
+    };
+
+    // Half-band decimate-by-2 in polyphase form: even inputs go through the
+    // dense non-zero taps, odd inputs only through a delay to the centre tap.
+    struct HalfbandStage {
+        const std::vector<float>* taps = nullptr; // Non-zero outer taps
+        int delay = 0;                            // Centre-tap delay in pairs
+        bool odd = false;
+        int index = 0;
+        int oddIndex = 0;
+        std::vector<float> historyI;
+        std::vector<float> historyQ;
+        std::vector<float> oddI;
+        std::vector<float> oddQ;
+        void setup(const std::vector<float>* t);
+        void reset();
+        int process(const float* inI, const float* inQ, int n, float* outI, float* outQ);
+    };
+
+    static const int BLOCK_SIZE = 4096; // Input samples per internal pass
+    static const int MAX_WIDE_STAGES = 2;
+
+    int inputRate_;
+    int outputRate_;
+    int ratio_;
+    double groupDelayInput_; // Input samples
+    const Design* design_;
+    bool useCic_;
+    bool useComp_;
+    int wideStages_;
+    bool useFinal_;
+    CicStage cic_;
+    FirStage comp_;
+    HalfbandStage wide_[MAX_WIDE_STAGES];
+    HalfbandStage final_;
+    std::vector<float> bufI_[2];
+    std::vector<float> bufQ_[2];
+};
+
+#endif // DECIMATOR_H
@@ -1,27 +1,65 @@
 #ifndef INCLUDED_DISPLAY_H
 #define INCLUDED_DISPLAY_H
 
+#include <QImage>
 #include <QWidget>
+#include <SpectrumFrame.h>
+#include <SpectrumRenderer.h>
 #include <vector>
 
 class Console;
 
+// Panadapter. The image is rasterized by Display's SpectrumRenderer; this
+// widget only blits the latest one.
 class SpectrumWidget : public QWidget {
     Q_OBJECT
 
 public:
+    using TraceStyle = SpectrumRenderer::TraceStyle;
+
     explicit SpectrumWidget(QWidget* parent = nullptr);
-    void setData(const std::vector<float>& data, double centerFrequency, int bandwidth);
+    // image stays owned by the caller and must outlive the next paint.
+    void setImage(const QImage* image);
+    void setView(double centerFrequency, int bandwidth);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+
+signals:
+    void frequencySelected(double freq);
+
+private:
+    const QImage* image_;
+    double centerFrequency_;
+    int bandwidth_;
+};
+
+// Scrolling waterfall. Each rendered scanline is copied into a circular
+// QImage, newest at the top: the line is written in place and painting
+// splits the image into two blits at the wrap point, so nothing is ever
+// shifted.
+class WaterfallWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit WaterfallWidget(QWidget* parent = nullptr);
+    void addLine(const QRgb* line, int count);
+    void setView(double centerFrequency, int bandwidth);
 
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
 
 signals:
     void frequencySelected(double freq);
 
 private:
-    std::vector<float> spectrumData_;
+    void resetImage();
+
+    QImage image_;
+    int newestRow_;
     double centerFrequency_;
     int bandwidth_;
 };
@@ -35,15 +73,29 @@ public:
 
     void setCenterFrequency(double freq);
     void setBandwidth(int bw);
-    void updateSpectrum(const float* data, int size);
+    void setTraceStyle(SpectrumWidget::TraceStyle style);
+    // Fixed panadapter scale; the default follows the frame peak.
+    void setSpectrumRange(float topDb, float rangeDb);
+    void setAutoReference(bool enabled);
+    // dBFS mapped to the bottom and top of the waterfall palette.
+    void setWaterfallLevels(float floorDb, float ceilingDb);
+    void updateSpectrum(const SpectrumFrameRef& frame);
 
 signals:
     void frequencyChanged(double freq);
 
+private slots:
+    void applyRenderResult();
+
 private:
+    void pushView();
+
     Console* palette_;
     SpectrumWidget* spectrumWidget_;
-    std::vector<float> spectrumData_; // Added
+    WaterfallWidget* waterfallWidget_;
+    SpectrumRenderer* renderer_;
+    SpectrumRenderer::View view_;
+    SpectrumRenderer::Result front_;
     double centerFrequency_;
     int bandwidth_;
 };
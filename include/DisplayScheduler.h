@@ -0,0 +1,55 @@
+#ifndef DISPLAYSCHEDULER_H
+#define DISPLAYSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <SpectrumFrame.h>
+#include <atomic>
+
+// Decouples the spectrum producer from the GUI. post() may be called from
+// any thread at any rate: it only swaps the frame into a latest-wins
+// mailbox, so nothing is queued on the GUI event loop. A timer on the GUI
+// thread, capped at the screen refresh rate, takes the newest frame and
+// emits frameReady() at most once per tick. Frames replaced before they
+// were shown are counted as skipped.
+class DisplayScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr double DEFAULT_FPS = 60.0;
+    static constexpr double MAX_FPS = 240.0;
+
+    explicit DisplayScheduler(QObject* parent = nullptr);
+    ~DisplayScheduler();
+
+    // Rate cap in frames per second; never above the screen's refresh rate.
+    void setMaxFps(double fps);
+    double getMaxFps() const;
+
+    quint64 getFramesPosted() const;
+    quint64 getFramesShown() const;
+    quint64 getFramesSkipped() const;
+
+public slots:
+    // Thread-safe; connect with Qt::DirectConnection so producers never
+    // touch the GUI event queue.
+    void post(const SpectrumFrameRef& frame);
+
+signals:
+    void frameReady(const SpectrumFrameRef& frame);
+
+private slots:
+    void tick();
+
+private:
+    static double screenRefreshRate();
+
+    QTimer* timer_;
+    double maxFps_;
+    SpectrumFrameMailbox mailbox_;
+    std::atomic<quint64> posted_;
+    std::atomic<quint64> shown_;
+    std::atomic<quint64> skipped_;
+};
+
+#endif // DISPLAYSCHEDULER_H
@@ -0,0 +1,114 @@
+#ifndef DRIFTCONTROLLER_H
+#define DRIFTCONTROLLER_H
+
+#include <Resampler.h>
+#include <RingBuffer.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Keeps the receive audio ring at a constant fill level although the
+// radio's sample clock and the sound card's clock run free of each other.
+// The audio callback pulls its frames through pull(), which drains the
+// ring through a 1:1 Resampler whose ratio is trimmed in parts per million.
+//
+// Each callback measures the fill (ring plus resampled frames not yet
+// handed out), smooths it with a one-pole filter of FILTER_SECONDS to take
+// out the sawtooth of bursty network writes and periodic reads, and runs a
+// PI loop on the error from the target:
+//
+//   ppm = Kp * error + integral,   integral += Ki * error * dt
+//
+// with Kp and Ki set for a critically damped loop with a LOOP_SECONDS time
+// constant, so corrections stay slow enough to be inaudible. In steady
+// state the proportional term is zero and the integral is the clock
+// mismatch itself: driftPpm() is how much faster the radio produces samples
+// than the card consumes them. It survives reset(), so a restarted stream
+// starts from the previous estimate.
+//
+// Latency is bounded two ways. The callback outputs silence until the ring
+// holds the target (at start and after an underrun), then drops whatever is
+// in excess of it. If the smoothed fill ever runs more than the target
+// over, the excess is dropped again and counted as a resync; with a sane
+// target this only happens after a network stall releases a burst.
+//
+// pull() runs on the audio callback: no locks, no allocation. stats() may
+// be polled from any thread.
+class DriftController {
+public:
+    static constexpr double LOOP_SECONDS = 30.0;     // PI loop time constant
+    static constexpr double FILTER_SECONDS = 3.0;    // Fill smoothing
+    static constexpr double MAX_PPM = 1000.0;        // Correction limit
+    static const int CHUNK_FRAMES = 256;             // Ring frames per process()
+
+    struct Stats {
+        double driftPpm = 0.0;      // Estimated radio clock - card clock
+        double correctionPpm = 0.0; // Ratio trim currently applied
+        double fillFrames = 0.0;    // Smoothed fill
+        int targetFrames = 0;
+        int sampleRate = 0;
+        bool locked = false;        // Running, not buffering
+        uint64_t underruns = 0;
+        uint64_t resyncs = 0;
+        uint64_t droppedFrames = 0;
+
+        // Smoothed fill in ms: the receive audio latency the ring adds.
+        double latencyMs() const;
+    };
+
+    DriftController();
+
+    DriftController(const DriftController&) = delete;
+    DriftController& operator=(const DriftController&) = delete;
+
+    // Control thread, while the stream is stopped. targetFrames is the fill
+    // to hold the ring at: it has to cover a callback's worth of frames plus
+    // the largest burst the producer writes at once. Clears the drift
+    // estimate.
+    bool configure(int sampleRate, int targetFrames,
+                   Resampler::Quality quality = Resampler::Quality::Medium);
+    // Control thread: back to buffering for a new stream, keeping the drift
+    // estimate.
+    void reset();
+
+    // Real-time. Writes frames mono frames from ring to out, duplicated
+    // into each of channels interleaved channels, and returns how many were
+    // written; the caller's buffer is left as it was for the rest.
+    size_t pull(AudioRingBuffer& ring, float* out, size_t frames, int channels);
+
+    Stats stats() const;
+    double driftPpm() const;
+    // Control thread: logs one line with the drift and fill.
+    void logSummary();
+
+private:
+    void update(AudioRingBuffer& ring, size_t frames);
+    void trim(AudioRingBuffer& ring, size_t fill);
+
+    int sampleRate_;
+    int targetFrames_;
+    double kp_;                     // ppm per frame of error
+    double ki_;                     // ppm per frame-second of error
+
+    // Real-time thread only.
+    Resampler resampler_;
+    std::vector<float> resampled_;  // One chunk at the output side
+    size_t resampledFrames_;
+    size_t resampledRead_;
+    bool locked_;
+    double fill_;
+    double integral_;
+
+    std::atomic<double> driftPpm_;
+    std::atomic<double> correctionPpm_;
+    std::atomic<double> fillFrames_;
+    std::atomic<bool> lockedFlag_;
+    std::atomic<uint64_t> underruns_;
+    std::atomic<uint64_t> resyncs_;
+    std::atomic<uint64_t> droppedFrames_;
+
+    uint64_t lastResyncs_;          // logSummary() only
+    uint64_t lastUnderruns_;
+};
+
+#endif // DRIFTCONTROLLER_H
@@ -0,0 +1,68 @@
+#ifndef DSPKERNELS_H
+#define DSPKERNELS_H
+
+#include <cstdint>
+
+// Vectorized inner loops shared by the DSP code. Each entry point picks an
+// AVX2/FMA, SSE2 or scalar implementation once at runtime, so the binary
+// still runs on CPUs without AVX2.
+namespace DspKernels {
+
+// Splits interleaved I/Q into separate real/imaginary arrays, applying the
+// window and a scalar gain in the same pass.
+void windowDeinterleave(const float* iq, const float* window, float gain,
+                        float* re, float* im, int n);
+
+// outDb[i] = 10*log10(re[i]^2 + im[i]^2) + offsetDb, using a polynomial
+// log2 approximation (error below 0.0001 dB).
+void logPower(const float* re, const float* im, float offsetDb, float* outDb, int n);
+
+// Same as logPower but FFT-shifted, so the DC bin lands at n/2.
+void fftShiftLogPower(const float* re, const float* im, float offsetDb, float* outDb, int n);
+
+// acc[i] += re[i]^2 + im[i]^2
+void accumulatePower(const float* re, const float* im, float* acc, int n);
+
+// acc[i] += in[i] * gain. Mixes a stream into an output buffer.
+void accumulateScaled(const float* in, float gain, float* acc, int n);
+
+// outDb[i] = 10*log10(power[i] * scale) + offsetDb, FFT-shifted like
+// fftShiftLogPower.
+void fftShiftPowerToDb(const float* power, float scale, float offsetDb, float* outDb, int n);
+
+// out[i] = (signed 24-bit big-endian value at in + 3*i) * scale. Used for
+// openHPSDR sample payloads; the SIMD paths use a byte shuffle (SSSE3/AVX2).
+void int24BEToFloat(const uint8_t* in, float scale, float* out, int n);
+
+// out[i] = (signed little-endian 16/24/32-bit value i) * scale, reading
+// 2, 3 or 4 bytes per sample with no alignment requirement. Used for WAV
+// PCM payloads.
+void int16LEToFloat(const uint8_t* in, float scale, float* out, int n);
+void int24LEToFloat(const uint8_t* in, float scale, float* out, int n);
+void int32LEToFloat(const uint8_t* in, float scale, float* out, int n);
+
+// out[0] = sum(taps[i] * a[i]), out[1] = sum(taps[i] * b[i]). One pass of
+// a real FIR over planar I and Q histories.
+void dualDotProduct(const float* taps, const float* a, const float* b, int n, float* out);
+
+// Complex mixer driven by MIX_LANES recursive phasors. Sample i is
+// multiplied by lanes[i % MIX_LANES] (interleaved re/im), and every lane is
+// rotated by step (one complex value, MIX_LANES samples of phase advance)
+// after each group. The lanes are not written back: callers reseed them from
+// an exact phase between calls, which also bounds the recursion's error.
+// out may alias iq.
+const int MIX_LANES = 8;
+void mixPhasors(const float* iq, const float* lanes, const float* step, float* out, int n);
+
+// Reduces size bins to columns pixel columns: column x covers bins
+// [x*size/columns, (x+1)*size/columns), at least one. Writes the minimum,
+// maximum and mean of each. Used to draw spectra wider than the screen.
+void columnStats(const float* bins, int size, int columns,
+                 float* minOut, float* maxOut, float* meanOut);
+
+// Name of the instruction set selected at runtime ("avx2", "sse2", "scalar").
+const char* isaName();
+
+} // namespace DspKernels
+
+#endif // DSPKERNELS_H
@@ -0,0 +1,37 @@
+#ifndef DSPTHREAD_H
+#define DSPTHREAD_H
+
+#include <QThread>
+#include <QSemaphore>
+#include <atomic>
+#include <functional>
+
+// Runs the receive-side DSP work off the ingest and GUI threads. The producer
+// calls wake() after pushing samples; the work function then drains whatever
+// is available. A timed wait keeps requestStop() responsive.
+class DspThread : public QThread {
+    Q_OBJECT
+
+public:
+    using WorkFunction = std::function<void()>;
+
+    explicit DspThread(QObject* parent = nullptr);
+    ~DspThread();
+
+    void setWorkFunction(WorkFunction work);
+    void startProcessing(Priority priority = HighPriority);
+    void wake();
+    void requestStop();
+
+protected:
+    void run() override;
+
+private:
+    static const int WAIT_TIMEOUT_MS = 20;
+
+    WorkFunction work_;
+    QSemaphore wakeup_;
+    std::atomic<bool> stopRequested_;
+};
+
+#endif // DSPTHREAD_H
@@ -0,0 +1,73 @@
+#ifndef FFTPLANCACHE_H
+#define FFTPLANCACHE_H
+
+#include <QString>
+#include <fftw3.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// Caches FFTW plans together with their window tables and aligned in-place
+// buffers. Plans are measured once (FFTW_MEASURE or FFTW_PATIENT) and the
+// accumulated wisdom is persisted in the app data directory, so later runs
+// get the measured plans without re-planning.
+//
+// Double-precision plans use an interleaved fftw_complex buffer. Single-
+// precision plans use split real/imaginary arrays (fftwf guru split DFT), so
+// the window/deinterleave and log-magnitude kernels work on plain float
+// vectors. A cached plan owns its buffers; it must only be executed by one
+// thread at a time.
+class FFTPlanCache {
+public:
+    enum class Direction { Forward, Backward };
+    enum class Precision { Double, Single };
+    enum class WindowType { Rectangular, Hann, BlackmanHarris };
+    enum class Effort { Measure, Patient };
+
+    struct Plan {
+        int size;
+        Direction direction;
+        Precision precision;
+        WindowType windowType;
+        std::vector<float> window;
+        float windowGain; // Coherent gain: sum(window) / size
+        fftw_complex* bufferD;
+        float* bufferRe;
+        float* bufferIm;
+        fftw_plan planD;
+        fftwf_plan planF;
+
+        void execute() const;
+    };
+
+    explicit FFTPlanCache(const QString& wisdomDir, Effort effort = Effort::Measure);
+    ~FFTPlanCache();
+
+    FFTPlanCache(const FFTPlanCache&) = delete;
+    FFTPlanCache& operator=(const FFTPlanCache&) = delete;
+
+    // Returns the cached plan for the key, building it on first use.
+    // Returns nullptr if FFTW fails to plan.
+    const Plan* acquire(int size, Direction direction, Precision precision,
+                        WindowType windowType);
+    bool loadWisdom();
+    bool saveWisdom();
+    void clear();
+
+private:
+    using Key = std::tuple<int, Direction, Precision, WindowType>;
+
+    static void buildWindow(WindowType type, int size, std::vector<float>& window);
+    static void destroyPlan(Plan* plan);
+
+    QString wisdomFileD_;
+    QString wisdomFileF_;
+    Effort effort_;
+    std::mutex mutex_;
+    std::map<Key, std::unique_ptr<Plan>> plans_;
+    bool wisdomDirty_;
+};
+
+#endif // FFTPLANCACHE_H
@@ -0,0 +1,46 @@
+#ifndef FILEAUDIOBACKEND_H
+#define FILEAUDIOBACKEND_H
+
+#include <NullAudioBackend.h>
+#include <Resampler.h>
+#include <WavReader.h>
+#include <WavRecorder.h>
+#include <vector>
+
+// NullAudioBackend's clock with WAV files at either end. The output is
+// recorded to Config::outputFile as float32. Config::inputFile is fed in
+// as the input, looped, resampled to the stream rate if need be, with its
+// channels mapped onto the input channels (the last one repeated if it has
+// fewer). Config::speed paces the clock at a multiple of real time; at 0
+// it runs as fast as the callback and the disk allow, which is what soak
+// tests and benchmarks want. The recorder is then allowed to block the
+// clock thread rather than drop output.
+class FileAudioBackend : public NullAudioBackend {
+public:
+    static const int CHUNK_FRAMES = 2048;
+
+    FileAudioBackend();
+    ~FileAudioBackend();
+
+    const char* name() const override;
+
+protected:
+    bool prepare(const Config& config) override;
+    void finish() override;
+    void readInput(float* input, unsigned long frames) override;
+    void writeOutput(const float* output, unsigned long frames) override;
+    double speed() const override;
+
+private:
+    WavReader reader_;
+    WavRecorder recorder_;
+    Resampler resampler_;
+    bool resampling_;
+    std::vector<float> samples_;    // File channels, one chunk
+    std::vector<float> mapped_;     // Input channels at the file rate
+    std::vector<float> pending_;    // Input channels at the stream rate
+    size_t pendingFrames_;
+    size_t pendingRead_;
+};
+
+#endif // FILEAUDIOBACKEND_H
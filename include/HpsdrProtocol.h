@@ -0,0 +1,130 @@
+#ifndef HPSDRPROTOCOL_H
+#define HPSDRPROTOCOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Decoder for the openHPSDR receive streams (Hermes/ANAN and compatibles).
+//
+// Protocol 1 (Metis): 1032-byte packets, "EF FE 01 06", a 32-bit sequence
+// number and two 512-byte USB frames. Each frame starts with the 7F 7F 7F
+// sync, five C&C status bytes, then 504 bytes of samples: for every sample
+// slot, 24-bit big-endian I and Q per receiver followed by 16 bits of mic.
+//
+// Protocol 2: one UDP stream per DDC. Each packet has a 32-bit sequence,
+// a 64-bit timestamp, bits per sample, samples per frame, then 24-bit
+// big-endian I/Q pairs. High-priority status packets come from the radio
+// on their own port (1025) and go to decodeStatus().
+//
+// Raw carries interleaved native float I/Q, as sent by test tools. It is
+// passed through unscaled, so the sender must keep it within +/-1.0.
+//
+// decode() runs on the receive thread and calls the sample handler once per
+// DDC per packet with interleaved float I/Q scaled to +/-1.0. The status
+// accessors may be read from any thread.
+class HpsdrProtocol {
+public:
+    enum class Version { Raw, Protocol1, Protocol2 };
+
+    struct Status {
+        bool ptt = false;
+        bool dot = false;
+        bool dash = false;
+        bool adcOverload = false;
+        int firmwareVersion = 0;
+        int exciterPower = 0;  // Raw ADC counts
+        int forwardPower = 0;
+        int reversePower = 0;
+    };
+
+    // ddc: receiver index; iq: interleaved I/Q floats; count: complex samples.
+    using SampleHandler = std::function<void(int ddc, uint32_t sequence,
+                                             const float* iq, int count)>;
+
+    static constexpr int MAX_DDCS = 8;
+
+    static constexpr int P1_PORT = 1024;
+    static constexpr int P1_PACKET_SIZE = 1032;
+    static constexpr int P1_HEADER_SIZE = 8;
+    static constexpr int P1_FRAME_SIZE = 512;
+    static constexpr int P1_FRAME_HEADER_SIZE = 8;  // Sync + C0..C4
+    static constexpr int P1_COMMAND_SIZE = 64;
+    static constexpr uint8_t P1_ENDPOINT_IQ = 0x06;
+    static constexpr uint8_t P1_ENDPOINT_CONTROL = 0x02;
+
+    static constexpr int P2_HIGH_PRIORITY_FROM_RADIO_PORT = 1025;
+    static constexpr int P2_HIGH_PRIORITY_TO_RADIO_PORT = 1027;
+    static constexpr int P2_DDC_BASE_PORT = 1035;
+    static constexpr int P2_IQ_HEADER_SIZE = 16;
+    static constexpr int P2_IQ_SAMPLES_PER_FRAME = 238;
+    static constexpr int P2_IQ_PACKET_SIZE = P2_IQ_HEADER_SIZE + P2_IQ_SAMPLES_PER_FRAME * 6;
+    static constexpr int P2_STATUS_SIZE = 60;
+    static constexpr int P2_HIGH_PRIORITY_SIZE = 1444;
+
+    explicit HpsdrProtocol(Version version = Version::Raw);
+
+    void setVersion(Version version);
+    Version version() const;
+    // "raw", "p1" or "p2", case-insensitive.
+    static bool versionFromName(const char* name, Version* version);
+    static const char* versionName(Version version);
+    // Protocol 1: receivers interleaved in every frame (1 .. MAX_DDCS).
+    void setReceiverCount(int count);
+    int receiverCount() const;
+    // Protocol 2: DDC carried by this stream (radio sends DDC n to base port + n).
+    void setDdc(int ddc);
+    void setSampleHandler(SampleHandler handler);
+
+    // Returns false and counts the packet as malformed if it cannot be parsed.
+    bool decode(const char* data, int size);
+    // Protocol 2 high-priority status packet. Only updates the status
+    // atomics, so it may run on another thread than decode().
+    bool decodeStatus(const char* data, int size);
+
+    Status status() const;
+    uint32_t lastSequence() const;
+    uint64_t packetsDecoded() const;
+    uint64_t malformedPackets() const;
+    void resetCounters();
+
+    // Packets sent to the radio.
+    static std::vector<char> buildP1StartStop(bool start);
+    // One EP2 packet carrying two C&C frames: general config (sample rate,
+    // receiver count) and the RX1 NCO frequency. Sample payload is silence.
+    static std::vector<char> buildP1Control(uint32_t sequence, int sampleRate,
+                                            int receiverCount, int64_t rxFrequency);
+    // High-priority packet with only the run bit and DDC0 frequency set.
+    static std::vector<char> buildP2HighPriority(uint32_t sequence, bool run,
+                                                 int64_t rxFrequency);
+
+private:
+    bool decodeProtocol1(const uint8_t* data, int size);
+    bool decodeProtocol2(const uint8_t* data, int size);
+    bool decodeRaw(const char* data, int size);
+    void decodeP1Status(const uint8_t* cc);
+    void decodeP2Status(const uint8_t* data);
+    void deliver(int ddc, uint32_t sequence, const float* iq, int count);
+
+    Version version_;
+    int receivers_;
+    int ddc_;
+    SampleHandler handler_;
+
+    // Receive-thread scratch, sized for the largest packet.
+    std::vector<uint8_t> packed_;
+    std::vector<float> converted_;
+    std::vector<float> ddcSamples_;
+
+    std::atomic<uint32_t> lastSequence_;
+    std::atomic<uint32_t> statusBits_;  // PTT, dot, dash, ADC overload
+    std::atomic<int> firmwareVersion_;
+    std::atomic<int> exciterPower_;
+    std::atomic<int> forwardPower_;
+    std::atomic<int> reversePower_;
+    std::atomic<uint64_t> packetsDecoded_;
+    std::atomic<uint64_t> malformedPackets_;
+};
+
+#endif // HPSDRPROTOCOL_H
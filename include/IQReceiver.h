@@ -0,0 +1,59 @@
+#ifndef IQRECEIVER_H
+#define IQRECEIVER_H
+
+#include <QThread>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <sys/socket.h>
+
+// Receives I/Q datagrams on a dedicated thread. Datagrams are pulled in
+// batches with recvmmsg() into a preallocated slab and handed to the
+// datagram handler on this thread, so a busy GUI event loop cannot cause
+// packet loss.
+class IQReceiver : public QThread {
+    Q_OBJECT
+
+public:
+    using DatagramHandler = std::function<void(const char* data, int size)>;
+
+    explicit IQReceiver(QObject* parent = nullptr);
+    ~IQReceiver();
+
+    bool open(const QString& host, int port);
+    void close();
+    void requestStop();
+    // Sends from the bound socket, so replies come back to the receive port.
+    // Safe to call from any thread while the receiver is running.
+    bool sendTo(const char* data, int size, quint32 ipv4Address, int port);
+    void setDatagramHandler(DatagramHandler handler);
+
+    quint64 datagramsReceived() const;
+    quint64 batchesReceived() const;
+    quint64 truncatedDatagrams() const;
+
+signals:
+    void errorOccurred(const QString& error);
+
+protected:
+    void run() override;
+
+private:
+    static const int BATCH_SIZE = 32;
+    static const int MAX_DATAGRAM_SIZE = 65536;
+    static const int SOCKET_RCVBUF = 4 * 1024 * 1024;
+    static const int POLL_TIMEOUT_MS = 50;
+
+    int socket_;
+    DatagramHandler handler_;
+    std::atomic<bool> stopRequested_;
+    std::vector<char> slab_;
+    std::vector<struct mmsghdr> messages_;
+    std::vector<struct iovec> iovecs_;
+    std::atomic<quint64> datagramsReceived_;
+    std::atomic<quint64> batchesReceived_;
+    std::atomic<quint64> truncatedDatagrams_;
+};
+
+#endif // IQRECEIVER_H
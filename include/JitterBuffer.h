@@ -0,0 +1,84 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Per-stream reorder buffer for sequenced I/Q packets. Packets that arrive
+// in order pass straight through; when a sequence number is skipped, later
+// packets are held for up to depth packets waiting for the missing one.
+// If it does not turn up, its samples are replaced by zeros (of the last
+// seen packet length) so the sample timeline stays continuous, and the held
+// packets are released in order. Packets arriving after their slot was
+// released are dropped and counted as late.
+//
+// push() and flush() run on the receive thread, or on the owner's thread
+// once the receive thread has stopped; stats() may be called from any
+// thread.
+class JitterBuffer {
+public:
+    // iq == nullptr means "count zero samples".
+    using OutputHandler = std::function<void(const float* iq, int count)>;
+
+    struct Stats {
+        uint64_t received = 0;
+        uint64_t lost = 0;        // Packets replaced by zeros
+        uint64_t reordered = 0;   // Arrived after a higher sequence number
+        uint64_t late = 0;        // Arrived after being given up on, or already released
+        uint64_t duplicates = 0;  // Same sequence held twice
+        uint64_t resyncs = 0;     // Sequence jumped too far; buffer restarted
+        uint64_t zeroSamples = 0; // Samples inserted for lost packets
+    };
+
+    static const int MAX_DEPTH = 64;
+    static const int RESYNC_THRESHOLD = 4096; // Packets
+
+    // depth: packets held while waiting for a gap to fill (1 = no reordering),
+    // rounded up to a power of two.
+    // maxSamples: largest packet in complex samples; larger ones grow the slots.
+    JitterBuffer(int depth, int maxSamples);
+
+    void setDepth(int depth);
+    int depth() const;
+    void setOutputHandler(OutputHandler handler);
+
+    void push(uint32_t sequence, const float* iq, int count);
+    // Releases everything held, zero-filling gaps, and forgets the sequence.
+    void flush();
+    void reset();
+
+    Stats stats() const;
+
+private:
+    struct Slot {
+        uint32_t sequence;
+        int count;
+        bool valid;
+        std::vector<float> samples;
+    };
+
+    void releaseNext();
+    void output(const float* iq, int count);
+
+    int depth_;
+    int maxSamples_;
+    OutputHandler handler_;
+    std::vector<Slot> slots_;
+    bool started_;
+    uint32_t expected_;
+    uint32_t highest_;
+    int held_;
+    int lastCount_;
+
+    std::atomic<uint64_t> received_;
+    std::atomic<uint64_t> lost_;
+    std::atomic<uint64_t> reordered_;
+    std::atomic<uint64_t> late_;
+    std::atomic<uint64_t> duplicates_;
+    std::atomic<uint64_t> resyncs_;
+    std::atomic<uint64_t> zeroSamples_;
+};
+
+#endif // JITTERBUFFER_H
@@ -0,0 +1,64 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// HDR-style histogram of non-negative integer values (nanoseconds, in
+// practice). Values below SUB_BUCKETS are counted exactly; above that each
+// power of two is split into SUB_BUCKETS linear buckets, so every recorded
+// value is resolved to within 1/SUB_BUCKETS (about 3%) up to MAX_VALUE,
+// and larger values land in the top bucket. The whole range fits in a
+// fixed array of counters.
+//
+// record() is wait-free and allocation-free, for one writer at a time (the
+// real-time thread). snapshot() may be called from any thread while it
+// runs; the copy is not atomic as a whole, but every counter in it is.
+// There is no reset: readers that want an interval keep the previous
+// snapshot and take the difference with since().
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 40;                // ~1100 s in ns
+    static const uint64_t MAX_VALUE = (uint64_t(1) << (MAX_EXPONENT + 1)) - 1;
+    static const int BUCKETS = SUB_BUCKETS * (MAX_EXPONENT - SUB_BUCKET_BITS + 2);
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;   // BUCKETS entries
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = 0;               // Exact over the lifetime; bucket
+        uint64_t max = 0;               // bounds after since()
+
+        // Smallest bucket bound with at least fraction (0..1) of the values
+        // at or below it; 0 when empty.
+        uint64_t percentile(double fraction) const;
+        double mean() const;
+        // What was recorded between earlier and this snapshot.
+        Snapshot since(const Snapshot& earlier) const;
+    };
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t value);
+    Snapshot snapshot() const;
+
+    static int bucketFor(uint64_t value);
+    // Largest value that lands in bucket.
+    static uint64_t bucketUpperBound(int bucket);
+    static uint64_t bucketLowerBound(int bucket);
+
+private:
+    std::atomic<uint64_t> counts_[BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,143 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QDebug>
+#include <QLoggingCategory>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+class QObject;
+
+// Logging categories for the hot paths. Enable or silence them at runtime
+// with QT_LOGGING_RULES, e.g. "thetis.network.debug=false".
+Q_DECLARE_LOGGING_CATEGORY(lcNetwork)
+Q_DECLARE_LOGGING_CATEGORY(lcDsp)
+Q_DECLARE_LOGGING_CATEGORY(lcDisplay)
+Q_DECLARE_LOGGING_CATEGORY(lcAudio)
+
+// Compile-time floor: messages below THETIS_LOG_LEVEL are removed entirely.
+// 0 = debug, 1 = info, 2 = warning, 3 = critical. Set via the Makefile
+// (make LOG_LEVEL=2).
+#ifndef THETIS_LOG_LEVEL
+#define THETIS_LOG_LEVEL 0
+#endif
+
+#define THETIS_LOG_DISABLED() while (false) QMessageLogger().noDebug()
+
+#if THETIS_LOG_LEVEL <= 0
+#define THETIS_DEBUG(category) qCDebug(category)
+#else
+#define THETIS_DEBUG(category) THETIS_LOG_DISABLED()
+#endif
+
+#if THETIS_LOG_LEVEL <= 1
+#define THETIS_INFO(category) qCInfo(category)
+#else
+#define THETIS_INFO(category) THETIS_LOG_DISABLED()
+#endif
+
+#if THETIS_LOG_LEVEL <= 2
+#define THETIS_WARNING(category) qCWarning(category)
+#else
+#define THETIS_WARNING(category) THETIS_LOG_DISABLED()
+#endif
+
+// Rate-limited and sampled variants for per-packet/per-frame sites. Each
+// call site keeps its own limiter.
+#if THETIS_LOG_LEVEL <= 0
+#define THETIS_DEBUG_EVERY_MS(category, intervalMs) \
+    if (static Logging::RateLimiter thetisLimiter_(intervalMs); !thetisLimiter_.allow()) {} \
+    else qCDebug(category)
+#define THETIS_DEBUG_EVERY_N(category, n) \
+    if (static Logging::Sampler thetisSampler_(n); !thetisSampler_.allow()) {} \
+    else qCDebug(category)
+#else
+#define THETIS_DEBUG_EVERY_MS(category, intervalMs) THETIS_LOG_DISABLED()
+#define THETIS_DEBUG_EVERY_N(category, n) THETIS_LOG_DISABLED()
+#endif
+
+#if THETIS_LOG_LEVEL <= 2
+#define THETIS_WARNING_EVERY_MS(category, intervalMs) \
+    if (static Logging::RateLimiter thetisLimiter_(intervalMs); !thetisLimiter_.allow()) {} \
+    else qCWarning(category)
+#else
+#define THETIS_WARNING_EVERY_MS(category, intervalMs) THETIS_LOG_DISABLED()
+#endif
+
+// Records an event in the in-memory trace ring. Compiled out with
+// THETIS_TRACE_ENABLED=0.
+#ifndef THETIS_TRACE_ENABLED
+#define THETIS_TRACE_ENABLED 1
+#endif
+
+#if THETIS_TRACE_ENABLED
+#define THETIS_TRACE(event, a, b) Logging::trace().record(event, a, b)
+#else
+#define THETIS_TRACE(event, a, b) do {} while (false)
+#endif
+
+namespace Logging {
+
+int64_t monotonicNs();
+
+// Lets one message through per interval; lock-free.
+class RateLimiter {
+public:
+    explicit RateLimiter(int intervalMs);
+    bool allow();
+    uint64_t suppressed() const;
+
+private:
+    int64_t intervalNs_;
+    std::atomic<int64_t> next_;
+    std::atomic<uint64_t> suppressed_;
+};
+
+// Lets every n-th message through; lock-free.
+class Sampler {
+public:
+    explicit Sampler(int n);
+    bool allow();
+
+private:
+    uint32_t n_;
+    std::atomic<uint32_t> count_;
+};
+
+// Fixed-size, lock-free, multi-producer trace ring. record() is wait-free
+// and never allocates; event must be a string literal. Old entries are
+// overwritten. dump() takes a consistent snapshot of the entries written
+// so far.
+class TraceRing {
+public:
+    static const int CAPACITY = 8192; // Power of two
+
+    TraceRing();
+    void record(const char* event, int64_t a, int64_t b);
+    QString dump() const;
+    bool dumpToFile(const QString& path) const;
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> seq; // 2*index+1 while writing, 2*index+2 when done
+        std::atomic<int64_t> timestampNs;
+        std::atomic<const char*> event;
+        std::atomic<int64_t> a;
+        std::atomic<int64_t> b;
+    };
+
+    std::atomic<uint64_t> head_;
+    Entry entries_[CAPACITY];
+};
+
+TraceRing& trace();
+
+// Dumps the trace ring to <dir>/trace-<time>.txt whenever the process gets
+// SIGUSR1. The signal handler only sets a flag; a timer on parent's thread
+// does the file I/O.
+void installTraceDumpOnSignal(QObject* parent, const QString& dir);
+
+} // namespace Logging
+
+#endif // LOGGING_H
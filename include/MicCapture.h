@@ -0,0 +1,72 @@
+#ifndef MICCAPTURE_H
+#define MICCAPTURE_H
+
+#include <RingBuffer.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Microphone samples from the audio stream's input, for transmit and
+// monitoring. The audio callback write()s each input buffer; one channel
+// of it goes into a preallocated lock-free ring, mono at the stream rate,
+// and a Stamp for the buffer goes into a second ring alongside.
+//
+// A stamp ties a sample to the output stream: outputFrame is the output
+// frame that was leaving the DAC at the moment the sample reached the ADC,
+// from the host's input ADC and output DAC timestamps. Output frames count
+// from the start of the stream, so a consumer can line mic audio up with
+// what it played (sidetone, echo estimates) or schedule transmit audio
+// against it. read() hands out the stamp of the first sample it returns,
+// extrapolated from the nearest stamp at the stream rate.
+//
+// One producer (the callback) and one consumer. write() never blocks or
+// allocates; samples that do not fit are dropped and counted.
+class MicCapture {
+public:
+    static const int CAPACITY_MS = 500;
+    static const int WINDOW = 4096;             // Largest contiguous peek()
+    static const int STAMP_CAPACITY = 1024;     // Buffers' worth of stamps
+
+    struct Stamp {
+        uint64_t sample = 0;        // Sequence number: samples queued before this one
+        int64_t outputFrame = 0;    // Output frame at the DAC when it was captured
+        double adcTime = 0.0;       // Backend stream time of the capture, s; 0 if unknown
+    };
+
+    MicCapture();
+
+    MicCapture(const MicCapture&) = delete;
+    MicCapture& operator=(const MicCapture&) = delete;
+
+    // Control thread, while the stream is stopped. channel picks the input
+    // channel the mic is on (the last one if the input has fewer).
+    bool configure(int sampleRate, int channel = 0);
+    // Control thread: empties both rings. Only while neither side is active.
+    void reset();
+    bool isConfigured() const;
+    int sampleRate() const;
+
+    // Real-time producer. input: frames x channels interleaved.
+    void write(const float* input, int channels, unsigned long frames, int64_t outputFrame,
+               double adcTime);
+
+    // Consumer.
+    size_t available() const;
+    // Reads up to frames samples into dest and returns how many; stamp, if
+    // given, receives the timing of dest[0].
+    size_t read(float* dest, size_t frames, Stamp* stamp = nullptr);
+
+    uint64_t droppedSamples() const;
+
+private:
+    int sampleRate_;
+    int channel_;
+    std::unique_ptr<AudioRingBuffer> ring_;
+    RingBuffer<Stamp> stamps_;
+    uint64_t written_;              // Producer only
+    uint64_t consumed_;             // Consumer only
+    Stamp current_;                 // Consumer only: newest stamp at or before consumed_
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif // MICCAPTURE_H
@@ -0,0 +1,51 @@
+#ifndef NCO_H
+#define NCO_H
+
+#include <DspKernels.h>
+#include <atomic>
+
+// Numerically controlled oscillator and complex mixer: mix() multiplies the
+// I/Q stream by exp(j*2*pi*f*t). A negative frequency moves a signal at +f
+// down to DC.
+//
+// The phase is kept in double precision and carried across calls, so the
+// output is phase-continuous through retuning. Within a call the oscillator
+// runs as DspKernels::MIX_LANES recursive phasors; they are reseeded from the
+// exact phase every RESEED_INTERVAL samples. In between, float rounding in
+// the recursion lets the phasor drift, mostly in amplitude: measured worst
+// case 2.2e-5 of the signal (-93 dBc) at 48 and 192 kHz, the same for every
+// kernel. That is well above 24-bit quantisation (-144 dBFS); a shorter
+// RESEED_INTERVAL trades seed cost for a tighter bound.
+//
+// setFrequency() may be called from any thread and takes effect at the start
+// of the next mix() call. Everything else belongs to the DSP thread.
+class Nco {
+public:
+    static const int RESEED_INTERVAL = 4096; // Samples
+
+    Nco();
+
+    void setSampleRate(double rate);
+    double sampleRate() const;
+    void setFrequency(double hz);
+    double frequency() const;
+    // Phase back to zero.
+    void reset();
+
+    // iq: count interleaved complex samples; out may be the same buffer.
+    void mix(const float* iq, float* out, int count);
+
+private:
+    void applyFrequency();
+    void seed();
+
+    double sampleRate_;
+    std::atomic<double> pendingFrequency_;
+    double frequency_;
+    double omega_; // Radians per sample
+    double phase_; // Radians, wrapped to [-pi, pi]
+    float lanes_[2 * DspKernels::MIX_LANES];
+    float step_[2];
+};
+
+#endif // NCO_H
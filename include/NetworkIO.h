@@ -3,44 +3,127 @@
 
 #include <QObject>
 #include <QUdpSocket>
+#include <Decimator.h>
+#include <FFTPlanCache.h>
+#include <HpsdrProtocol.h>
+#include <JitterBuffer.h>
+#include <Nco.h>
+#include <RingBuffer.h>
+#include <SpectrumFrame.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
 
 class Console;
+class QHostInfo;
+class IQReceiver;
+class DspThread;
+class SpectrumEngine;
 
 class NetworkIO : public QObject {
     Q_OBJECT
 
 public:
+    // EventLoop reads datagrams on the owning (GUI) thread via QUdpSocket;
+    // Thread uses IQReceiver's dedicated recvmmsg thread.
+    enum class IngestMode { EventLoop, Thread };
+    // Decimated receive channel: interleaved I/Q at getChannelRate(), on the DSP thread.
+    using BasebandHandler = std::function<void(const float* iq, int count)>;
+
     explicit NetworkIO(Console* console, QObject* parent = nullptr);
     ~NetworkIO();
 
     void setHost(const QString& host, int port);
     void setFrequency(double freq);
+    // Absolute frequency the receive channel is tuned to. The mixer shifts
+    // its offset from the span centre (setFrequency) down to DC.
+    void setRxFrequency(double freq);
+    double getRxFrequency() const;
     void setGain(double gain);
+    void setIngestMode(IngestMode mode);
+    IngestMode getIngestMode() const;
+    // Wire format of the radio, Raw float I/Q by default. Protocol 1 binds
+    // port and talks to the radio on host:1024; Protocol 2 needs port to
+    // be the DDC's I/Q port (1035+n) and start() refuses any other.
+    void setProtocol(HpsdrProtocol::Version version);
+    HpsdrProtocol::Version getProtocol() const;
+    void setReceiverCount(int count);
+    // Packets each DDC may hold back to reorder (1 = none).
+    void setJitterDepth(int packets);
+    JitterBuffer::Stats getJitterStats(int ddc = 0) const;
+    // Receive channel rate: 48000, 24000 or 12000. Takes effect on start().
+    bool setChannelRate(int rate);
+    int getChannelRate() const;
+    // Decimator latency in seconds, for stages that need to line up with the spectrum.
+    double getChannelGroupDelay() const;
+    void setBasebandHandler(BasebandHandler handler);
+    HpsdrProtocol::Status getRadioStatus() const;
+    quint64 getMalformedPackets() const;
+    SpectrumEngine* getSpectrumEngine() const;
+    quint64 getIQOverruns() const;
+    quint64 getIQDroppedSamples() const;
+    quint64 getDroppedSpectrumFrames() const;
 
 public slots:
     void start();
     void stop();
 
 signals:
-    void spectrumDataAvailable(const float* data, int size);
+    void spectrumFrameAvailable(const SpectrumFrameRef& frame);
     void errorOccurred(const QString& error);
 
 private slots:
     void processPendingDatagrams();
-    void processIQData(const QByteArray& data);
+    void processStatusDatagrams();
 
 private:
     Console* console_;
     QUdpSocket* udpSocket_;
+    QUdpSocket* statusSocket_; // Protocol 2 high-priority status from the radio
+    IQReceiver* receiver_;
+    DspThread* dspThread_;
+    IngestMode ingestMode_;
     QString host_;
     int port_;
-    double frequency_;
-    double gain_;
-    std::vector<float> iqBuffer_;
-    static const int BUFFER_SIZE = 8192;
-    static const int FFT_SIZE = 1024;
+    std::atomic<double> frequency_;
+    std::atomic<double> rxFrequency_;
+    QByteArray datagram_;
+    static const int IQ_RING_CAPACITY = 1 << 20; // Complex samples
+    IQRingBuffer iqRing_;
+    std::unique_ptr<FFTPlanCache> fftCache_;
+    std::unique_ptr<SpectrumEngine> spectrumEngine_;
+    std::shared_ptr<SpectrumFramePool> framePool_;
+    static const int FRAME_POOL_SIZE = 16;
     bool running_;
-    void computeSpectrum(const float* iqData, int size);
+    QHostAddress radioAddress_;
+    std::unique_ptr<HpsdrProtocol> protocol_;
+    quint32 controlSequence_;
+    int hostLookupId_; // Pending QHostInfo lookup, -1 if none
+    static const int DEFAULT_JITTER_DEPTH = 4;
+    std::vector<std::unique_ptr<JitterBuffer>> jitterBuffers_;
+    static const int CHANNEL_BLOCK = 4096; // Input samples per decimator call
+    int channelRate_;
+    Nco nco_;
+    std::unique_ptr<Decimator> decimator_;
+    uint64_t reportedClips_; // Decimator clips already warned about
+    std::vector<float> mixed_;
+    std::vector<float> baseband_;
+    // The channel and the spectrum read the ring from their own positions.
+    // The ring's read position is the spectrum's; the channel runs
+    // channelOffset_ samples ahead of it and is never held back by it.
+    size_t channelOffset_;
+    static const int MAX_SPECTRUM_BACKLOG = IQ_RING_CAPACITY / 4; // Samples the spectrum may lag
+    BasebandHandler basebandHandler_;
+    void processIQData(const char* data, int size);
+    void processSamples(int ddc, const float* iq, int count);
+    void sendToRadio(const std::vector<char>& packet, int port);
+    void sendRadioControl(bool run);
+    void hostResolved(const QHostInfo& info);
+    void processRing();
+    void processChannel();
+    void updateRxOffset();
+    void publishSpectrum(const float* bins, const float* peak, int size);
 };
 
 #endif // NETWORKIO_H
@@ -0,0 +1,61 @@
+#ifndef NULLAUDIOBACKEND_H
+#define NULLAUDIOBACKEND_H
+
+#include <AudioBackend.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A stream with no device behind it. A clock thread calls the callback
+// once per buffer period, sleeping to absolute deadlines on the monotonic
+// clock so the rate does not drift however long the callback takes. Input
+// is silence and output is discarded. A wake-up more than a period late is
+// reported as an output underflow, and the clock restarts from there
+// instead of bursting to catch up.
+//
+// Stream time counts frames: it is frames processed / sample rate.
+// FileAudioBackend reuses the clock through the protected hooks.
+class NullAudioBackend : public AudioBackend {
+public:
+    NullAudioBackend();
+    ~NullAudioBackend();
+
+    const char* name() const override;
+    bool open(const Config& config, Callback callback) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+    bool isOpen() const override;
+    bool isRunning() const override;
+    double streamTime() const override;
+
+    uint64_t framesProcessed() const;
+
+protected:
+    // Called from open() and close(), on the control thread.
+    virtual bool prepare(const Config& config);
+    virtual void finish();
+    // Called on the clock thread around each callback.
+    virtual void readInput(float* input, unsigned long frames);
+    virtual void writeOutput(const float* output, unsigned long frames);
+    // Multiple of real time to run at; 0 runs unpaced.
+    virtual double speed() const;
+
+    Config config_;
+
+private:
+    class ClockThread;
+
+    void run();
+
+    Callback callback_;
+    std::unique_ptr<ClockThread> thread_;
+    std::vector<float> input_;
+    std::vector<float> output_;
+    bool open_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> frames_;
+};
+
+#endif // NULLAUDIOBACKEND_H
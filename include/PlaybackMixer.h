@@ -0,0 +1,94 @@
+#ifndef PLAYBACKMIXER_H
+#define PLAYBACKMIXER_H
+
+#include <PlaybackSource.h>
+#include <RingBuffer.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Mixes up to MAX_STREAMS independent playback streams (voice keyer
+// messages, CW memories, test tones) into the stereo output. Each stream is
+// a PlaybackSource with its own gain, loop flag and start time, and is
+// addressed by the caller's playback id.
+//
+// Every stream slot has a preallocated ring. The disk thread calls
+// service() to refill the rings from the sources; the audio callback calls
+// mix(), which only reads the rings and accumulates them with a SIMD kernel.
+// Slots move through Free -> Loading -> Queued -> Playing -> Stopping ->
+// Free on an atomic state, so start(), stop() and setGain() never lock,
+// wait or touch the disk:
+//
+//   Loading   claimed by the control thread, which hands over the source.
+//   Queued    the disk thread primes the ring, then marks it Playing.
+//   Playing   disk thread produces, callback consumes.
+//   Stopping  skipped by the callback; the disk thread waits for any
+//             callback in flight, then frees the source and the slot.
+class PlaybackMixer {
+public:
+    struct Options {
+        float gain = 1.0f;
+        bool loop = false;
+        uint64_t startFrame = 0;   // Mixer time (see now()) to start at; 0 = at once
+    };
+
+    static const int MAX_STREAMS = 8;
+    static const int RING_CAPACITY = 1 << 15;   // Stereo samples per stream, ~0.34 s at 48 kHz
+    static const int RING_WINDOW = 4096;
+    static const int FILL_FRAMES = 2048;        // Frames per source read
+
+    PlaybackMixer();
+    ~PlaybackMixer();
+
+    PlaybackMixer(const PlaybackMixer&) = delete;
+    PlaybackMixer& operator=(const PlaybackMixer&) = delete;
+
+    // Control thread. Stops any stream already playing under id, then
+    // queues source; it starts at the disk thread's next pass. Returns false
+    // if every slot is busy.
+    bool start(int id, std::unique_ptr<PlaybackSource> source, const Options& options);
+    // Returns false if no stream is playing under id.
+    bool stop(int id);
+    void stopAll();
+    bool setGain(int id, float gain);
+    bool isPlaying(int id) const;
+    int activeStreams() const;
+
+    // Frames mixed so far; the time base for Options::startFrame.
+    uint64_t now() const;
+    // Callbacks in which a stream ran short before the end of its source.
+    uint64_t underruns() const;
+
+    // Disk thread: refills rings and retires finished or stopped streams.
+    void service();
+
+    // Audio callback: out += sum of streams * their gain * masterGain, for
+    // frames interleaved stereo frames.
+    void mix(float* out, size_t frames, float masterGain);
+
+private:
+    enum State { Free, Loading, Queued, Playing, Stopping };
+
+    struct Stream {
+        Stream() : ring(RING_CAPACITY, RING_WINDOW) {}
+        AudioRingBuffer ring;
+        std::unique_ptr<PlaybackSource> source;   // Loading: control; later: disk thread
+        std::atomic<int> state{Free};
+        std::atomic<float> gain{1.0f};
+        std::atomic<bool> ended{false};          // Source exhausted, ring draining
+        uint64_t startFrame = 0;
+        bool loop = false;
+        int id = -1;                             // Control thread only
+    };
+
+    void fill(Stream& stream);
+    void retire(Stream& stream);
+
+    std::unique_ptr<Stream[]> streams_;
+    std::unique_ptr<float[]> scratch_;           // Disk thread
+    std::atomic<bool> inCallback_;
+    std::atomic<uint64_t> clock_;
+    std::atomic<uint64_t> underruns_;
+};
+
+#endif // PLAYBACKMIXER_H
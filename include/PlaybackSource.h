@@ -0,0 +1,72 @@
+#ifndef PLAYBACKSOURCE_H
+#define PLAYBACKSOURCE_H
+
+#include <QString>
+#include <Resampler.h>
+#include <WavReader.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A stream the PlaybackMixer can play: produces interleaved stereo frames at
+// the output rate. Sources are only ever called from the mixer's disk
+// thread (and from the control thread before they are handed over), so they
+// may block, fault pages in or allocate.
+class PlaybackSource {
+public:
+    virtual ~PlaybackSource() = default;
+
+    // Writes up to frames stereo frames. Returns fewer only at the end.
+    virtual size_t read(float* stereo, size_t frames) = 0;
+    // Back to the first frame, for looping. Returns false if not possible.
+    virtual bool rewind() = 0;
+};
+
+// A WAV file through WavReader. Mono is copied to both channels; channels
+// past the second are ignored. A file at another rate than the output is
+// converted by a Resampler as it is read.
+class WavPlaybackSource : public PlaybackSource {
+public:
+    static const int CHUNK_FRAMES = 2048;
+
+    WavPlaybackSource();
+
+    // Returns false, with the reason logged, if the file cannot be played.
+    bool open(const QString& path, int outputRate,
+              Resampler::Quality quality = Resampler::Quality::High);
+    const WavReader::Format& format() const;
+
+    size_t read(float* stereo, size_t frames) override;
+    bool rewind() override;
+
+private:
+    size_t readStereo(float* stereo, size_t frames);
+
+    WavReader reader_;
+    Resampler resampler_;
+    bool resampling_;
+    bool flushed_;                   // Resampler tail pushed out at the end
+    std::vector<float> samples_;     // File channels, one chunk
+    std::vector<float> stereo_;      // Stereo at the file rate, one chunk
+    std::vector<float> pending_;     // Resampled, not yet read
+    size_t pendingFrames_;
+    size_t pendingRead_;
+};
+
+// A sine test tone, or a fixed-length beep when frames is non-zero.
+class TonePlaybackSource : public PlaybackSource {
+public:
+    TonePlaybackSource(double frequency, double amplitude, int sampleRate, uint64_t frames = 0);
+
+    size_t read(float* stereo, size_t frames) override;
+    bool rewind() override;
+
+private:
+    double phase_;
+    double step_;
+    float amplitude_;
+    uint64_t length_;     // 0 = endless
+    uint64_t position_;
+};
+
+#endif // PLAYBACKSOURCE_H
@@ -0,0 +1,42 @@
+#ifndef PORTAUDIOBACKEND_H
+#define PORTAUDIOBACKEND_H
+
+#include <AudioBackend.h>
+#include <portaudio.h>
+
+// A PortAudio stream on a sound card. The output device is the first one
+// whose name contains Config::outputDevice and that has enough channels,
+// otherwise the default output device. With Config::inputChannels > 0 the
+// stream is full duplex, the input device picked the same way from
+// Config::inputDevice, so capture and playback share one clock and one
+// callback. PortAudio can only pair devices on the same host API; if the
+// pair will not open together the stream falls back to output only and
+// the callback gets no input. Config::outputLatency and inputLatency are
+// passed as the suggested latencies; 0 asks for the device's low default.
+class PortAudioBackend : public AudioBackend {
+public:
+    PortAudioBackend();
+    ~PortAudioBackend();
+
+    const char* name() const override;
+    bool open(const Config& config, Callback callback) override;
+    bool start() override;
+    void stop() override;
+    void close() override;
+    bool isOpen() const override;
+    bool isRunning() const override;
+    double streamTime() const override;
+
+private:
+    static int streamCallback(const void* input, void* output, unsigned long frameCount,
+                              const PaStreamCallbackTimeInfo* timeInfo,
+                              PaStreamCallbackFlags statusFlags, void* userData);
+    PaDeviceIndex findDevice(const QString& name, int channels, bool input) const;
+
+    Callback callback_;
+    PaStream* stream_;
+    bool initialized_;              // Pa_Initialize() succeeded
+    bool running_;
+};
+
+#endif // PORTAUDIOBACKEND_H
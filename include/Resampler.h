@@ -0,0 +1,111 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+
+// Arbitrary-ratio sample-rate converter for interleaved multichannel audio,
+// built on a Kaiser-windowed sinc. The prototype low-pass is tabulated at
+// phases() sub-sample offsets; each output sample is the dot product of the
+// input history with the two tabulated phases either side of its exact
+// fractional position, linearly interpolated. Any pair of rates works,
+// including ones with no small common factor (44.1k <-> 48k), and the
+// fractional position is kept in double precision so long runs do not drift.
+//
+// The cutoff sits in the transition band below the lower of the two
+// Nyquist frequencies, so downsampling is also anti-aliased. Quality picks
+// the passband width, stopband attenuation and table resolution:
+//
+//   Quality  Passband   Stopband  Taps at 1:1  Phases
+//   Fast     0.80 Nyq    60 dB        40         64
+//   Medium   0.88 Nyq    80 dB        88        128
+//   High     0.92 Nyq   100 dB       168        256
+//   Best     0.95 Nyq   120 dB       328       1024
+//
+// setRatioAdjust() trims the conversion ratio by a few parts per million
+// on the fly, without redesigning the filter, so a control loop can track
+// the drift between two free-running clocks (see DriftController).
+//
+// Downsampling narrows the filter, so the tap count grows by the ratio
+// while the phase count shrinks by it; cost per input sample stays roughly
+// constant. Past MAX_TAPS (only extreme ratios: 384k -> 8k at Best wants
+// about 15k taps) the filter is truncated. It keeps its stopband but its
+// transition band widens, so the passband edge droops; wantedTaps() then
+// exceeds taps(), and the callers log it. `make bench` builds
+// resamplerbench, which measures ripple, worst-case image/alias level and
+// CPU cost per quality and rate pair.
+//
+// The dot products run through DspKernels::dualDotProduct, two channels
+// per pass. Tables are designed once per quality and ratio and shared
+// between instances. Not thread-safe; process() allocates nothing, so it is
+// safe on a real-time thread once configure() has returned.
+class Resampler {
+public:
+    enum class Quality { Fast, Medium, High, Best };
+
+    static const int MAX_CHANNELS = 32;
+    static const int MAX_TAPS = 8192;
+    static constexpr double MAX_RATIO_ADJUST_PPM = 10000.0;
+
+    Resampler();
+    ~Resampler();
+
+    // Returns false (and keeps the previous setup) for non-positive rates or
+    // a channel count outside 1..MAX_CHANNELS.
+    bool configure(int inputRate, int outputRate, int channels, Quality quality = Quality::High);
+    bool isConfigured() const;
+    // Clears the history, as if the stream had just started.
+    void reset();
+
+    int inputRate() const;
+    int outputRate() const;
+    int channels() const;
+    Quality quality() const;
+    int taps() const;
+    int phases() const;
+    // Taps the quality needed at this ratio, before the MAX_TAPS cap.
+    int wantedTaps() const;
+    // Filter delay: input frames still held back after the last process().
+    int latencyFrames() const;
+
+    // Consumes input ppm parts per million faster than the nominal ratio
+    // (negative: slower), clamped to +-MAX_RATIO_ADJUST_PPM. Takes effect
+    // from the next output frame; safe between process() calls on the
+    // real-time thread. configure() resets it to 0.
+    void setRatioAdjust(double ppm);
+    double ratioAdjust() const;
+
+    // Upper bound on frames produced by process() for frames input frames,
+    // whatever the ratio adjustment.
+    size_t maxOutput(size_t frames) const;
+
+    // in: frames interleaved input frames. out: at least maxOutput(frames)
+    // frames. Returns frames written.
+    size_t process(const float* in, size_t frames, float* out);
+    // Pushes latencyFrames() frames of silence so the end of the signal
+    // comes out. out must hold maxOutput(latencyFrames()) frames.
+    size_t flush(float* out);
+
+    static const char* qualityName(Quality quality);
+
+    struct Design;
+
+private:
+    void push(const float* frame);
+    void interpolate(float* out);
+
+    const Design* design_;
+    int inputRate_;
+    int outputRate_;
+    int channels_;
+    Quality quality_;
+    double nominalStep_;            // inputRate / outputRate
+    double adjustPpm_;
+    double step_;                   // Input frames per output frame, adjusted
+    double time_;                   // Next output, in input frames past the window centre
+    int index_;                     // Newest sample in each history
+    std::vector<float> history_;    // Per channel, doubled so the window is contiguous
+    std::vector<float> silence_;    // One zero frame, for flush()
+};
+
+#endif // RESAMPLER_H
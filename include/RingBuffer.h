@@ -0,0 +1,159 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Fixed-capacity lock-free single-producer/single-consumer ring.
+//
+// The first maxWindow slots are mirrored past the end of storage, so the
+// consumer can peek() any window of up to maxWindow items as one contiguous
+// block, even across the wrap point, without copying. Writes that do not fit
+// are truncated and counted as overruns; the producer never blocks.
+template <typename T>
+class RingBuffer {
+public:
+    static constexpr size_t CACHE_LINE = 64;
+
+    explicit RingBuffer(size_t capacity, size_t maxWindow = 0)
+        : capacity_(roundUpPow2(capacity)),
+          mask_(capacity_ - 1),
+          window_(maxWindow < capacity_ ? maxWindow : capacity_),
+          storage_(new T[capacity_ + window_]()),
+          head_(0),
+          tail_(0),
+          overruns_(0),
+          droppedItems_(0),
+          underruns_(0) {}
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    size_t capacity() const { return capacity_; }
+    size_t maxWindow() const { return window_; }
+
+    // Producer side.
+    size_t space() const {
+        return capacity_ - (head_.load(std::memory_order_relaxed) -
+                            tail_.load(std::memory_order_acquire));
+    }
+
+    size_t write(const T* data, size_t count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t free = capacity_ - (head - tail_.load(std::memory_order_acquire));
+        size_t n = count;
+        if (n > free) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            droppedItems_.fetch_add(count - free, std::memory_order_relaxed);
+            n = free;
+        }
+        size_t pos = head & mask_;
+        size_t first = n < capacity_ - pos ? n : capacity_ - pos;
+        copyIn(pos, data, first);
+        copyIn(0, data + first, n - first);
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Writes count default-constructed items (zeros for arithmetic types).
+    size_t writeZeros(size_t count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t free = capacity_ - (head - tail_.load(std::memory_order_acquire));
+        size_t n = count;
+        if (n > free) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            droppedItems_.fetch_add(count - free, std::memory_order_relaxed);
+            n = free;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            size_t pos = (head + i) & mask_;
+            storage_[pos] = T();
+            if (pos < window_) storage_[capacity_ + pos] = T();
+        }
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side.
+    size_t available() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+
+    // Returns a contiguous view of count items starting offset items past the
+    // read position, or nullptr if they are not all available or the window
+    // would not be contiguous (count > maxWindow across the wrap point).
+    const T* peek(size_t count, size_t offset = 0) const {
+        if (offset + count > available()) return nullptr;
+        size_t pos = (tail_.load(std::memory_order_relaxed) + offset) & mask_;
+        if (pos + count > capacity_ + window_) return nullptr;
+        return storage_.get() + pos;
+    }
+
+    size_t read(T* dest, size_t count) {
+        size_t avail = available();
+        size_t n = count;
+        if (n > avail) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+            n = avail;
+        }
+        size_t pos = tail_.load(std::memory_order_relaxed) & mask_;
+        size_t first = n < capacity_ - pos ? n : capacity_ - pos;
+        std::copy(storage_.get() + pos, storage_.get() + pos + first, dest);
+        std::copy(storage_.get(), storage_.get() + (n - first), dest + first);
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        return n;
+    }
+
+    void consume(size_t count) {
+        size_t avail = available();
+        if (count > avail) count = avail;
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Only safe while neither side is active.
+    void reset() {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+    uint64_t droppedItems() const { return droppedItems_.load(std::memory_order_relaxed); }
+    uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+private:
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    void copyIn(size_t pos, const T* data, size_t count) {
+        if (count == 0) return;
+        std::copy(data, data + count, storage_.get() + pos);
+        if (pos < window_) {
+            size_t mirrored = window_ - pos < count ? window_ - pos : count;
+            std::copy(data, data + mirrored, storage_.get() + capacity_ + pos);
+        }
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    const size_t window_;
+    std::unique_ptr<T[]> storage_;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head_;
+    alignas(CACHE_LINE) std::atomic<size_t> tail_;
+    alignas(CACHE_LINE) std::atomic<uint64_t> overruns_;
+    std::atomic<uint64_t> droppedItems_;
+    std::atomic<uint64_t> underruns_;
+};
+
+using IQRingBuffer = RingBuffer<std::complex<float>>;
+using AudioRingBuffer = RingBuffer<float>;
+
+#endif // RINGBUFFER_H
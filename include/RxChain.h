@@ -0,0 +1,116 @@
+#ifndef RXCHAIN_H
+#define RXCHAIN_H
+
+#include <RingBuffer.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Receive audio chain at the channel rate: complex band-pass filter,
+// demodulator, AGC, volume, then a lock-free ring that the audio callback
+// drains. process() takes the decimated baseband from NetworkIO, with the
+// wanted signal already mixed to DC.
+//
+// Each mode has its own Demodulator<Mode> specialisation; the chain holds a
+// pointer to the selected one, so the per-sample loops never test the mode.
+//
+// Setters may be called from any thread; changes are picked up at the start
+// of the next process() call on the DSP thread.
+class RxChain {
+public:
+    enum class Mode { LSB, USB, AM, CW };
+
+    struct Config {
+        Mode mode = Mode::USB;
+        int bandwidth = 3000;       // Hz; SSB upper edge, AM/CW full width
+        int sampleRate = 48000;
+        int cwPitch = 600;          // Hz
+        double agcTarget = 0.25;    // Output peak level
+        double agcMaxGainDb = 80.0;
+        double agcAttackMs = 2.0;
+        double agcHangMs = 250.0;
+        double agcDecayMs = 500.0;
+        double volume = 1.0;
+    };
+
+    // Per-block demodulator state, shared by all specialisations.
+    struct DemodState {
+        float dc = 0.0f;            // AM carrier estimate
+        float dcCoefficient = 0.0f;
+        float phasor[2] = {1.0f, 0.0f}; // CW beat oscillator
+        float step[2] = {1.0f, 0.0f};
+    };
+
+    template <Mode M>
+    struct Demodulator;
+
+    static const int SSB_LOW_CUT = 150;           // Hz
+    static const int FILTER_TRANSITION = 300;     // Hz, sets the tap count
+    static constexpr int MAX_FILTER_TAPS = 1023;
+    static const int BLOCK_SIZE = 1024;           // Samples per internal pass
+    static const int AUDIO_CAPACITY = 1 << 15;    // ~0.7 s at 48 kHz
+    static const int AUDIO_WINDOW = 4096;         // Largest contiguous peek()
+
+    RxChain();
+
+    void setConfig(const Config& config);
+    Config getConfig() const;
+    void setMode(Mode mode);
+    void setBandwidth(int hz);
+    void setSampleRate(int rate);
+    void setVolume(double volume);
+    // "LSB", "USB", "AM" or "CW", case-insensitive.
+    static bool modeFromName(const char* name, Mode* mode);
+    static const char* modeName(Mode mode);
+
+    // DSP thread only. iq: count interleaved complex samples at sampleRate.
+    void process(const float* iq, int count);
+    void reset();
+
+    // Consumer side belongs to the audio callback.
+    AudioRingBuffer& audioBuffer();
+
+private:
+    using DemodFunction = void (*)(const float* i, const float* q, float* audio, int n,
+                                   DemodState& state);
+
+    // Peak-tracking AGC with hang: fast attack, holds the gain for hangMs
+    // after a peak, then lets the envelope decay exponentially.
+    struct Agc {
+        float target = 0.25f;
+        float minEnvelope = 1e-5f;
+        float attack = 1.0f;
+        float decay = 1.0f;
+        int hangSamples = 0;
+        float envelope = 0.0f;
+        int hang = 0;
+        void setup(const Config& config);
+        void reset();
+        void process(float* audio, int n, float volume);
+    };
+
+    void applyPendingConfig();
+    void designFilter(const Config& config);
+    void filter(const float* iq, int n);
+
+    mutable std::mutex configMutex_;
+    Config pending_;
+    std::atomic<bool> configDirty_;
+
+    Config active_;
+    DemodFunction demodulate_;
+    DemodState demodState_;
+    Agc agc_;
+    std::vector<float> tapsRe_;
+    std::vector<float> tapsIm_;
+    int taps_;
+    int index_;
+    std::vector<float> historyI_; // Doubled so the window is always contiguous
+    std::vector<float> historyQ_;
+    std::vector<float> filteredI_;
+    std::vector<float> filteredQ_;
+    std::vector<float> audio_;
+    AudioRingBuffer audioRing_;
+};
+
+#endif // RXCHAIN_H
@@ -0,0 +1,94 @@
+#ifndef SPECTRUMENGINE_H
+#define SPECTRUMENGINE_H
+
+#include <FFTPlanCache.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Welch-averaged spectrum estimator. Runs on the DSP thread: the caller
+// feeds it overlapping windows of windowSize() samples, advancing by
+// hopSize() between calls. Segment powers are averaged until a frame period
+// (sampleRate / frameRate samples) has elapsed, then exponential averaging
+// is applied and one frame of dB bins is handed to the frame handler,
+// independently of the packet rate. With peak hold on, the held maxima of
+// those bins go to the handler alongside them as a second trace.
+//
+// Setters may be called from any thread; changes are picked up by
+// applyPendingConfig() on the DSP thread.
+class SpectrumEngine {
+public:
+    enum class Averaging { None, LinearPower, LogPower };
+
+    struct Config {
+        int fftSize = 1024;
+        double overlap = 0.5;             // Fraction of fftSize, 0 .. MAX_OVERLAP
+        Averaging averaging = Averaging::None;
+        double averagingTime = 0.2;       // Seconds
+        bool peakHold = false;
+        double frameRate = 30.0;          // Frames per second
+        FFTPlanCache::WindowType window = FFTPlanCache::WindowType::Hann;
+        int sampleRate = 48000;
+        double gain = 1.0;
+    };
+
+    // peak: the peak-hold trace, or nullptr while peak hold is off.
+    using FrameHandler = std::function<void(const float* bins, const float* peak, int size)>;
+
+    static const int MIN_FFT_SIZE = 1024;
+    static const int MAX_FFT_SIZE = 262144;
+    static constexpr double MAX_OVERLAP = 0.875;
+
+    explicit SpectrumEngine(FFTPlanCache* cache);
+    ~SpectrumEngine();
+
+    void setConfig(const Config& config);
+    Config getConfig() const;
+    void setFftSize(int size);
+    void setOverlap(double overlap);
+    void setAveraging(Averaging mode, double timeSeconds);
+    void setPeakHold(bool enabled);
+    void clearPeakHold();
+    void setFrameRate(double fps);
+    void setSampleRate(int rate);
+    void setWindowType(FFTPlanCache::WindowType window);
+    void setGain(double gain);
+    void setFrameHandler(FrameHandler handler);
+
+    // DSP thread only.
+    bool applyPendingConfig();
+    int windowSize() const;
+    int hopSize() const;
+    int sampleRate() const;
+    void processWindow(const float* iq);
+    void reset();
+
+private:
+    static Config validate(Config config);
+    void emitFrame();
+
+    FFTPlanCache* cache_;
+    FrameHandler handler_;
+
+    mutable std::mutex configMutex_;
+    Config pending_;
+    std::atomic<bool> configDirty_;
+    std::atomic<bool> clearPeak_;
+
+    Config active_;
+    const FFTPlanCache::Plan* plan_;
+    int hop_;
+    float offsetDb_;
+    double framePeriodSamples_;
+    double samplesSinceFrame_;
+    int segments_;
+    bool averageValid_;
+    bool peakValid_;
+    std::vector<float> welchSum_;
+    std::vector<float> frameDb_;
+    std::vector<float> average_;
+    std::vector<float> peak_;
+};
+
+#endif // SPECTRUMENGINE_H
@@ -0,0 +1,118 @@
+#ifndef SPECTRUMFRAME_H
+#define SPECTRUMFRAME_H
+
+#include <QMetaType>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class SpectrumFramePool;
+
+// One immutable spectrum frame: dB bins, the peak-hold trace if there is
+// one, plus the metadata needed to draw them.
+// Frames come from a SpectrumFramePool and go back to it when the last
+// SpectrumFrameRef is released.
+class SpectrumFrame {
+public:
+    const float* bins() const { return bins_.data(); }
+    // size() bins of held peaks, or nullptr without peak hold.
+    const float* peak() const { return hasPeak_ ? peak_.data() : nullptr; }
+    int size() const { return size_; }
+    int64_t timestampNs() const { return timestampNs_; } // steady_clock
+    double centerFrequency() const { return centerFrequency_; }
+    double span() const { return span_; }
+
+private:
+    friend class SpectrumFramePool;
+    friend class SpectrumFrameRef;
+
+    SpectrumFrame();
+
+    std::vector<float> bins_;
+    std::vector<float> peak_;
+    bool hasPeak_;
+    int size_;
+    int64_t timestampNs_;
+    double centerFrequency_;
+    double span_;
+    std::atomic<int> refs_;
+    std::shared_ptr<SpectrumFramePool> pool_; // Set while the frame is out of the pool
+};
+
+// Intrusively refcounted handle to a SpectrumFrame. Copying a handle only
+// bumps an atomic count, so frames cross threads (including queued signal
+// connections) without copying bins or touching the heap.
+class SpectrumFrameRef {
+public:
+    SpectrumFrameRef() noexcept : frame_(nullptr) {}
+    SpectrumFrameRef(const SpectrumFrameRef& other) noexcept;
+    SpectrumFrameRef(SpectrumFrameRef&& other) noexcept;
+    SpectrumFrameRef& operator=(const SpectrumFrameRef& other) noexcept;
+    SpectrumFrameRef& operator=(SpectrumFrameRef&& other) noexcept;
+    ~SpectrumFrameRef();
+
+    const SpectrumFrame* get() const { return frame_; }
+    const SpectrumFrame* operator->() const { return frame_; }
+    const SpectrumFrame& operator*() const { return *frame_; }
+    explicit operator bool() const { return frame_ != nullptr; }
+    void reset();
+
+private:
+    friend class SpectrumFramePool;
+    friend class SpectrumFrameMailbox;
+    explicit SpectrumFrameRef(SpectrumFrame* frame) noexcept : frame_(frame) {}
+
+    SpectrumFrame* frame_;
+};
+
+// Fixed set of reusable frames. Bin storage grows to the largest FFT size
+// seen and is then reused, so steady-state operation does no heap allocation.
+// When every frame is in flight, acquire() returns an empty ref and counts
+// the frame as dropped.
+class SpectrumFramePool : public std::enable_shared_from_this<SpectrumFramePool> {
+public:
+    static std::shared_ptr<SpectrumFramePool> create(int frameCount);
+    ~SpectrumFramePool();
+
+    // peak may be nullptr.
+    SpectrumFrameRef acquire(const float* bins, const float* peak, int size, double centerFrequency,
+                             double span);
+    int freeFrames() const;
+    uint64_t droppedFrames() const;
+
+private:
+    friend class SpectrumFrameRef;
+    explicit SpectrumFramePool(int frameCount);
+    void recycle(SpectrumFrame* frame);
+
+    std::vector<std::unique_ptr<SpectrumFrame>> storage_;
+    std::vector<SpectrumFrame*> freeList_;
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> droppedFrames_;
+};
+
+// Single-slot, latest-wins handoff between one producer and one consumer.
+// post() swaps the new frame in with one atomic exchange; a frame that was
+// still unread goes straight back to its pool. Neither side blocks.
+class SpectrumFrameMailbox {
+public:
+    SpectrumFrameMailbox();
+    ~SpectrumFrameMailbox();
+
+    SpectrumFrameMailbox(const SpectrumFrameMailbox&) = delete;
+    SpectrumFrameMailbox& operator=(const SpectrumFrameMailbox&) = delete;
+
+    // Returns true if an unread frame was replaced.
+    bool post(SpectrumFrameRef frame);
+    // Empty ref if nothing new arrived since the last take().
+    SpectrumFrameRef take();
+
+private:
+    std::atomic<SpectrumFrame*> slot_;
+};
+
+Q_DECLARE_METATYPE(SpectrumFrameRef)
+
+#endif // SPECTRUMFRAME_H
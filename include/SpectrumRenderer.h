@@ -0,0 +1,110 @@
+#ifndef SPECTRUMRENDERER_H
+#define SPECTRUMRENDERER_H
+
+#include <QImage>
+#include <QPolygonF>
+#include <QSemaphore>
+#include <QThread>
+#include <SpectrumFrame.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Rasterizes spectrum frames off the GUI thread. For every frame submitted
+// it draws the finished panadapter image (cached grid and labels, then the
+// trace) and the frame's waterfall scanline, using the view at that moment.
+// The GUI thread only swaps the result in and blits it.
+//
+// submit() is latest-wins: if the worker is busy, older frames are skipped.
+// Results are triple-buffered (worker, ready, GUI), so images are reused
+// and never shared between threads. resultReady() is emitted at most once
+// until takeResult() collects it, so the GUI event queue never backs up.
+class SpectrumRenderer : public QThread {
+    Q_OBJECT
+
+public:
+    // Peak: min/max envelope per column. Average: mean per column.
+    // Fill: column maxima filled down to the floor.
+    enum class TraceStyle { Peak, Average, Fill };
+
+    struct View {
+        double centerFrequency = 14.0e6;
+        int span = 96000;
+        bool autoReference = true;    // Top of scale follows the frame peak
+        float topDb = 0.0f;           // dBFS at the top when not automatic
+        float rangeDb = 120.0f;
+        TraceStyle style = TraceStyle::Peak;
+        int width = 0;                // Panadapter size in pixels
+        int height = 0;
+        int waterfallWidth = 0;
+        float waterfallFloorDb = -130.0f;
+        float waterfallCeilingDb = -50.0f;
+    };
+
+    struct Result {
+        QImage spectrum;
+        std::vector<QRgb> waterfallLine;
+        int64_t timestampNs = 0;      // Of the source frame
+    };
+
+    static const int PALETTE_SIZE = 256;
+
+    explicit SpectrumRenderer(QObject* parent = nullptr);
+    ~SpectrumRenderer();
+
+    // Any thread.
+    void setView(const View& view);
+    View getView() const;
+    void submit(const SpectrumFrameRef& frame);
+    void requestStop();
+    quint64 getFramesRendered() const;
+    quint64 getFramesSkipped() const;
+    double getLastRenderMs() const;
+
+    // GUI thread: swaps the newest finished result into result. Returns
+    // false if nothing new was rendered since the last call.
+    bool takeResult(Result* result);
+
+signals:
+    void resultReady();
+
+protected:
+    void run() override;
+
+private:
+    static const int WAIT_TIMEOUT_MS = 50;
+
+    void buildPalette();
+    void render(const SpectrumFrame& frame, const View& view, Result* result);
+    void renderGrid(const View& view);
+    void renderWaterfallLine(const SpectrumFrame& frame, const View& view, Result* result);
+
+    SpectrumFrameMailbox mailbox_;
+    QSemaphore wakeup_;
+    std::atomic<bool> stopRequested_;
+
+    mutable std::mutex viewMutex_;
+    View view_;
+
+    std::mutex resultMutex_;
+    Result ready_;
+    bool readyFresh_;
+    std::atomic<bool> notifyPending_;
+
+    // Worker-thread state.
+    Result back_;
+    QImage grid_;
+    View gridView_;
+    std::vector<QRgb> palette_;
+    std::vector<float> columnMin_;
+    std::vector<float> columnMax_;
+    std::vector<float> columnMean_;
+    QPolygonF trace_;
+    QPolygonF peakTrace_;
+
+    std::atomic<quint64> rendered_;
+    std::atomic<quint64> skipped_;
+    std::atomic<double> lastRenderMs_;
+};
+
+#endif // SPECTRUMRENDERER_H
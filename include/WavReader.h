@@ -0,0 +1,76 @@
+#ifndef WAVREADER_H
+#define WAVREADER_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+
+// Memory-mapped WAV/RF64 source. open() maps the file and walks the RIFF
+// chunk list (fmt, ds64 and data; LIST, fact, cue and anything else are
+// skipped), so it costs the same for a 10 s clip as for a 10 h capture.
+// Samples are converted to float only as read() reaches them: pages fault
+// in on demand with sequential read-ahead, and pages already consumed are
+// dropped again, so resident memory stays at a few megabytes.
+//
+// Accepts PCM 16/24/32-bit integer and 32-bit IEEE float, plain or
+// WAVE_FORMAT_EXTENSIBLE. A data chunk whose size runs past the end of
+// the file (an interrupted recording) is truncated to what is there.
+//
+// Not thread-safe. The file must not be truncated while it is open.
+class WavReader {
+public:
+    enum class Encoding { Int16, Int24, Int32, Float32 };
+
+    struct Format {
+        int channels = 0;
+        int sampleRate = 0;
+        int bitsPerSample = 0;
+        Encoding encoding = Encoding::Int16;
+        uint64_t frames = 0;
+    };
+
+    static const int MAX_CHANNELS = 32;
+
+    WavReader();
+    ~WavReader();
+
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+
+    // Returns false, with the reason logged, if the file cannot be mapped or
+    // is not a supported WAV file.
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const;
+
+    const Format& format() const;
+    static const char* encodingName(Encoding encoding);
+
+    // Position in frames from the start of the data chunk.
+    uint64_t position() const;
+    bool seek(uint64_t frame);
+
+    // Converts up to frames frames, interleaved at the file's channel count,
+    // into out. Returns frames written; fewer than asked only at the end.
+    size_t read(float* out, size_t frames);
+
+private:
+    static const size_t READAHEAD_BYTES = 1 << 20;
+    static const size_t RELEASE_BYTES = 1 << 20;
+
+    bool parse(const QString& path);
+    void advise(uint64_t begin, uint64_t end);
+
+    int fd_;
+    const uint8_t* map_;
+    uint64_t mapSize_;
+    uint64_t dataOffset_;
+    uint64_t dataSize_;
+    int frameBytes_;
+    Format format_;
+    uint64_t position_;
+    uint64_t releasedTo_;   // Bytes before this have been dropped
+    uint64_t prefetchedTo_; // Read-ahead has been requested up to here
+};
+
+#endif // WAVREADER_H
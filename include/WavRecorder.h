@@ -0,0 +1,124 @@
+#ifndef WAVRECORDER_H
+#define WAVRECORDER_H
+
+#include <QString>
+#include <Resampler.h>
+#include <RingBuffer.h>
+#include <WavReader.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class DspThread;
+
+// Streaming WAV recorder for audio or wideband I/Q. write() is lock-free
+// and allocation-free, so it can be called from the audio callback or the
+// DSP thread; it only copies whole frames into a ring sized at start().
+// A writer thread converts the ring to the file encoding (TPDF-dithered
+// int16/int24, int32 or native float32) into large page-aligned buffers
+// and writes them with pwrite(). When the input rate differs from the file
+// rate the writer thread also runs the Resampler, so write() stays a copy.
+//
+// The header reserves a JUNK chunk for a ds64 chunk, so a file that grows
+// past 4 GB is rewritten in place as RF64 without moving any data. The
+// header is rewritten with the current sizes and the data synced to disk
+// every CHECKPOINT_MS, so a crash leaves a playable file missing at most
+// the last checkpoint interval; synced pages are then dropped from the
+// page cache so multi-hour captures do not crowd out other data.
+//
+// write() must only be called from one thread at a time; start() and
+// stop() belong to the control thread.
+class WavRecorder {
+public:
+    using Encoding = WavReader::Encoding;
+
+    struct Format {
+        int channels = 2;
+        int sampleRate = 48000;
+        Encoding encoding = Encoding::Int16;
+        bool dither = true;            // Integer encodings below 32 bits
+        int inputRate = 0;             // Rate write() is fed at; 0 = sampleRate
+        Resampler::Quality quality = Resampler::Quality::High;
+    };
+
+    static const int BUFFER_BYTES = 1 << 20;   // One pwrite()
+    static const int CHECKPOINT_MS = 2000;
+    static const int RING_MS = 2000;           // Writer stall the ring absorbs
+    static const int HEADER_BYTES = 80;        // RIFF + JUNK/ds64 + fmt + data
+    static const int RING_WINDOW = 16384;      // Samples converted per pass
+
+    WavRecorder();
+    ~WavRecorder();
+
+    WavRecorder(const WavRecorder&) = delete;
+    WavRecorder& operator=(const WavRecorder&) = delete;
+
+    // Returns false, with the reason logged, if the format is unsupported or
+    // the file cannot be created. Stops any recording in progress first.
+    bool start(const QString& path, const Format& format);
+    // Writes out everything queued, finalises the header and closes.
+    void stop();
+    bool isRecording() const;
+
+    // Queues frames interleaved samples at the recording's channel count.
+    // Real-time safe. Whole calls are dropped, never partial frames; returns
+    // false if the frames were dropped or nothing is recording.
+    bool write(const float* interleaved, size_t frames);
+    // As write(), for frames at inputChannels: recording channel c takes
+    // input channel c, or the last input channel if there are fewer.
+    bool write(const float* interleaved, size_t frames, int inputChannels);
+    // Not real-time: like write(), but waits for the writer thread to make
+    // room instead of dropping. For producers that run faster than real
+    // time. Returns false if nothing is recording or frames can never fit.
+    bool writeWait(const float* interleaved, size_t frames);
+
+    Format format() const;
+    uint64_t framesWritten() const;   // Reached the file
+    uint64_t droppedFrames() const;
+    bool isRf64() const;
+
+private:
+    struct AlignedFree {
+        void operator()(uint8_t* p) const;
+    };
+
+    void service();
+    void drain();
+    void append(const float* samples, size_t count);
+    void convert(const float* in, size_t samples, uint8_t* out);
+    bool flushBuffer();
+    void checkpoint();
+    bool writeHeader();
+    void closeFile();
+    void waitForProducer() const;
+
+    mutable std::mutex fileMutex_;      // Control thread vs writer thread
+    Format format_;
+    int fd_;
+    int sampleBytes_;
+    int frameBytes_;
+    std::unique_ptr<uint8_t[], AlignedFree> buffer_;
+    size_t bufferUsed_;
+    Resampler resampler_;
+    bool resampling_;
+    std::vector<float> resampled_;      // One ring window at the file rate
+    uint64_t dataBytes_;                // Flushed to the file
+    bool rf64_;
+    bool failed_;
+    uint32_t ditherState_;
+    std::chrono::steady_clock::time_point lastCheckpoint_;
+    std::unique_ptr<DspThread> writerThread_;
+
+    // Shared with the producer.
+    std::unique_ptr<AudioRingBuffer> ring_;
+    std::atomic<bool> active_;
+    std::atomic<bool> inWrite_;
+    std::atomic<int> channels_;
+    std::atomic<uint64_t> framesWritten_;
+    std::atomic<uint64_t> droppedFrames_;
+};
+
+#endif // WAVRECORDER_H
@@ -0,0 +1,220 @@
+// Quality/CPU table for the Resampler.
+//
+// For each rate pair and quality, feeds test tones through the resampler
+// and fits the expected sinusoid to what comes out:
+//
+//   ripple   worst passband gain error, in dB
+//   spur     worst level of anything that should not be there, in dB
+//            relative to the tone: images and interpolation error on
+//            passband tones, and whatever leaks through from tones above
+//            the output Nyquist frequency when downsampling
+//
+// then times the resampler on white noise at the given channel count and
+// reports nanoseconds per output frame and the multiple of real time.
+//
+//   resamplerbench [--from Hz --to Hz] [--quality fast|medium|high|best]
+//                  [--channels 2] [--seconds 2]
+
+#include <DspKernels.h>
+#include <Resampler.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const Resampler::Quality QUALITIES[] = {Resampler::Quality::Fast, Resampler::Quality::Medium,
+                                        Resampler::Quality::High, Resampler::Quality::Best};
+// Passband edges the table claims, as fractions of the lower Nyquist.
+const double PASSBANDS[] = {0.80, 0.88, 0.92, 0.95};
+const int TONES = 16;
+const int TONE_FRAMES = 16384;
+const int BLOCK_FRAMES = 1024;
+
+struct Options {
+    int from = 0;
+    int to = 0;
+    int quality = -1;   // All
+    int channels = 2;
+    double seconds = 2.0;
+};
+
+struct Result {
+    double rippleDb = 0.0;
+    double spurDb = -400.0;
+    double nsPerFrame = 0.0;
+    double realtime = 0.0;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: resamplerbench [--from Hz --to Hz] [--quality fast|medium|high|best]\n"
+                 "                      [--channels N] [--seconds S]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--from") options.from = std::atoi(value.c_str());
+        else if (arg == "--to") options.to = std::atoi(value.c_str());
+        else if (arg == "--channels") options.channels = std::atoi(value.c_str());
+        else if (arg == "--seconds") options.seconds = std::atof(value.c_str());
+        else if (arg == "--quality") {
+            for (int q = 0; q < 4; ++q) {
+                if (value == Resampler::qualityName(QUALITIES[q])) options.quality = q;
+            }
+            if (options.quality < 0) {
+                usage();
+                return false;
+            }
+        } else {
+            usage();
+            return false;
+        }
+    }
+    if ((options.from > 0) != (options.to > 0) || options.from < 0 || options.to < 0 ||
+        options.channels < 1 || options.channels > Resampler::MAX_CHANNELS || options.seconds <= 0.0) {
+        usage();
+        return false;
+    }
+    return true;
+}
+
+double toDb(double ratio) {
+    return 20.0 * std::log10(std::max(ratio, 1e-20));
+}
+
+// Runs a unit sine at frequency Hz through a fresh mono resampler and
+// returns the fitted output amplitude and the RMS of what is left over.
+// The filter's start-up transient and flush tail are skipped.
+std::pair<double, double> measureTone(Resampler& resampler, double frequency) {
+    resampler.reset();
+    const int inRate = resampler.inputRate();
+    const int outRate = resampler.outputRate();
+    std::vector<float> in(TONE_FRAMES);
+    for (int i = 0; i < TONE_FRAMES; ++i) {
+        in[i] = static_cast<float>(std::sin(2.0 * M_PI * frequency * i / inRate));
+    }
+    std::vector<float> out(resampler.maxOutput(TONE_FRAMES));
+    size_t produced = resampler.process(in.data(), TONE_FRAMES, out.data());
+
+    // Output n is the input at time n*step - latency.
+    double step = static_cast<double>(inRate) / outRate;
+    size_t skip = static_cast<size_t>(std::ceil(resampler.taps() / step)) + 1;
+    if (produced <= 2 * skip) return std::make_pair(0.0, 0.0);
+    size_t count = produced - skip;
+
+    // Least-squares fit of a*cos + b*sin at the tone's output frequency.
+    double w = 2.0 * M_PI * frequency / outRate;
+    double cc = 0.0, ss = 0.0, cs = 0.0, yc = 0.0, ys = 0.0;
+    for (size_t n = skip; n < produced; ++n) {
+        double c = std::cos(w * n);
+        double s = std::sin(w * n);
+        cc += c * c;
+        ss += s * s;
+        cs += c * s;
+        yc += out[n] * c;
+        ys += out[n] * s;
+    }
+    double det = cc * ss - cs * cs;
+    double a = 0.0;
+    double b = 0.0;
+    if (std::abs(det) > 1e-9 * cc * ss) {
+        a = (yc * ss - ys * cs) / det;
+        b = (ys * cc - yc * cs) / det;
+    }
+    double residual = 0.0;
+    for (size_t n = skip; n < produced; ++n) {
+        double e = out[n] - a * std::cos(w * n) - b * std::sin(w * n);
+        residual += e * e;
+    }
+    return std::make_pair(std::sqrt(a * a + b * b), std::sqrt(residual / count));
+}
+
+Result measure(int from, int to, int quality, int channels, double seconds) {
+    Result result;
+    Resampler resampler;
+    resampler.configure(from, to, 1, QUALITIES[quality]);
+    const double nyquist = 0.5 * std::min(from, to);
+    const double edge = PASSBANDS[quality] * nyquist;
+    const double toneRms = std::sqrt(0.5);
+
+    for (int t = 0; t < TONES; ++t) {
+        double frequency = edge * (0.02 + 0.98 * t / (TONES - 1));
+        std::pair<double, double> fit = measureTone(resampler, frequency);
+        result.rippleDb = std::max(result.rippleDb, std::abs(toDb(fit.first)));
+        result.spurDb = std::max(result.spurDb, toDb(fit.second / toneRms));
+    }
+    if (to < from) {
+        // Everything from the output Nyquist up is stopband.
+        double top = 0.5 * from;
+        for (int t = 0; t < TONES; ++t) {
+            double frequency = nyquist + (top - nyquist) * (0.01 + 0.98 * t / (TONES - 1));
+            std::pair<double, double> fit = measureTone(resampler, frequency);
+            double leak = std::sqrt(fit.first * fit.first * 0.5 + fit.second * fit.second);
+            result.spurDb = std::max(result.spurDb, toDb(leak / toneRms));
+        }
+    }
+
+    resampler.configure(from, to, channels, QUALITIES[quality]);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<float> in(static_cast<size_t>(BLOCK_FRAMES) * channels);
+    for (float& v : in) v = noise(random);
+    std::vector<float> out(resampler.maxOutput(BLOCK_FRAMES) * channels);
+    long long blocks = std::max(1LL, static_cast<long long>(seconds * from / BLOCK_FRAMES));
+    size_t produced = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long b = 0; b < blocks; ++b) {
+        produced += resampler.process(in.data(), BLOCK_FRAMES, out.data());
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.nsPerFrame = produced ? elapsed * 1e9 / produced : 0.0;
+    result.realtime = elapsed > 0.0 ? static_cast<double>(blocks) * BLOCK_FRAMES / from / elapsed : 0.0;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::vector<std::pair<int, int>> pairs;
+    if (options.from > 0) {
+        pairs.push_back(std::make_pair(options.from, options.to));
+    } else {
+        pairs = {{44100, 48000}, {48000, 44100}, {8000, 48000},
+                 {48000, 8000}, {192000, 48000}, {48000, 192000}};
+    }
+
+    std::printf("resamplerbench: %s kernels, %d channel(s), %.1f s per timing run\n\n",
+                DspKernels::isaName(), options.channels, options.seconds);
+    std::printf("%15s  %-7s %5s %6s %10s %9s %10s %11s\n", "rates", "quality", "taps", "phases",
+                "ripple dB", "spur dB", "ns/frame", "x realtime");
+    for (const std::pair<int, int>& pair : pairs) {
+        for (int q = 0; q < 4; ++q) {
+            if (options.quality >= 0 && q != options.quality) continue;
+            Resampler probe;
+            probe.configure(pair.first, pair.second, 1, QUALITIES[q]);
+            Result result = measure(pair.first, pair.second, q, options.channels, options.seconds);
+            char rates[32];
+            std::snprintf(rates, sizeof(rates), "%d->%d", pair.first, pair.second);
+            std::printf("%15s  %-7s %5d %6d %10.4f %9.1f %10.1f %11.0f\n", rates,
+                        Resampler::qualityName(QUALITIES[q]), probe.taps(), probe.phases(),
+                        result.rippleDb, result.spurDb, result.nsPerFrame, result.realtime);
+        }
+    }
+    return 0;
+}
@@ -1,17 +1,29 @@
 #include <Audio.h>
 #include <Console.h>
 #include <AudioProcessor.h>
+#include <Logging.h>
 #include <QDebug>
+#include <QTimer>
 #include <algorithm>
+#include <cmath>
 
 Audio::Audio(Console* console, QObject* parent)
     : QObject(parent),
       console_(console),
       initialized_(false),
-      stream_(nullptr),
+      backend_(AudioBackend::create("portaudio")),
       playbackEnabled_(false),
       preampGain_(1.0),
-      processor_(new AudioProcessor(this)) {
+      processor_(new AudioProcessor(this)),
+      receiveAudio_(nullptr),
+      sampleRate_(0),
+      inputChannels_(0),
+      outputFrames_(0),
+      summaryTimer_(new QTimer(this)) {
+    connect(summaryTimer_, &QTimer::timeout, this, [this]() {
+        monitor_.logSummary();
+        if (receiveAudio_) drift_.logSummary();
+    });
     qDebug() << "Audio initialized";
 }
 
@@ -20,83 +32,72 @@ Audio::~Audio() {
     qDebug() << "Audio destructed";
 }
 
-bool Audio::initialize(int sampleRate, int bufferSize) {
-    PaError err = Pa_Initialize();
-    if (err != paNoError) {
-        qDebug() << "PortAudio initialization failed:" << Pa_GetErrorText(err);
+bool Audio::setBackend(const QString& name, const AudioBackend::Config& options) {
+    std::unique_ptr<AudioBackend> backend = AudioBackend::create(name);
+    if (!backend) {
+        qDebug() << "Audio: Unknown backend" << name;
         return false;
     }
+    stop();
+    backend_ = std::move(backend);
+    backendConfig_ = options;
+    qDebug() << "Audio: Using the" << backend_->name() << "backend";
+    return true;
+}
 
-    PaStreamParameters outputParameters;
-    outputParameters.device = paNoDevice;
-
-    for (int i = 0; i < Pa_GetDeviceCount(); ++i) {
-        const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(i);
-        if (deviceInfo && QString(deviceInfo->name).contains("Jabra SPEAK 510 USB") && 
-            deviceInfo->maxOutputChannels >= 2) {
-            outputParameters.device = i;
-            break;
-        }
+bool Audio::initialize(int sampleRate, int bufferSize) {
+    AudioBackend::Config config = backendConfig_;
+    config.sampleRate = sampleRate;
+    config.framesPerBuffer = bufferSize;
+    config.outputChannels = 2;
+    bool opened = backend_->open(config, [this](const float* input, float* output, unsigned long frames,
+                                                const AudioBackend::Timing& timing) {
+        audioCallback(input, output, frames, timing);
+    });
+    if (!opened) {
+        return false;
     }
 
-    if (outputParameters.device == paNoDevice) {
-        outputParameters.device = Pa_GetDefaultOutputDevice();
-        if (outputParameters.device == paNoDevice) {
-            qDebug() << "No default output device found";
-            Pa_Terminate();
-            return false;
-        }
+    processor_->setStreamRate(sampleRate);
+    int receiveTarget = std::max(RECEIVE_LATENCY_MS * sampleRate / 1000, 2 * bufferSize + RxChain::BLOCK_SIZE);
+    if (!drift_.configure(sampleRate, receiveTarget)) {
+        backend_->close();
+        return false;
     }
-
-    const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(outputParameters.device);
-    qDebug() << "Selected audio device:" << deviceInfo->name
-             << "Host API:" << Pa_GetHostApiInfo(deviceInfo->hostApi)->name;
-
-    outputParameters.channelCount = 2;
-    outputParameters.sampleFormat = paFloat32;
-    outputParameters.suggestedLatency = deviceInfo->defaultLowOutputLatency;
-    outputParameters.hostApiSpecificStreamInfo = nullptr;
-
-    err = Pa_OpenStream(
-        &stream_,
-        nullptr,
-        &outputParameters,
-        sampleRate,
-        bufferSize,
-        paClipOff,
-        audioCallback,
-        this
-    );
-    if (err != paNoError) {
-        qDebug() << "Failed to open PortAudio stream:" << Pa_GetErrorText(err);
-        Pa_Terminate();
+    inputChannels_ = config.inputChannels;
+    if (inputChannels_ > 0 && !mic_.configure(sampleRate)) {
+        backend_->close();
         return false;
     }
-
+    sampleRate_ = sampleRate;
+    monitor_.setSampleRate(sampleRate);
     initialized_ = true;
-    qDebug() << "Audio initialized with sample rate:" << sampleRate << "buffer size:" << bufferSize;
+    qDebug() << "Audio initialized with sample rate:" << sampleRate << "buffer size:" << bufferSize
+             << "backend:" << backend_->name();
     return true;
 }
 
 void Audio::start() {
-    if (!initialized_ || !stream_) {
+    if (!initialized_ || !backend_->isOpen()) {
         qDebug() << "Audio not initialized or stream is null, cannot start";
         return;
     }
-    PaError err = Pa_StartStream(stream_);
-    if (err != paNoError) {
-        qDebug() << "Failed to start PortAudio stream:" << Pa_GetErrorText(err);
+    monitor_.restart();
+    drift_.reset();
+    mic_.reset();
+    outputFrames_ = 0;
+    if (!backend_->start()) {
         return;
     }
+    summaryTimer_->start(SUMMARY_INTERVAL_MS);
     qDebug() << "Audio stream started";
 }
 
 void Audio::stop() {
-    if (initialized_ && stream_) {
-        Pa_CloseStream(stream_);
-        Pa_Terminate();
+    if (initialized_) {
+        summaryTimer_->stop();
+        backend_->close();
         initialized_ = false;
-        stream_ = nullptr;
         qDebug() << "Audio stream stopped";
     }
 }
@@ -109,12 +110,13 @@ bool Audio::startPlayback(const QString& filename, int id) {
     return processor_->startPlayback(filename, id);
 }
 
-bool Audio::startRecording(const QString& filename, int channels, int sampleRate) {
+bool Audio::startRecording(const QString& filename, int channels, int sampleRate,
+                           WavRecorder::Encoding encoding) {
     if (!initialized_) {
         qDebug() << "Audio: Not initialized";
         return false;
     }
-    return processor_->startRecording(filename, channels, sampleRate);
+    return processor_->startRecording(filename, channels, sampleRate, encoding);
 }
 
 void Audio::stopPlayback(int id) {
@@ -136,20 +138,66 @@ void Audio::setPreamp(double gain) {
     qDebug() << "Preamp gain set to:" << gain;
 }
 
-int Audio::audioCallback(const void* input, void* output, unsigned long frameCount,
-                         const PaStreamCallbackTimeInfo* timeInfo,
-                         PaStreamCallbackFlags statusFlags, void* userData) {
-    Audio* audio = static_cast<Audio*>(userData);
-    float* out = static_cast<float*>(output);
-    float* in = static_cast<float*>(const_cast<void*>(input));
+void Audio::setReceiveAudio(AudioRingBuffer* ring) {
+    receiveAudio_ = ring;
+    qDebug() << "Audio: Receive audio" << (ring ? "connected" : "disconnected");
+}
+
+quint64 Audio::getReceiveUnderruns() const {
+    return drift_.stats().underruns;
+}
+
+DriftController::Stats Audio::getReceiveDrift() const {
+    return drift_.stats();
+}
+
+quint64 Audio::getPlaybackUnderruns() const {
+    return processor_->getPlaybackUnderruns();
+}
+
+AudioCallbackMonitor::Stats Audio::getCallbackStats() const {
+    return monitor_.stats();
+}
+
+MicCapture& Audio::micCapture() {
+    return mic_;
+}
+
+// Runs in the callback: no locks, no allocation. Leaves silence for
+// whatever the ring cannot supply, including while it refills to the target.
+void Audio::drainReceiveAudio(float* out, unsigned long frameCount) {
+    drift_.pull(*receiveAudio_, out, frameCount, 2);
+}
+
+// Runs on the backend's callback thread.
+void Audio::audioCallback(const float* input, float* output, unsigned long frameCount,
+                          const AudioBackend::Timing& timing) {
+    monitor_.begin(frameCount, timing.currentTime, timing.outputDacTime, timing.flags);
+
+    float* out = output;
+
+    if (input && inputChannels_ > 0) {
+        // output[0] is frame outputFrames_ and reaches the DAC at
+        // outputDacTime; without host timestamps assume a buffer each way.
+        int64_t captureOffset = -2 * static_cast<int64_t>(frameCount);
+        if (timing.inputAdcTime > 0.0 && timing.outputDacTime > 0.0) {
+            captureOffset = std::llround((timing.inputAdcTime - timing.outputDacTime) * sampleRate_);
+        }
+        mic_.write(input, inputChannels_, frameCount, outputFrames_ + captureOffset, timing.inputAdcTime);
+    }
 
     // Clear output buffer
     std::fill(out, out + frameCount * 2, 0.0f); // Assuming stereo
 
+    if (receiveAudio_) {
+        drainReceiveAudio(out, frameCount);
+    }
+
     // Process audio if playback is enabled
-    if (audio->playbackEnabled_) {
-        return audio->processor_->processAudio(in, out, frameCount);
+    if (playbackEnabled_) {
+        processor_->processAudio(input, inputChannels_, out, frameCount);
     }
 
-    return paContinue;
+    outputFrames_ += frameCount;
+    monitor_.end();
 }
@@ -0,0 +1,11 @@
+#include <AudioBackend.h>
+#include <FileAudioBackend.h>
+#include <NullAudioBackend.h>
+#include <PortAudioBackend.h>
+
+std::unique_ptr<AudioBackend> AudioBackend::create(const QString& name) {
+    if (name == "portaudio") return std::unique_ptr<AudioBackend>(new PortAudioBackend());
+    if (name == "null") return std::unique_ptr<AudioBackend>(new NullAudioBackend());
+    if (name == "file") return std::unique_ptr<AudioBackend>(new FileAudioBackend());
+    return nullptr;
+}
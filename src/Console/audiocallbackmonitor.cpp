@@ -0,0 +1,136 @@
+#include <AudioCallbackMonitor.h>
+#include <Logging.h>
+#include <QDebug>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+const unsigned long XRUN_FLAGS = AudioCallbackMonitor::InputUnderflow | AudioCallbackMonitor::InputOverflow |
+                                 AudioCallbackMonitor::OutputUnderflow | AudioCallbackMonitor::OutputOverflow;
+
+double toUs(uint64_t ns) {
+    return ns / 1000.0;
+}
+
+} // namespace
+
+uint64_t AudioCallbackMonitor::Stats::xruns() const {
+    return inputUnderflows + inputOverflows + outputUnderflows + outputOverflows;
+}
+
+AudioCallbackMonitor::Stats AudioCallbackMonitor::Stats::since(const Stats& earlier) const {
+    Stats result;
+    result.callbacks = callbacks - earlier.callbacks;
+    result.inputUnderflows = inputUnderflows - earlier.inputUnderflows;
+    result.inputOverflows = inputOverflows - earlier.inputOverflows;
+    result.outputUnderflows = outputUnderflows - earlier.outputUnderflows;
+    result.outputOverflows = outputOverflows - earlier.outputOverflows;
+    result.deadlineMisses = deadlineMisses - earlier.deadlineMisses;
+    result.duration = duration.since(earlier.duration);
+    result.jitter = jitter.since(earlier.jitter);
+    result.headroom = headroom.since(earlier.headroom);
+    return result;
+}
+
+AudioCallbackMonitor::AudioCallbackMonitor()
+    : sampleRate_(48000),
+      startNs_(0),
+      lastStartNs_(0),
+      lastPeriodNs_(0),
+      deadlineNs_(0),
+      callbacks_(0),
+      inputUnderflows_(0),
+      inputOverflows_(0),
+      outputUnderflows_(0),
+      outputOverflows_(0),
+      deadlineMisses_(0),
+      lastSummaryNs_(Logging::monotonicNs()) {
+    lastSummary_ = stats();
+}
+
+void AudioCallbackMonitor::setSampleRate(int rate) {
+    sampleRate_ = rate > 0 ? rate : 48000;
+}
+
+int AudioCallbackMonitor::sampleRate() const {
+    return sampleRate_;
+}
+
+void AudioCallbackMonitor::restart() {
+    lastStartNs_ = 0;
+}
+
+void AudioCallbackMonitor::begin(unsigned long frames, double currentTime, double outputDacTime,
+                                 unsigned long flags) {
+    startNs_ = Logging::monotonicNs();
+    if (lastStartNs_ != 0) {
+        jitter_.record(static_cast<uint64_t>(std::llabs(startNs_ - lastStartNs_ - lastPeriodNs_)));
+    }
+    lastStartNs_ = startNs_;
+    lastPeriodNs_ = static_cast<int64_t>(frames) * 1000000000LL / sampleRate_;
+    deadlineNs_ = outputDacTime > 0.0 ? static_cast<int64_t>((outputDacTime - currentTime) * 1e9) : 0;
+
+    callbacks_.fetch_add(1, std::memory_order_relaxed);
+    if (flags & XRUN_FLAGS) {
+        if (flags & InputUnderflow) inputUnderflows_.fetch_add(1, std::memory_order_relaxed);
+        if (flags & InputOverflow) inputOverflows_.fetch_add(1, std::memory_order_relaxed);
+        if (flags & OutputUnderflow) outputUnderflows_.fetch_add(1, std::memory_order_relaxed);
+        if (flags & OutputOverflow) outputOverflows_.fetch_add(1, std::memory_order_relaxed);
+        THETIS_TRACE("audio.xrun", static_cast<int64_t>(flags), static_cast<int64_t>(frames));
+    }
+}
+
+void AudioCallbackMonitor::end() {
+    int64_t duration = Logging::monotonicNs() - startNs_;
+    duration_.record(static_cast<uint64_t>(duration));
+    if (deadlineNs_ > 0) {
+        int64_t headroom = deadlineNs_ - duration;
+        if (headroom < 0) {
+            deadlineMisses_.fetch_add(1, std::memory_order_relaxed);
+            THETIS_TRACE("audio.late", duration, deadlineNs_);
+            headroom = 0;
+        }
+        headroom_.record(static_cast<uint64_t>(headroom));
+    }
+}
+
+AudioCallbackMonitor::Stats AudioCallbackMonitor::stats() const {
+    Stats result;
+    result.callbacks = callbacks_.load(std::memory_order_relaxed);
+    result.inputUnderflows = inputUnderflows_.load(std::memory_order_relaxed);
+    result.inputOverflows = inputOverflows_.load(std::memory_order_relaxed);
+    result.outputUnderflows = outputUnderflows_.load(std::memory_order_relaxed);
+    result.outputOverflows = outputOverflows_.load(std::memory_order_relaxed);
+    result.deadlineMisses = deadlineMisses_.load(std::memory_order_relaxed);
+    result.duration = duration_.snapshot();
+    result.jitter = jitter_.snapshot();
+    result.headroom = headroom_.snapshot();
+    return result;
+}
+
+void AudioCallbackMonitor::logSummary() {
+    Stats now = stats();
+    Stats interval = now.since(lastSummary_);
+    int64_t nowNs = Logging::monotonicNs();
+    double seconds = (nowNs - lastSummaryNs_) / 1e9;
+    lastSummary_ = now;
+    lastSummaryNs_ = nowNs;
+    if (interval.callbacks == 0) return;
+
+    const LatencyHistogram::Snapshot& duration = interval.duration;
+    const LatencyHistogram::Snapshot& jitter = interval.jitter;
+    const LatencyHistogram::Snapshot& headroom = interval.headroom;
+    THETIS_INFO(lcAudio).nospace()
+        << "Audio: " << interval.callbacks << " callbacks in " << QString::number(seconds, 'f', 1) << " s"
+        << "; duration us p50/p99/max " << toUs(duration.percentile(0.5)) << "/"
+        << toUs(duration.percentile(0.99)) << "/" << toUs(duration.max)
+        << "; jitter us p99/max " << toUs(jitter.percentile(0.99)) << "/" << toUs(jitter.max)
+        << "; headroom us min/p1 " << toUs(headroom.min) << "/" << toUs(headroom.percentile(0.01));
+    if (interval.xruns() || interval.deadlineMisses) {
+        THETIS_WARNING(lcAudio) << "Audio: xruns - output underflow" << interval.outputUnderflows
+                                << "overflow" << interval.outputOverflows << "input underflow"
+                                << interval.inputUnderflows << "overflow" << interval.inputOverflows
+                                << "deadline misses" << interval.deadlineMisses;
+    }
+}
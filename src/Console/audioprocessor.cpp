@@ -1,181 +1,123 @@
 #include <AudioProcessor.h>
+#include <DspThread.h>
 #include <QDebug>
-#include <cstring>
 
 AudioProcessor::AudioProcessor(QObject* parent)
     : QObject(parent),
-      playback_{nullptr, {}, {}, 0, false, -1},
-      recordingFile_(nullptr),
-      preampGain_(1.0) {
+      diskThread_(new DspThread(this)),
+      preampGain_(1.0f),
+      streamRate_(DEFAULT_RATE) {
+    diskThread_->setWorkFunction([this]() { mixer_.service(); });
+    diskThread_->startProcessing(QThread::NormalPriority);
     qDebug() << "AudioProcessor initialized";
 }
 
 AudioProcessor::~AudioProcessor() {
-    stopPlayback(playback_.id);
-    stopRecording();
+    // The mixer frees its sources itself once the disk thread is gone.
+    diskThread_->requestStop();
+    diskThread_->wait();
     qDebug() << "AudioProcessor destructed";
 }
 
-bool AudioProcessor::readWavHeader(FILE* file, WavHeader& header) {
-    if (!file) return false;
-    rewind(file);
-    if (fread(&header, sizeof(WavHeader), 1, file) != 1) {
-        qDebug() << "AudioProcessor: Failed to read WAV header";
-        return false;
-    }
-    if (strncmp(header.riff, "RIFF", 4) != 0 || strncmp(header.wave, "WAVE", 4) != 0 ||
-        strncmp(header.fmt, "fmt ", 4) != 0 || strncmp(header.data, "data", 4) != 0) {
-        qDebug() << "AudioProcessor: Invalid WAV header";
-        return false;
-    }
-    if (header.audioFormat != 1 || header.sampleRate != 48000 || header.bitsPerSample != 16) {
-        qDebug() << "AudioProcessor: Unsupported WAV format (PCM, 48000 Hz, 16-bit required)";
-        return false;
-    }
-    return true;
+void AudioProcessor::setStreamRate(int rate) {
+    streamRate_ = rate;
+    qDebug() << "AudioProcessor: Stream rate" << rate << "Hz";
 }
 
-bool AudioProcessor::writeWavHeader(FILE* file, int channels, int sampleRate) {
-    if (!file) return false;
-    WavHeader header = {};
-    std::memcpy(header.riff, "RIFF", 4); // Changed from strncpy
-    std::memcpy(header.wave, "WAVE", 4); // Changed from strncpy
-    std::memcpy(header.fmt, "fmt ", 4);  // Changed from strncpy
-    std::memcpy(header.data, "data", 4); // Changed from strncpy
-    header.subchunk1Size = 16;
-    header.audioFormat = 1; // PCM
-    header.numChannels = channels;
-    header.sampleRate = sampleRate;
-    header.bitsPerSample = 16;
-    header.byteRate = sampleRate * channels * header.bitsPerSample / 8;
-    header.blockAlign = channels * header.bitsPerSample / 8;
-    header.subchunk2Size = 0; // Updated later
-    header.chunkSize = 36 + header.subchunk2Size;
-    rewind(file);
-    if (fwrite(&header, sizeof(WavHeader), 1, file) != 1) {
-        qDebug() << "AudioProcessor: Failed to write WAV header";
-        return false;
-    }
-    return true;
+int AudioProcessor::getStreamRate() const {
+    return streamRate_;
 }
 
-bool AudioProcessor::startPlayback(const QString& filename, int id) {
-    stopPlayback(playback_.id);
-
-    FILE* file = fopen(filename.toStdString().c_str(), "rb");
-    if (!file) {
+bool AudioProcessor::startPlayback(const QString& filename, int id, const PlaybackMixer::Options& options) {
+    std::unique_ptr<WavPlaybackSource> source(new WavPlaybackSource());
+    if (!source->open(filename, streamRate_, PLAYBACK_QUALITY)) {
         qDebug() << "AudioProcessor: Failed to open playback file:" << filename;
         return false;
     }
-
-    WavHeader header;
-    if (!readWavHeader(file, header)) {
-        fclose(file);
+    const WavReader::Format& format = source->format();
+    int channels = format.channels;
+    int fileRate = format.sampleRate;
+    if (!mixer_.start(id, std::move(source), options)) {
         return false;
     }
-
-    // Read initial buffer
-    playback_.buffer.resize(1024 * header.numChannels); // Buffer for 1024 frames
-    size_t read = fread(playback_.buffer.data(), sizeof(float), playback_.buffer.size(), file);
-    if (read < playback_.buffer.size()) {
-        playback_.buffer.resize(read);
-    }
-
-    playback_.file = file;
-    playback_.header = header;
-    playback_.bufferPos = 0;
-    playback_.active = true;
-    playback_.id = id;
+    diskThread_->wake();
     qDebug() << "AudioProcessor: Started playback for:" << filename << "ID:" << id
-             << "Channels:" << header.numChannels << "SampleRate:" << header.sampleRate;
+             << "Channels:" << channels << "SampleRate:" << fileRate << "->" << streamRate_;
     return true;
 }
 
-bool AudioProcessor::startRecording(const QString& filename, int channels, int sampleRate) {
-    stopRecording();
-
-    FILE* file = fopen(filename.toStdString().c_str(), "wb");
-    if (!file) {
-        qDebug() << "AudioProcessor: Failed to open recording file:" << filename;
+bool AudioProcessor::startTone(int id, double frequency, double amplitude, double seconds,
+                               const PlaybackMixer::Options& options) {
+    uint64_t frames = static_cast<uint64_t>(seconds * streamRate_);
+    std::unique_ptr<PlaybackSource> source(new TonePlaybackSource(frequency, amplitude, streamRate_, frames));
+    if (!mixer_.start(id, std::move(source), options)) {
         return false;
     }
+    diskThread_->wake();
+    qDebug() << "AudioProcessor: Started" << frequency << "Hz tone for ID:" << id;
+    return true;
+}
 
-    if (!writeWavHeader(file, channels, sampleRate)) {
-        fclose(file);
+bool AudioProcessor::startRecording(const QString& filename, int channels, int sampleRate,
+                                    WavRecorder::Encoding encoding) {
+    WavRecorder::Format format;
+    format.channels = channels;
+    format.sampleRate = sampleRate;
+    format.encoding = encoding;
+    format.inputRate = streamRate_;
+    format.quality = RECORDING_QUALITY;
+    if (!recorder_.start(filename, format)) {
+        qDebug() << "AudioProcessor: Failed to start recording to:" << filename;
         return false;
     }
-
-    recordingFile_ = file;
-    recordingHeader_.numChannels = channels;
-    recordingHeader_.sampleRate = sampleRate;
-    recordingHeader_.bitsPerSample = 16;
     qDebug() << "AudioProcessor: Started recording to:" << filename
-             << "Channels:" << channels << "SampleRate:" << sampleRate;
+             << "Channels:" << channels << "SampleRate:" << sampleRate << "from" << streamRate_;
     return true;
 }
 
 void AudioProcessor::stopPlayback(int id) {
-    if (playback_.active && playback_.file && playback_.id == id) {
-        fclose(playback_.file);
-        playback_.file = nullptr;
-        playback_.buffer.clear();
-        playback_.bufferPos = 0;
-        playback_.active = false;
-        playback_.id = -1;
+    if (mixer_.stop(id)) {
         qDebug() << "AudioProcessor: Stopped playback for ID:" << id;
     }
 }
 
 void AudioProcessor::stopRecording() {
-    if (recordingFile_) {
-        // Update WAV header with data size
-        long dataSize = ftell(recordingFile_) - sizeof(WavHeader);
-        recordingHeader_.subchunk2Size = dataSize;
-        recordingHeader_.chunkSize = 36 + dataSize;
-        rewind(recordingFile_);
-        fwrite(&recordingHeader_, sizeof(WavHeader), 1, recordingFile_);
-        fclose(recordingFile_);
-        recordingFile_ = nullptr;
+    if (recorder_.isRecording()) {
+        recorder_.stop();
         qDebug() << "AudioProcessor: Stopped recording";
     }
 }
 
+void AudioProcessor::setPlaybackGain(int id, double gain) {
+    mixer_.setGain(id, static_cast<float>(gain));
+}
+
 void AudioProcessor::setPreamp(double gain) {
-    preampGain_ = gain;
+    preampGain_.store(static_cast<float>(gain), std::memory_order_relaxed);
     qDebug() << "AudioProcessor: Preamp gain set to:" << gain;
 }
 
-int AudioProcessor::processAudio(float* input, float* output, unsigned long frameCount) {
-    if (!output) return 0;
+quint64 AudioProcessor::getPlaybackClock() const {
+    return mixer_.now();
+}
 
-    // Playback
-    if (playback_.active && playback_.file) {
-        size_t framesNeeded = frameCount * playback_.header.numChannels;
-        size_t framesAvailable = playback_.buffer.size() - playback_.bufferPos;
-        if (framesAvailable < framesNeeded) {
-            // Refill buffer
-            memmove(playback_.buffer.data(), playback_.buffer.data() + playback_.bufferPos, framesAvailable * sizeof(float));
-            playback_.buffer.resize(framesAvailable + 1024 * playback_.header.numChannels);
-            size_t read = fread(playback_.buffer.data() + framesAvailable, sizeof(float),
-                               playback_.buffer.size() - framesAvailable, playback_.file);
-            playback_.buffer.resize(framesAvailable + read);
-            playback_.bufferPos = 0;
-            framesAvailable = playback_.buffer.size();
-        }
+quint64 AudioProcessor::getPlaybackUnderruns() const {
+    return mixer_.underruns();
+}
 
-        for (unsigned long i = 0; i < framesNeeded && i < framesAvailable; ++i) {
-            output[i] += playback_.buffer[playback_.bufferPos + i] * preampGain_;
-        }
-        playback_.bufferPos += framesNeeded;
-        if (playback_.bufferPos >= playback_.buffer.size()) {
-            stopPlayback(playback_.id); // End of file
-        }
-    }
+quint64 AudioProcessor::getRecordingDropped() const {
+    return recorder_.droppedFrames();
+}
 
-    // Recording
-    if (recordingFile_ && input) {
-        fwrite(input, sizeof(float), frameCount * recordingHeader_.numChannels, recordingFile_);
+// Real-time: the mixer and recorder only touch their rings and atomics; no
+// locks, allocation or system calls.
+int AudioProcessor::processAudio(const float* input, int inputChannels, float* output,
+                                 unsigned long frameCount) {
+    if (!output) return 0;
+    mixer_.mix(output, frameCount, preampGain_.load(std::memory_order_relaxed));
+    // Recording; a no-op unless the recorder is running.
+    if (input && inputChannels > 0) {
+        recorder_.write(input, frameCount, inputChannels);
     }
-
     return 0; // Continue processing
 }
@@ -72,10 +72,9 @@ void Console::setMode(const QString& mode) {
     QStringList validModes = {"1", "2", "3", "6"}; // LSB, USB, AM, CW
     if (validModes.contains(mode)) {
         rx1DSPMode_ = mode;
-        qDebug() << "Radio mode set to:" << mode << "("
-                 << (mode == "1" ? "LSB" : mode == "2" ? "USB" : mode == "3" ? "AM" : "CW") << ")";
-        // Placeholder: Future WDSP integration
-        // SetRXMode(channel(), mode.toInt());
+        QString name = mode == "1" ? "LSB" : mode == "2" ? "USB" : mode == "3" ? "AM" : "CW";
+        qDebug() << "Radio mode set to:" << mode << "(" << name << ")";
+        emit rxModeChanged(name);
     } else {
         qDebug() << "Invalid radio mode:" << mode;
     }
@@ -85,8 +84,7 @@ void Console::setFilterBandwidth(int bandwidth) {
     if (bandwidth >= 100 && bandwidth <= 10000) { // Validate 100–10000 Hz
         filterBandwidth_ = bandwidth;
         qDebug() << "Filter bandwidth set to:" << bandwidth << "Hz";
-        // Placeholder: Future WDSP integration
-        // SetRXFilter(channel(), bandwidth);
+        emit filterBandwidthChanged(bandwidth);
     } else {
         qDebug() << "Invalid filter bandwidth:" << bandwidth;
     }
@@ -0,0 +1,428 @@
+#include <Decimator.h>
+#include <DspKernels.h>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Filter tables for one CIC ratio. Half-band tables hold only the non-zero
+// outer taps (every other tap of the full filter); the centre tap is 0.5.
+struct Decimator::Design {
+    std::vector<float> wideTaps;  // 19-tap half-band, early stages of ratios 4 and 8
+    std::vector<float> finalTaps; // 63-tap half-band, flat to 0.42 of its output rate
+    std::vector<float> compTaps;  // CIC droop compensation, ratio >= 16
+};
+
+namespace {
+
+const int WIDE_HALFBAND_TAPS = 19;
+const int FINAL_HALFBAND_TAPS = 63;
+const int COMP_TAPS = 31;
+const int MIN_CIC_RATIO = 16;
+const double HALFBAND_BETA = 8.0;  // Kaiser beta, ~80 dB stopband
+const double COMP_BETA = 6.0;
+// Final passband edge as a fraction of the final stage's input rate.
+const double PASSBAND_EDGE = 0.21;
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+double kaiser(int n, int length, double beta) {
+    double r = 2.0 * n / (length - 1) - 1.0;
+    return besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+}
+
+// Windowed-sinc half-band with 4K+3 taps; returns the 2K+2 non-zero outer
+// taps, normalised so the filter has unity DC gain.
+std::vector<float> designHalfband(int length, double beta) {
+    int centre = (length - 1) / 2;
+    std::vector<double> outer;
+    double sum = 0.0;
+    for (int n = 0; n < length; n += 2) {
+        double t = 0.5 * (n - centre);
+        double h = 0.5 * std::sin(M_PI * t) / (M_PI * t) * kaiser(n, length, beta);
+        outer.push_back(h);
+        sum += h;
+    }
+    std::vector<float> taps;
+    for (double h : outer) taps.push_back(static_cast<float>(h * 0.5 / sum));
+    return taps;
+}
+
+// Magnitude of an order-N CIC decimating by r, at f cycles per CIC output sample.
+double cicResponse(double f, int r) {
+    if (f == 0.0) return 1.0;
+    double x = std::sin(M_PI * f) / (r * std::sin(M_PI * f / r));
+    return std::pow(std::fabs(x), Decimator::CIC_ORDER);
+}
+
+// Linear-phase FIR at the CIC output rate: inverse CIC response up to the
+// passband edge, raised-cosine roll-off, zero beyond stopStart. Designed by
+// frequency sampling and Kaiser-windowed.
+std::vector<float> designCompensator(int cicRatio) {
+    const int grid = 2048;
+    double passEdge = PASSBAND_EDGE / 2.0; // Final stage runs at half this rate
+    // Margins keep the windowed roll-off clear of the passband edge and put
+    // 0.5 - passEdge (which folds onto the passband) deep in the stopband.
+    double rollOff = passEdge + 0.03;
+    double stopStart = 0.5 - passEdge - 0.06;
+    int centre = (COMP_TAPS - 1) / 2;
+    std::vector<double> taps(COMP_TAPS, 0.0);
+    for (int g = 0; g <= grid; ++g) {
+        double f = 0.5 * g / grid;
+        double a;
+        if (f <= rollOff) {
+            a = 1.0 / cicResponse(f, cicRatio);
+        } else if (f < stopStart) {
+            double edge = 1.0 / cicResponse(rollOff, cicRatio);
+            a = edge * 0.5 * (1.0 + std::cos(M_PI * (f - rollOff) / (stopStart - rollOff)));
+        } else {
+            a = 0.0;
+        }
+        double weight = (g == 0 || g == grid) ? 0.5 : 1.0; // Trapezoid rule
+        for (int n = 0; n < COMP_TAPS; ++n) {
+            taps[n] += weight * a * std::cos(2.0 * M_PI * f * (n - centre));
+        }
+    }
+    double sum = 0.0;
+    for (int n = 0; n < COMP_TAPS; ++n) {
+        taps[n] *= kaiser(n, COMP_TAPS, COMP_BETA);
+        sum += taps[n];
+    }
+    std::vector<float> result;
+    for (double h : taps) result.push_back(static_cast<float>(h / sum));
+    return result;
+}
+
+const Decimator::Design* designFor(int ratio) {
+    static std::mutex mutex;
+    static std::map<int, std::unique_ptr<Decimator::Design>> designs;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = designs.find(ratio);
+    if (it != designs.end()) return it->second.get();
+
+    std::unique_ptr<Decimator::Design> design(new Decimator::Design);
+    design->wideTaps = designHalfband(WIDE_HALFBAND_TAPS, HALFBAND_BETA);
+    design->finalTaps = designHalfband(FINAL_HALFBAND_TAPS, HALFBAND_BETA);
+    if (ratio >= MIN_CIC_RATIO) {
+        design->compTaps = designCompensator(ratio / 4);
+    }
+    const Decimator::Design* result = design.get();
+    designs.emplace(ratio, std::move(design));
+    return result;
+}
+
+} // namespace
+
+// ---- CIC ----
+
+void Decimator::CicStage::setup(int r) {
+    ratio = r;
+    // Headroom: full scale grows by r^N through the integrators, so +/-1.0
+    // gets 62 - N*log2(r) fraction bits and the output stays below 2^62.
+    int growthBits = 0;
+    while ((1 << growthBits) < r) ++growthBits;
+    int fractionBits = 62 - CIC_ORDER * growthBits;
+    double scale = std::ldexp(1.0, fractionBits);
+    double gain = std::pow(static_cast<double>(r), CIC_ORDER);
+    inputScale = static_cast<float>(scale);
+    outputScale = static_cast<float>(1.0 / (scale * gain));
+    clipped = 0;
+    reset();
+}
+
+void Decimator::CicStage::reset() {
+    phase = 0;
+    for (int c = 0; c < 2; ++c) {
+        for (int k = 0; k < CIC_ORDER; ++k) {
+            integrators[c][k] = 0;
+            combs[c][k] = 0;
+        }
+    }
+}
+
+int Decimator::CicStage::process(const float* inI, const float* inQ, int n,
+                                 float* outI, float* outQ) {
+    int produced = 0;
+    for (int i = 0; i < n; ++i) {
+        // Beyond full scale (or NaN) the integrators would wrap past what
+        // the combs can undo, so clip instead.
+        float in[2] = {inI[i], inQ[i]};
+        for (int c = 0; c < 2; ++c) {
+            if (!(std::fabs(in[c]) <= 1.0f)) {
+                in[c] = in[c] > 0.0f ? 1.0f : -1.0f;
+                ++clipped;
+            }
+        }
+        // Unsigned arithmetic wraps by definition; the comb differences undo it.
+        uint64_t x[2] = {static_cast<uint64_t>(std::llrint(in[0] * inputScale)),
+                         static_cast<uint64_t>(std::llrint(in[1] * inputScale))};
+        for (int c = 0; c < 2; ++c) {
+            uint64_t acc = x[c];
+            for (int k = 0; k < CIC_ORDER; ++k) {
+                integrators[c][k] += acc;
+                acc = integrators[c][k];
+            }
+        }
+        // Keep the first input of each group, like the half-bands, so the
+        // output timing is exactly groupDelaySamples() behind the input.
+        bool keep = phase == 0;
+        phase = phase + 1 == ratio ? 0 : phase + 1;
+        if (!keep) continue;
+        float out[2];
+        for (int c = 0; c < 2; ++c) {
+            uint64_t acc = integrators[c][CIC_ORDER - 1];
+            for (int k = 0; k < CIC_ORDER; ++k) {
+                uint64_t previous = combs[c][k];
+                combs[c][k] = acc;
+                acc -= previous;
+            }
+            out[c] = static_cast<float>(static_cast<int64_t>(acc)) * outputScale;
+        }
+        outI[produced] = out[0];
+        outQ[produced] = out[1];
+        ++produced;
+    }
+    return produced;
+}
+
+// ---- Dense FIR ----
+
+void Decimator::FirStage::setup(const std::vector<float>* t, int f) {
+    taps = t;
+    factor = f;
+    historyI.assign(2 * taps->size(), 0.0f);
+    historyQ.assign(2 * taps->size(), 0.0f);
+    reset();
+}
+
+void Decimator::FirStage::reset() {
+    std::fill(historyI.begin(), historyI.end(), 0.0f);
+    std::fill(historyQ.begin(), historyQ.end(), 0.0f);
+    phase = 0;
+    index = 0;
+}
+
+int Decimator::FirStage::process(const float* inI, const float* inQ, int n,
+                                 float* outI, float* outQ) {
+    int length = static_cast<int>(taps->size());
+    int produced = 0;
+    for (int i = 0; i < n; ++i) {
+        // Newest sample first: window[k] = x[n - k], matching the symmetric taps.
+        index = index == 0 ? length - 1 : index - 1;
+        historyI[index] = historyI[index + length] = inI[i];
+        historyQ[index] = historyQ[index + length] = inQ[i];
+        bool keep = phase == 0;
+        phase = phase + 1 == factor ? 0 : phase + 1;
+        if (!keep) continue;
+        float sums[2];
+        DspKernels::dualDotProduct(taps->data(), historyI.data() + index,
+                                   historyQ.data() + index, length, sums);
+        outI[produced] = sums[0];
+        outQ[produced] = sums[1];
+        ++produced;
+    }
+    return produced;
+}
+
+// ---- Half-band ----
+
+void Decimator::HalfbandStage::setup(const std::vector<float>* t) {
+    taps = t;
+    int length = static_cast<int>(taps->size()); // 2K+2
+    delay = length / 2;                          // K+1
+    historyI.assign(2 * length, 0.0f);
+    historyQ.assign(2 * length, 0.0f);
+    oddI.assign(delay, 0.0f);
+    oddQ.assign(delay, 0.0f);
+    reset();
+}
+
+void Decimator::HalfbandStage::reset() {
+    std::fill(historyI.begin(), historyI.end(), 0.0f);
+    std::fill(historyQ.begin(), historyQ.end(), 0.0f);
+    std::fill(oddI.begin(), oddI.end(), 0.0f);
+    std::fill(oddQ.begin(), oddQ.end(), 0.0f);
+    odd = false;
+    index = 0;
+    oddIndex = 0;
+}
+
+int Decimator::HalfbandStage::process(const float* inI, const float* inQ, int n,
+                                      float* outI, float* outQ) {
+    int length = static_cast<int>(taps->size());
+    int produced = 0;
+    for (int i = 0; i < n; ++i) {
+        if (odd) {
+            // Odd inputs only reach the output through the centre tap.
+            oddI[oddIndex] = inI[i];
+            oddQ[oddIndex] = inQ[i];
+            oddIndex = oddIndex + 1 == delay ? 0 : oddIndex + 1;
+            odd = false;
+            continue;
+        }
+        odd = true;
+        index = index == 0 ? length - 1 : index - 1;
+        historyI[index] = historyI[index + length] = inI[i];
+        historyQ[index] = historyQ[index + length] = inQ[i];
+        float sums[2];
+        DspKernels::dualDotProduct(taps->data(), historyI.data() + index,
+                                   historyQ.data() + index, length, sums);
+        // oddIndex now points at the oldest odd sample, K+1 pairs back.
+        outI[produced] = sums[0] + 0.5f * oddI[oddIndex];
+        outQ[produced] = sums[1] + 0.5f * oddQ[oddIndex];
+        ++produced;
+    }
+    return produced;
+}
+
+// ---- Decimator ----
+
+Decimator::Decimator()
+    : inputRate_(48000),
+      outputRate_(48000),
+      ratio_(1),
+      groupDelayInput_(0.0),
+      design_(nullptr),
+      useCic_(false),
+      useComp_(false),
+      wideStages_(0),
+      useFinal_(false) {
+    for (int b = 0; b < 2; ++b) {
+        bufI_[b].resize(BLOCK_SIZE);
+        bufQ_[b].resize(BLOCK_SIZE);
+    }
+}
+
+Decimator::~Decimator() {
+}
+
+bool Decimator::configure(int inputRate, int outputRate) {
+    if (inputRate <= 0 || outputRate <= 0 || inputRate % outputRate != 0) {
+        qDebug() << "Decimator: Unsupported rates" << inputRate << "->" << outputRate;
+        return false;
+    }
+    int ratio = inputRate / outputRate;
+    if (ratio > MAX_RATIO || (ratio & (ratio - 1)) != 0) {
+        qDebug() << "Decimator: Ratio" << ratio << "is not a power of two up to" << MAX_RATIO;
+        return false;
+    }
+
+    inputRate_ = inputRate;
+    outputRate_ = outputRate;
+    ratio_ = ratio;
+    design_ = designFor(ratio);
+    useCic_ = ratio >= MIN_CIC_RATIO;
+    useComp_ = useCic_;
+    wideStages_ = useCic_ || ratio < 4 ? 0 : (ratio == 4 ? 1 : 2);
+    useFinal_ = ratio >= 2;
+
+    // Group delay of each stage in its own input samples, scaled to the
+    // chain's input rate by the decimation ahead of it.
+    groupDelayInput_ = 0.0;
+    int ahead = 1;
+    if (useCic_) {
+        int r = ratio / 4;
+        cic_.setup(r);
+        groupDelayInput_ += CIC_ORDER * (r - 1) / 2.0;
+        ahead *= r;
+    }
+    if (useComp_) {
+        comp_.setup(&design_->compTaps, 2);
+        groupDelayInput_ += ahead * (design_->compTaps.size() - 1) / 2.0;
+        ahead *= 2;
+    }
+    for (int w = 0; w < wideStages_; ++w) {
+        wide_[w].setup(&design_->wideTaps);
+        groupDelayInput_ += ahead * (WIDE_HALFBAND_TAPS - 1) / 2.0;
+        ahead *= 2;
+    }
+    if (useFinal_) {
+        final_.setup(&design_->finalTaps);
+        groupDelayInput_ += ahead * (FINAL_HALFBAND_TAPS - 1) / 2.0;
+    }
+    qDebug() << "Decimator: Configured" << inputRate << "->" << outputRate << "ratio:" << ratio
+             << "group delay:" << groupDelaySamples() << "samples";
+    return true;
+}
+
+void Decimator::reset() {
+    cic_.reset();
+    comp_.reset();
+    for (HalfbandStage& stage : wide_) stage.reset();
+    final_.reset();
+}
+
+int Decimator::inputRate() const {
+    return inputRate_;
+}
+
+int Decimator::outputRate() const {
+    return outputRate_;
+}
+
+int Decimator::ratio() const {
+    return ratio_;
+}
+
+double Decimator::groupDelaySamples() const {
+    return groupDelayInput_ / ratio_;
+}
+
+double Decimator::groupDelaySeconds() const {
+    return groupDelayInput_ / inputRate_;
+}
+
+int Decimator::maxOutput(int inputCount) const {
+    return inputCount / ratio_ + 1;
+}
+
+uint64_t Decimator::clippedSamples() const {
+    return useCic_ ? cic_.clipped : 0;
+}
+
+int Decimator::process(const float* iq, int count, float* out) {
+    int produced = 0;
+    while (count > 0) {
+        int n = std::min(count, static_cast<int>(BLOCK_SIZE));
+        float* i0 = bufI_[0].data();
+        float* q0 = bufQ_[0].data();
+        for (int k = 0; k < n; ++k) {
+            i0[k] = iq[2 * k];
+            q0[k] = iq[2 * k + 1];
+        }
+        // Ping-pong between the two scratch buffers; every stage shrinks n.
+        int cur = 0;
+        auto run = [&](auto& stage) {
+            n = stage.process(bufI_[cur].data(), bufQ_[cur].data(), n,
+                              bufI_[cur ^ 1].data(), bufQ_[cur ^ 1].data());
+            cur ^= 1;
+        };
+        if (useCic_) run(cic_);
+        if (useComp_) run(comp_);
+        for (int w = 0; w < wideStages_; ++w) run(wide_[w]);
+        if (useFinal_) run(final_);
+
+        const float* outI = bufI_[cur].data();
+        const float* outQ = bufQ_[cur].data();
+        for (int k = 0; k < n; ++k) {
+            out[2 * (produced + k)] = outI[k];
+            out[2 * (produced + k) + 1] = outQ[k];
+        }
+        produced += n;
+        int consumed = std::min(count, static_cast<int>(BLOCK_SIZE));
+        iq += 2 * consumed;
+        count -= consumed;
+    }
+    return produced;
+}
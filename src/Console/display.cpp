@@ -1,151 +1,239 @@
 #include <Display.h>
 #include <Console.h>
+#include <Logging.h>
 #include <QPainter>
-#include <QPainterPath>
 #include <QMouseEvent>
+#include <QResizeEvent>
 #include <QVBoxLayout>
 #include <QDebug>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 
 SpectrumWidget::SpectrumWidget(QWidget* parent)
     : QWidget(parent),
+      image_(nullptr),
       centerFrequency_(14.0e6),
       bandwidth_(96000) {
     setMinimumSize(400, 200);
 }
 
-void SpectrumWidget::setData(const std::vector<float>& data, double centerFreq, int bandwidth) {
-    spectrumData_.resize(data.size());
-    // Shift and scale to -120 to 0 dB
-    if (!data.empty()) {
-        float minVal = *std::min_element(data.begin(), data.end());
-        float maxVal = *std::max_element(data.begin(), data.end());
-        float offset = maxVal; // Shift to make max 0 dB
-        for (size_t i = 0; i < data.size(); ++i) {
-            spectrumData_[i] = data[i] - offset;
-            spectrumData_[i] = std::max(-120.0f, std::min(0.0f, spectrumData_[i]));
-        }
-        qDebug() << "SpectrumWidget: Raw data min:" << minVal << "max:" << maxVal;
-    } else {
-        spectrumData_.clear();
-    }
+void SpectrumWidget::setImage(const QImage* image) {
+    image_ = image;
+    update();
+}
+
+void SpectrumWidget::setView(double centerFreq, int bandwidth) {
     centerFrequency_ = centerFreq;
     bandwidth_ = bandwidth;
-    if (!spectrumData_.empty()) {
-        auto [minIt, maxIt] = std::minmax_element(spectrumData_.begin(), spectrumData_.end());
-        qDebug() << "SpectrumWidget: Data size:" << spectrumData_.size()
-                 << "min:" << *minIt << "max:" << *maxIt;
-    } else {
-        qDebug() << "SpectrumWidget: Received empty data";
-    }
-    update();
 }
 
 void SpectrumWidget::paintEvent(QPaintEvent* event) {
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.fillRect(rect(), Qt::white);
-
-    if (spectrumData_.empty() || spectrumData_.size() < 2) {
-        std::vector<float> simData(1024, -80.0f);
-        for (size_t i = 0; i < simData.size(); ++i) {
-            simData[i] = -80.0f + 40.0f * (sin(2 * M_PI * i / simData.size()) + 1.0f) / 2.0f;
-        }
-        spectrumData_ = simData;
-        qDebug() << "SpectrumWidget: Using simulated spectrum data";
+    if (!image_ || image_->isNull()) {
+        painter.fillRect(rect(), Qt::white);
+        return;
+    }
+    // Right after a resize the image may still have the old size.
+    painter.drawImage(0, 0, *image_);
+    if (image_->width() < width() || image_->height() < height()) {
+        painter.fillRect(QRect(image_->width(), 0, width() - image_->width(), height()), Qt::white);
+        painter.fillRect(QRect(0, image_->height(), image_->width(), height() - image_->height()), Qt::white);
     }
+    THETIS_TRACE("display.paint", image_->width(), image_->height());
+}
 
-    painter.setPen(Qt::lightGray);
-    int width = this->width();
-    int height = this->height();
-    for (int x = 0; x <= width; x += width / 10) {
-        painter.drawLine(x, 0, x, height);
+void SpectrumWidget::mousePressEvent(QMouseEvent* event) {
+    double x = event->pos().x();
+    double width = static_cast<double>(this->width());
+    double freq = centerFrequency_ - bandwidth_ / 2.0 + (x / width) * bandwidth_;
+    emit frequencySelected(freq);
+    qDebug() << "SpectrumWidget: Frequency selected at" << freq << "Hz";
+}
+
+WaterfallWidget::WaterfallWidget(QWidget* parent)
+    : QWidget(parent),
+      newestRow_(0),
+      centerFrequency_(14.0e6),
+      bandwidth_(96000) {
+    setMinimumSize(400, 150);
+}
+
+void WaterfallWidget::resetImage() {
+    image_ = QImage(std::max(1, width()), std::max(1, height()), QImage::Format_RGB32);
+    image_.fill(Qt::black);
+    newestRow_ = 0;
+}
+
+void WaterfallWidget::setView(double centerFreq, int bandwidth) {
+    centerFrequency_ = centerFreq;
+    bandwidth_ = bandwidth;
+}
+
+void WaterfallWidget::addLine(const QRgb* line, int count) {
+    if (image_.isNull() || image_.width() != width() || image_.height() != height()) {
+        resetImage();
     }
-    for (int y = 0; y <= height; y += height / 6) {
-        painter.drawLine(0, y, width, y);
+    newestRow_ = newestRow_ == 0 ? image_.height() - 1 : newestRow_ - 1;
+    uchar* row = image_.scanLine(newestRow_);
+    int copied = std::min(count, image_.width());
+    std::memcpy(row, line, copied * sizeof(QRgb));
+    if (copied < image_.width()) {
+        std::memset(row + copied * sizeof(QRgb), 0, (image_.width() - copied) * sizeof(QRgb));
     }
+    update();
+}
 
-    painter.setPen(QPen(Qt::blue, 2));
-    QPainterPath path;
-    double xStep = static_cast<double>(width) / (spectrumData_.size() - 1);
-    for (size_t i = 0; i < spectrumData_.size(); ++i) {
-        float y = spectrumData_[i];
-        int yPos = static_cast<int>((0.0f - y) / 120.0f * height); // Adjusted for -120 dB
-        yPos = std::max(0, std::min(height, yPos));
-        double x = i * xStep;
-        if (i == 0) {
-            path.moveTo(x, yPos);
-        } else {
-            path.lineTo(x, yPos);
-        }
-        if (i < 20 || i > spectrumData_.size() - 20 || y > -20) {
-            qDebug() << "SpectrumWidget: Plot point[" << i << "] x:" << x << "y:" << yPos << "dB:" << y;
-        }
+void WaterfallWidget::paintEvent(QPaintEvent* event) {
+    QPainter painter(this);
+    if (image_.isNull()) {
+        painter.fillRect(rect(), Qt::black);
+        return;
     }
+    // Rows newestRow_..end are the most recent lines; 0..newestRow_-1 are older.
+    int rows = image_.height();
+    int top = rows - newestRow_;
+    painter.drawImage(0, 0, image_, 0, newestRow_, image_.width(), top);
+    if (newestRow_ > 0) {
+        painter.drawImage(0, top, image_, 0, 0, image_.width(), newestRow_);
+    }
+    THETIS_TRACE("display.waterfall", rows, newestRow_);
+}
 
-    painter.drawPath(path);
-
-    painter.setPen(Qt::black);
-    painter.setFont(QFont("Arial", 8));
-    double freqMin = centerFrequency_ - bandwidth_ / 2.0;
-    double freqMax = centerFrequency_ + bandwidth_ / 2.0;
-    painter.drawText(QRectF(0, height - 20, 60, 20),
-                     QString("%1 MHz").arg(freqMin / 1e6, 0, 'f', 3));
-    painter.drawText(QRectF(width - 60, height - 20, 60, 20),
-                     QString("%1 MHz").arg(freqMax / 1e6, 0, 'f', 3));
-    painter.drawText(QRectF(0, 0, 50, 20), "0 dB");
-    painter.drawText(QRectF(0, height - 20, 50, 20), "-120 dB");
+void WaterfallWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    resetImage();
 }
 
-void SpectrumWidget::mousePressEvent(QMouseEvent* event) {
+void WaterfallWidget::mousePressEvent(QMouseEvent* event) {
     double x = event->pos().x();
     double width = static_cast<double>(this->width());
     double freq = centerFrequency_ - bandwidth_ / 2.0 + (x / width) * bandwidth_;
     emit frequencySelected(freq);
-    qDebug() << "SpectrumWidget: Frequency selected at" << freq << "Hz";
+    qDebug() << "WaterfallWidget: Frequency selected at" << freq << "Hz";
 }
 
 Display::Display(Console* palette, QWidget* parent)
     : QWidget(parent),
       palette_(palette),
       spectrumWidget_(new SpectrumWidget(this)),
+      waterfallWidget_(new WaterfallWidget(this)),
+      renderer_(new SpectrumRenderer(this)),
       centerFrequency_(14.0e6),
       bandwidth_(96000) {
     QVBoxLayout* layout = new QVBoxLayout(this);
-    layout->addWidget(spectrumWidget_);
+    layout->addWidget(spectrumWidget_, 1);
+    layout->addWidget(waterfallWidget_, 1);
     setLayout(layout);
 
     connect(spectrumWidget_, &SpectrumWidget::frequencySelected,
             this, &Display::frequencyChanged);
+    connect(waterfallWidget_, &WaterfallWidget::frequencySelected,
+            this, &Display::frequencyChanged);
+    connect(renderer_, &SpectrumRenderer::resultReady,
+            this, &Display::applyRenderResult, Qt::QueuedConnection);
+    view_.centerFrequency = centerFrequency_;
+    view_.span = bandwidth_;
+    renderer_->setView(view_);
+    renderer_->start(QThread::LowPriority);
 
     qDebug() << "Display initialized with center frequency:" << centerFrequency_
              << "Hz, bandwidth:" << bandwidth_ << "Hz";
 }
 
 Display::~Display() {
+    renderer_->requestStop();
+    renderer_->wait();
     qDebug() << "Display destroyed";
 }
 
+void Display::pushView() {
+    view_.centerFrequency = centerFrequency_;
+    view_.span = bandwidth_;
+    spectrumWidget_->setView(centerFrequency_, bandwidth_);
+    waterfallWidget_->setView(centerFrequency_, bandwidth_);
+    renderer_->setView(view_);
+}
+
 void Display::setCenterFrequency(double freq) {
     centerFrequency_ = freq;
-    spectrumWidget_->setData(spectrumData_, centerFrequency_, bandwidth_);
+    pushView();
     qDebug() << "Display: Center frequency set to" << freq << "Hz";
 }
 
+void Display::setTraceStyle(SpectrumWidget::TraceStyle style) {
+    view_.style = style;
+    pushView();
+    qDebug() << "Display: Trace style set to" << static_cast<int>(style);
+}
+
 void Display::setBandwidth(int bw) {
     bandwidth_ = bw;
-    spectrumWidget_->setData(spectrumData_, centerFrequency_, bandwidth_);
+    pushView();
     qDebug() << "Display: Bandwidth set to" << bw << "Hz";
 }
 
-void Display::updateSpectrum(const float* data, int size) {
-    qDebug() << "Display: Received spectrum data, size:" << size;
-    if (size <= 0) {
-        qDebug() << "Display: Invalid spectrum data size";
+void Display::setSpectrumRange(float topDb, float rangeDb) {
+    if (rangeDb <= 0.0f) {
+        qDebug() << "Display: Invalid spectrum range" << rangeDb;
+        return;
+    }
+    view_.autoReference = false;
+    view_.topDb = topDb;
+    view_.rangeDb = rangeDb;
+    pushView();
+    qDebug() << "Display: Spectrum range" << topDb << "dB, span" << rangeDb << "dB";
+}
+
+void Display::setAutoReference(bool enabled) {
+    view_.autoReference = enabled;
+    pushView();
+}
+
+void Display::setWaterfallLevels(float floorDb, float ceilingDb) {
+    if (ceilingDb <= floorDb) {
+        qDebug() << "Display: Invalid waterfall levels" << floorDb << ceilingDb;
+        return;
+    }
+    view_.waterfallFloorDb = floorDb;
+    view_.waterfallCeilingDb = ceilingDb;
+    pushView();
+    qDebug() << "Display: Waterfall levels set to" << floorDb << "to" << ceilingDb << "dB";
+}
+
+// GUI thread: hands the frame to the renderer; no drawing happens here.
+void Display::updateSpectrum(const SpectrumFrameRef& frame) {
+    if (!frame || frame->size() <= 0) {
+        THETIS_WARNING_EVERY_MS(lcDisplay, 1000) << "Display: Invalid spectrum frame";
         return;
     }
-    spectrumData_.assign(data, data + size);
-    spectrumWidget_->setData(spectrumData_, centerFrequency_, bandwidth_);
-    qDebug() << "Display: Spectrum updated with" << size << "points";
+    if (view_.width != spectrumWidget_->width() || view_.height != spectrumWidget_->height() ||
+        view_.waterfallWidth != waterfallWidget_->width()) {
+        view_.width = spectrumWidget_->width();
+        view_.height = spectrumWidget_->height();
+        view_.waterfallWidth = waterfallWidget_->width();
+        renderer_->setView(view_);
+    }
+    // Follow the span the frame actually covers, so click-to-tune maps
+    // pixels to the same frequencies the bins were computed for.
+    int span = static_cast<int>(frame->span());
+    if (span > 0 && (frame->centerFrequency() != centerFrequency_ || span != bandwidth_)) {
+        centerFrequency_ = frame->centerFrequency();
+        bandwidth_ = span;
+        pushView();
+        qDebug() << "Display: View follows the spectrum," << centerFrequency_ << "Hz centre," << span << "Hz span";
+    }
+    renderer_->submit(frame);
+    THETIS_DEBUG_EVERY_MS(lcDisplay, 1000) << "Display: Spectrum submitted with" << frame->size()
+                                           << "points, last render" << renderer_->getLastRenderMs()
+                                           << "ms";
+}
+
+// GUI thread: swap in the finished images and blit them on the next paint.
+void Display::applyRenderResult() {
+    if (!renderer_->takeResult(&front_)) return;
+    spectrumWidget_->setImage(&front_.spectrum);
+    if (!front_.waterfallLine.empty()) {
+        waterfallWidget_->addLine(front_.waterfallLine.data(), static_cast<int>(front_.waterfallLine.size()));
+    }
 }
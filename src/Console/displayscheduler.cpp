@@ -0,0 +1,73 @@
+#include <DisplayScheduler.h>
+#include <Logging.h>
+#include <QDebug>
+#include <QGuiApplication>
+#include <QScreen>
+#include <algorithm>
+#include <cmath>
+
+DisplayScheduler::DisplayScheduler(QObject* parent)
+    : QObject(parent),
+      timer_(new QTimer(this)),
+      maxFps_(0.0),
+      posted_(0),
+      shown_(0),
+      skipped_(0) {
+    timer_->setTimerType(Qt::PreciseTimer);
+    connect(timer_, &QTimer::timeout, this, &DisplayScheduler::tick);
+    setMaxFps(DEFAULT_FPS);
+    timer_->start();
+}
+
+DisplayScheduler::~DisplayScheduler() {
+    qDebug() << "DisplayScheduler destroyed, frames posted:" << getFramesPosted()
+             << "shown:" << getFramesShown() << "skipped:" << getFramesSkipped();
+}
+
+double DisplayScheduler::screenRefreshRate() {
+    QScreen* screen = QGuiApplication::primaryScreen();
+    double rate = screen ? screen->refreshRate() : 0.0;
+    return rate > 1.0 ? rate : DEFAULT_FPS;
+}
+
+void DisplayScheduler::setMaxFps(double fps) {
+    double limit = std::min(MAX_FPS, screenRefreshRate());
+    maxFps_ = std::max(1.0, std::min(fps, limit));
+    timer_->setInterval(std::max(1, static_cast<int>(std::lround(1000.0 / maxFps_))));
+    qDebug() << "DisplayScheduler: Frame rate capped at" << maxFps_ << "fps";
+}
+
+double DisplayScheduler::getMaxFps() const {
+    return maxFps_;
+}
+
+quint64 DisplayScheduler::getFramesPosted() const {
+    return posted_.load(std::memory_order_relaxed);
+}
+
+quint64 DisplayScheduler::getFramesShown() const {
+    return shown_.load(std::memory_order_relaxed);
+}
+
+quint64 DisplayScheduler::getFramesSkipped() const {
+    return skipped_.load(std::memory_order_relaxed);
+}
+
+void DisplayScheduler::post(const SpectrumFrameRef& frame) {
+    if (!frame) return;
+    posted_.fetch_add(1, std::memory_order_relaxed);
+    if (mailbox_.post(frame)) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// GUI thread: at most one frame per tick, always the newest.
+void DisplayScheduler::tick() {
+    SpectrumFrameRef frame = mailbox_.take();
+    if (!frame) return;
+    shown_.fetch_add(1, std::memory_order_relaxed);
+    THETIS_DEBUG_EVERY_MS(lcDisplay, 5000) << "DisplayScheduler: Frames posted:" << getFramesPosted()
+                                           << "shown:" << getFramesShown()
+                                           << "skipped:" << getFramesSkipped();
+    emit frameReady(frame);
+}
@@ -0,0 +1,183 @@
+#include <DriftController.h>
+#include <Logging.h>
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double clampPpm(double ppm) {
+    return std::max(-DriftController::MAX_PPM, std::min(ppm, DriftController::MAX_PPM));
+}
+
+} // namespace
+
+double DriftController::Stats::latencyMs() const {
+    return sampleRate > 0 ? 1000.0 * fillFrames / sampleRate : 0.0;
+}
+
+DriftController::DriftController()
+    : sampleRate_(0),
+      targetFrames_(0),
+      kp_(0.0),
+      ki_(0.0),
+      resampledFrames_(0),
+      resampledRead_(0),
+      locked_(false),
+      fill_(0.0),
+      integral_(0.0),
+      driftPpm_(0.0),
+      correctionPpm_(0.0),
+      fillFrames_(0.0),
+      lockedFlag_(false),
+      underruns_(0),
+      resyncs_(0),
+      droppedFrames_(0),
+      lastResyncs_(0),
+      lastUnderruns_(0) {}
+
+bool DriftController::configure(int sampleRate, int targetFrames, Resampler::Quality quality) {
+    if (sampleRate <= 0 || targetFrames <= 0 || !resampler_.configure(sampleRate, sampleRate, 1, quality)) {
+        qDebug() << "DriftController: Unsupported setup," << sampleRate << "Hz, target" << targetFrames << "frames";
+        return false;
+    }
+    sampleRate_ = sampleRate;
+    targetFrames_ = targetFrames;
+    // Critically damped: the fill error obeys e'' + 2/T e' + 1/T^2 e = 0,
+    // given that a ratio trim of u consumes u * sampleRate extra frames/s.
+    kp_ = 2.0 / (LOOP_SECONDS * sampleRate) * 1e6;
+    ki_ = 1.0 / (LOOP_SECONDS * LOOP_SECONDS * sampleRate) * 1e6;
+    resampled_.assign(resampler_.maxOutput(CHUNK_FRAMES), 0.0f);
+    integral_ = 0.0;
+    driftPpm_.store(0.0, std::memory_order_relaxed);
+    reset();
+    qDebug() << "DriftController: Holding the receive ring at" << targetFrames << "frames,"
+             << 1000.0 * targetFrames / sampleRate << "ms";
+    return true;
+}
+
+void DriftController::reset() {
+    resampler_.reset();
+    resampler_.setRatioAdjust(integral_);
+    resampledFrames_ = 0;
+    resampledRead_ = 0;
+    locked_ = false;
+    fill_ = 0.0;
+    correctionPpm_.store(integral_, std::memory_order_relaxed);
+    fillFrames_.store(0.0, std::memory_order_relaxed);
+    lockedFlag_.store(false, std::memory_order_relaxed);
+}
+
+double DriftController::driftPpm() const {
+    return driftPpm_.load(std::memory_order_relaxed);
+}
+
+// Drops ring frames until fill is back at the target.
+void DriftController::trim(AudioRingBuffer& ring, size_t fill) {
+    if (fill <= static_cast<size_t>(targetFrames_)) return;
+    size_t excess = std::min(fill - targetFrames_, ring.available());
+    ring.consume(excess);
+    droppedFrames_.fetch_add(excess, std::memory_order_relaxed);
+}
+
+void DriftController::update(AudioRingBuffer& ring, size_t frames) {
+    size_t fill = ring.available() + (resampledFrames_ - resampledRead_);
+    if (!locked_) {
+        if (fill < static_cast<size_t>(targetFrames_)) return;
+        trim(ring, fill);
+        fill_ = targetFrames_;
+        locked_ = true;
+        lockedFlag_.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    double dt = static_cast<double>(frames) / sampleRate_;
+    fill_ += (1.0 - std::exp(-dt / FILTER_SECONDS)) * (fill - fill_);
+    double error = fill_ - targetFrames_;
+    if (error > targetFrames_) {
+        THETIS_TRACE("audio.rx.resync", static_cast<int64_t>(fill), targetFrames_);
+        trim(ring, fill);
+        resyncs_.fetch_add(1, std::memory_order_relaxed);
+        fill_ = targetFrames_;
+        error = 0.0;
+    }
+    integral_ = clampPpm(integral_ + ki_ * error * dt);
+    double correction = clampPpm(kp_ * error + integral_);
+    resampler_.setRatioAdjust(correction);
+
+    driftPpm_.store(integral_, std::memory_order_relaxed);
+    correctionPpm_.store(correction, std::memory_order_relaxed);
+    fillFrames_.store(fill_, std::memory_order_relaxed);
+}
+
+size_t DriftController::pull(AudioRingBuffer& ring, float* out, size_t frames, int channels) {
+    if (targetFrames_ == 0) return 0;
+    update(ring, frames);
+    if (!locked_) return 0;
+
+    size_t done = 0;
+    while (done < frames) {
+        if (resampledRead_ < resampledFrames_) {
+            size_t n = std::min(frames - done, resampledFrames_ - resampledRead_);
+            for (size_t i = 0; i < n; ++i) {
+                float sample = resampled_[resampledRead_ + i];
+                for (int c = 0; c < channels; ++c) {
+                    out[(done + i) * channels + c] = sample;
+                }
+            }
+            resampledRead_ += n;
+            done += n;
+            continue;
+        }
+        // At a ratio within MAX_PPM of 1:1, n input frames give n +- 1
+        // output frames, so little is left over for the next callback.
+        size_t count = std::min<size_t>({frames - done, ring.available(), ring.maxWindow(),
+                                         static_cast<size_t>(CHUNK_FRAMES)});
+        const float* samples = count ? ring.peek(count) : nullptr;
+        if (!samples) break;
+        resampledFrames_ = resampler_.process(samples, count, resampled_.data());
+        resampledRead_ = 0;
+        ring.consume(count);
+    }
+    if (done < frames) {
+        // Ran dry: rebuffer to the target rather than stutter.
+        underruns_.fetch_add(1, std::memory_order_relaxed);
+        THETIS_TRACE("audio.rx.underrun", static_cast<int64_t>(done), static_cast<int64_t>(frames));
+        locked_ = false;
+        lockedFlag_.store(false, std::memory_order_relaxed);
+    }
+    return done;
+}
+
+DriftController::Stats DriftController::stats() const {
+    Stats result;
+    result.driftPpm = driftPpm_.load(std::memory_order_relaxed);
+    result.correctionPpm = correctionPpm_.load(std::memory_order_relaxed);
+    result.fillFrames = fillFrames_.load(std::memory_order_relaxed);
+    result.targetFrames = targetFrames_;
+    result.sampleRate = sampleRate_;
+    result.locked = lockedFlag_.load(std::memory_order_relaxed);
+    result.underruns = underruns_.load(std::memory_order_relaxed);
+    result.resyncs = resyncs_.load(std::memory_order_relaxed);
+    result.droppedFrames = droppedFrames_.load(std::memory_order_relaxed);
+    return result;
+}
+
+void DriftController::logSummary() {
+    Stats now = stats();
+    uint64_t resyncs = now.resyncs - lastResyncs_;
+    uint64_t underruns = now.underruns - lastUnderruns_;
+    lastResyncs_ = now.resyncs;
+    lastUnderruns_ = now.underruns;
+    if (!now.locked && underruns == 0) return;
+
+    THETIS_INFO(lcAudio).nospace()
+        << "Audio: receive clock drift " << QString::number(now.driftPpm, 'f', 2) << " ppm"
+        << "; correction " << QString::number(now.correctionPpm, 'f', 2) << " ppm"
+        << "; latency " << QString::number(now.latencyMs(), 'f', 1) << " ms (target "
+        << QString::number(1000.0 * now.targetFrames / now.sampleRate, 'f', 1) << ")";
+    if (resyncs || underruns) {
+        THETIS_WARNING(lcAudio) << "Audio: receive ring underruns" << underruns << "resyncs" << resyncs;
+    }
+}
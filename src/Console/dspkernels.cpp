@@ -0,0 +1,777 @@
+#include <DspKernels.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DSPKERNELS_X86 1
+#endif
+
+namespace {
+
+// log2(1 + t) on t in [0, 1), Chebyshev-node fit, max error 1.7e-5.
+const float LOG2_C0 = 1.6514670883351556e-05f;
+const float LOG2_C1 = 1.4414924117615537f;
+const float LOG2_C2 = -0.7064864491338083f;
+const float LOG2_C3 = 0.40947029869795765f;
+const float LOG2_C4 = -0.18748860458973862f;
+const float LOG2_C5 = 0.043004957791890897f;
+const float DB_PER_LOG2 = 3.0102999566398120f; // 10 * log10(2)
+const float POWER_FLOOR = 1e-20f;
+
+inline float fastLog2(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    float e = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    float t = m - 1.0f;
+    float p = LOG2_C5;
+    p = p * t + LOG2_C4;
+    p = p * t + LOG2_C3;
+    p = p * t + LOG2_C2;
+    p = p * t + LOG2_C1;
+    p = p * t + LOG2_C0;
+    return e + p;
+}
+
+void windowDeinterleaveScalar(const float* iq, const float* window, float gain,
+                              float* re, float* im, int n) {
+    for (int i = 0; i < n; ++i) {
+        float w = window[i] * gain;
+        re[i] = iq[2 * i] * w;
+        im[i] = iq[2 * i + 1] * w;
+    }
+}
+
+void logPowerScalar(const float* re, const float* im, float offsetDb, float* outDb, int n) {
+    for (int i = 0; i < n; ++i) {
+        float power = std::max(re[i] * re[i] + im[i] * im[i], POWER_FLOOR);
+        outDb[i] = DB_PER_LOG2 * fastLog2(power) + offsetDb;
+    }
+}
+
+void accumulatePowerScalar(const float* re, const float* im, float* acc, int n) {
+    for (int i = 0; i < n; ++i) {
+        acc[i] += re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+void accumulateScaledScalar(const float* in, float gain, float* acc, int n) {
+    for (int i = 0; i < n; ++i) {
+        acc[i] += in[i] * gain;
+    }
+}
+
+void powerToDbScalar(const float* power, float scale, float offsetDb, float* outDb, int n) {
+    for (int i = 0; i < n; ++i) {
+        outDb[i] = DB_PER_LOG2 * fastLog2(std::max(power[i] * scale, POWER_FLOOR)) + offsetDb;
+    }
+}
+
+void int24BEToFloatScalar(const uint8_t* in, float scale, float* out, int n) {
+    for (int i = 0; i < n; ++i, in += 3) {
+        // Place the 24 bits at the top of an int32, then shift back to sign-extend.
+        int32_t value = static_cast<int32_t>((static_cast<uint32_t>(in[0]) << 24) |
+                                             (static_cast<uint32_t>(in[1]) << 16) |
+                                             (static_cast<uint32_t>(in[2]) << 8)) >> 8;
+        out[i] = static_cast<float>(value) * scale;
+    }
+}
+
+// Little-endian PCM, assembled from bytes so the result does not depend on
+// host byte order or alignment.
+void int16LEToFloatScalar(const uint8_t* in, float scale, float* out, int n) {
+    for (int i = 0; i < n; ++i, in += 2) {
+        int16_t value = static_cast<int16_t>(in[0] | (in[1] << 8));
+        out[i] = static_cast<float>(value) * scale;
+    }
+}
+
+void int24LEToFloatScalar(const uint8_t* in, float scale, float* out, int n) {
+    for (int i = 0; i < n; ++i, in += 3) {
+        int32_t value = static_cast<int32_t>((static_cast<uint32_t>(in[2]) << 24) |
+                                             (static_cast<uint32_t>(in[1]) << 16) |
+                                             (static_cast<uint32_t>(in[0]) << 8)) >> 8;
+        out[i] = static_cast<float>(value) * scale;
+    }
+}
+
+void int32LEToFloatScalar(const uint8_t* in, float scale, float* out, int n) {
+    for (int i = 0; i < n; ++i, in += 4) {
+        int32_t value = static_cast<int32_t>(static_cast<uint32_t>(in[0]) |
+                                             (static_cast<uint32_t>(in[1]) << 8) |
+                                             (static_cast<uint32_t>(in[2]) << 16) |
+                                             (static_cast<uint32_t>(in[3]) << 24));
+        out[i] = static_cast<float>(value) * scale;
+    }
+}
+
+void dualDotProductScalar(const float* taps, const float* a, const float* b, int n, float* out) {
+    float sumA = 0.0f;
+    float sumB = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        sumA += taps[i] * a[i];
+        sumB += taps[i] * b[i];
+    }
+    out[0] = sumA;
+    out[1] = sumB;
+}
+
+void rangeStatsScalar(const float* in, int n, float* out) {
+    float lo = in[0];
+    float hi = in[0];
+    float sum = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        lo = in[i] < lo ? in[i] : lo;
+        hi = in[i] > hi ? in[i] : hi;
+        sum += in[i];
+    }
+    out[0] = lo;
+    out[1] = hi;
+    out[2] = sum;
+}
+
+void mixPhasorsScalar(const float* iq, const float* lanes, const float* step, float* out, int n) {
+    float re[DspKernels::MIX_LANES];
+    float im[DspKernels::MIX_LANES];
+    for (int k = 0; k < DspKernels::MIX_LANES; ++k) {
+        re[k] = lanes[2 * k];
+        im[k] = lanes[2 * k + 1];
+    }
+    for (int i = 0; i < n; i += DspKernels::MIX_LANES) {
+        int m = n - i < DspKernels::MIX_LANES ? n - i : DspKernels::MIX_LANES;
+        for (int k = 0; k < m; ++k) {
+            float x = iq[2 * (i + k)];
+            float y = iq[2 * (i + k) + 1];
+            out[2 * (i + k)] = x * re[k] - y * im[k];
+            out[2 * (i + k) + 1] = x * im[k] + y * re[k];
+        }
+        for (int k = 0; k < DspKernels::MIX_LANES; ++k) {
+            float r = re[k] * step[0] - im[k] * step[1];
+            im[k] = re[k] * step[1] + im[k] * step[0];
+            re[k] = r;
+        }
+    }
+}
+
+#ifdef DSPKERNELS_X86
+
+__attribute__((target("sse2")))
+inline __m128 log2Sse2(__m128 x) {
+    __m128i bits = _mm_castps_si128(x);
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                             _mm_set1_epi32(0x3f800000)));
+    __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+    __m128 poly = _mm_set1_ps(LOG2_C5);
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(LOG2_C4));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(LOG2_C3));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(LOG2_C2));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(LOG2_C1));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t), _mm_set1_ps(LOG2_C0));
+    return _mm_add_ps(e, poly);
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256 log2Avx2(__m256 x) {
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23),
+                                                   _mm256_set1_epi32(127)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+    __m256 t = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    __m256 poly = _mm256_set1_ps(LOG2_C5);
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps(LOG2_C4));
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps(LOG2_C3));
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps(LOG2_C2));
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps(LOG2_C1));
+    poly = _mm256_fmadd_ps(poly, t, _mm256_set1_ps(LOG2_C0));
+    return _mm256_add_ps(e, poly);
+}
+
+__attribute__((target("sse2")))
+void windowDeinterleaveSse2(const float* iq, const float* window, float gain,
+                            float* re, float* im, int n) {
+    const __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(iq + 2 * i);     // i0 q0 i1 q1
+        __m128 b = _mm_loadu_ps(iq + 2 * i + 4); // i2 q2 i3 q3
+        __m128 w = _mm_mul_ps(_mm_loadu_ps(window + i), g);
+        _mm_storeu_ps(re + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), w));
+        _mm_storeu_ps(im + i, _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), w));
+    }
+    windowDeinterleaveScalar(iq + 2 * i, window + i, gain, re + i, im + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void logPowerSse2(const float* re, const float* im, float offsetDb, float* outDb, int n) {
+    const __m128 floor = _mm_set1_ps(POWER_FLOOR);
+    const __m128 scale = _mm_set1_ps(DB_PER_LOG2);
+    const __m128 offset = _mm_set1_ps(offsetDb);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 q = _mm_loadu_ps(im + i);
+        __m128 p = _mm_max_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(q, q)), floor);
+        _mm_storeu_ps(outDb + i, _mm_add_ps(_mm_mul_ps(log2Sse2(p), scale), offset));
+    }
+    logPowerScalar(re + i, im + i, offsetDb, outDb + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void accumulatePowerSse2(const float* re, const float* im, float* acc, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 q = _mm_loadu_ps(im + i);
+        __m128 p = _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(q, q));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), p));
+    }
+    accumulatePowerScalar(re + i, im + i, acc + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void accumulateScaledSse2(const float* in, float gain, float* acc, int n) {
+    const __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(in + i), g);
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), v));
+    }
+    accumulateScaledScalar(in + i, gain, acc + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void powerToDbSse2(const float* power, float scale, float offsetDb, float* outDb, int n) {
+    const __m128 floor = _mm_set1_ps(POWER_FLOOR);
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 db = _mm_set1_ps(DB_PER_LOG2);
+    const __m128 offset = _mm_set1_ps(offsetDb);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 p = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(power + i), s), floor);
+        _mm_storeu_ps(outDb + i, _mm_add_ps(_mm_mul_ps(log2Sse2(p), db), offset));
+    }
+    powerToDbScalar(power + i, scale, offsetDb, outDb + i, n - i);
+}
+
+__attribute__((target("sse2")))
+inline float horizontalSumSse2(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+__attribute__((target("sse2")))
+void dualDotProductSse2(const float* taps, const float* a, const float* b, int n, float* out) {
+    __m128 accA = _mm_setzero_ps();
+    __m128 accB = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 t = _mm_loadu_ps(taps + i);
+        accA = _mm_add_ps(accA, _mm_mul_ps(t, _mm_loadu_ps(a + i)));
+        accB = _mm_add_ps(accB, _mm_mul_ps(t, _mm_loadu_ps(b + i)));
+    }
+    float tail[2];
+    dualDotProductScalar(taps + i, a + i, b + i, n - i, tail);
+    out[0] = horizontalSumSse2(accA) + tail[0];
+    out[1] = horizontalSumSse2(accB) + tail[1];
+}
+
+__attribute__((target("sse2")))
+void rangeStatsSse2(const float* in, int n, float* out) {
+    if (n < 4) {
+        rangeStatsScalar(in, n, out);
+        return;
+    }
+    __m128 lo = _mm_loadu_ps(in);
+    __m128 hi = lo;
+    __m128 sum = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(in + i);
+        lo = _mm_min_ps(lo, v);
+        hi = _mm_max_ps(hi, v);
+        sum = _mm_add_ps(sum, v);
+    }
+    float lanes[8];
+    _mm_storeu_ps(lanes, lo);
+    _mm_storeu_ps(lanes + 4, hi);
+    float tail[3] = {lanes[0], lanes[4], 0.0f};
+    if (i < n) rangeStatsScalar(in + i, n - i, tail);
+    out[0] = std::min({lanes[0], lanes[1], lanes[2], lanes[3], tail[0]});
+    out[1] = std::max({lanes[4], lanes[5], lanes[6], lanes[7], tail[1]});
+    out[2] = horizontalSumSse2(sum) + tail[2];
+}
+
+// Complex multiply of two interleaved pairs: (re, im, re, im).
+__attribute__((target("sse2")))
+inline __m128 complexMulSse2(__m128 a, __m128 b) {
+    __m128 bRe = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 bIm = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128 swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 cross = _mm_xor_ps(_mm_mul_ps(swapped, bIm), _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f));
+    return _mm_add_ps(_mm_mul_ps(a, bRe), cross);
+}
+
+__attribute__((target("sse2")))
+void mixPhasorsSse2(const float* iq, const float* lanes, const float* step, float* out, int n) {
+    const int vectors = DspKernels::MIX_LANES / 2;
+    __m128 phasor[vectors];
+    for (int v = 0; v < vectors; ++v) phasor[v] = _mm_loadu_ps(lanes + 4 * v);
+    __m128 rotate = _mm_setr_ps(step[0], step[1], step[0], step[1]);
+    int i = 0;
+    for (; i + DspKernels::MIX_LANES <= n; i += DspKernels::MIX_LANES) {
+        for (int v = 0; v < vectors; ++v) {
+            __m128 x = _mm_loadu_ps(iq + 2 * i + 4 * v);
+            _mm_storeu_ps(out + 2 * i + 4 * v, complexMulSse2(x, phasor[v]));
+            phasor[v] = complexMulSse2(phasor[v], rotate);
+        }
+    }
+    float tail[2 * DspKernels::MIX_LANES];
+    for (int v = 0; v < vectors; ++v) _mm_storeu_ps(tail + 4 * v, phasor[v]);
+    mixPhasorsScalar(iq + 2 * i, tail, step, out + 2 * i, n - i);
+}
+
+// Four big-endian 24-bit values (12 bytes) per shuffle, byte-reversed into
+// the top three bytes of each 32-bit lane.
+__attribute__((target("ssse3")))
+void int24BEToFloatSsse3(const uint8_t* in, float scale, float* out, int n) {
+    const __m128i order = _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+    const __m128 s = _mm_set1_ps(scale);
+    int i = 0;
+    // Each load reads 16 bytes; stop while at least 16 remain in the input.
+    for (; i + 6 <= n; i += 4) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 3 * i));
+        __m128i values = _mm_srai_epi32(_mm_shuffle_epi8(bytes, order), 8);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(values), s));
+    }
+    int24BEToFloatScalar(in + 3 * i, scale, out + i, n - i);
+}
+
+// x86 is little-endian, so 16- and 32-bit PCM loads directly. 16-bit values
+// are widened by unpacking into the top half of each lane and shifting back.
+__attribute__((target("sse2")))
+void int16LEToFloatSse2(const uint8_t* in, float scale, float* out, int n) {
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(zero, values), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(zero, values), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    int16LEToFloatScalar(in + 2 * i, scale, out + i, n - i);
+}
+
+__attribute__((target("sse2")))
+void int32LEToFloatSse2(const uint8_t* in, float scale, float* out, int n) {
+    const __m128 s = _mm_set1_ps(scale);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(values), s));
+    }
+    int32LEToFloatScalar(in + 4 * i, scale, out + i, n - i);
+}
+
+// Same shuffle as the big-endian version, without the byte reversal.
+__attribute__((target("ssse3")))
+void int24LEToFloatSsse3(const uint8_t* in, float scale, float* out, int n) {
+    const __m128i order = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m128 s = _mm_set1_ps(scale);
+    int i = 0;
+    for (; i + 6 <= n; i += 4) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 3 * i));
+        __m128i values = _mm_srai_epi32(_mm_shuffle_epi8(bytes, order), 8);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(values), s));
+    }
+    int24LEToFloatScalar(in + 3 * i, scale, out + i, n - i);
+}
+
+// Each AVX2 kernel clears the upper YMM halves before its SSE/scalar tail
+// and before returning. GCC only inserts vzeroupper itself when optimising,
+// and with the upper state left dirty every later SSE instruction, libm's
+// included, pays a transition penalty on many Intel cores.
+__attribute__((target("avx2,fma")))
+void windowDeinterleaveAvx2(const float* iq, const float* window, float gain,
+                            float* re, float* im, int n) {
+    const __m256 g = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 a = _mm256_loadu_ps(iq + 2 * i);     // i0 q0 .. i3 q3
+        __m256 b = _mm256_loadu_ps(iq + 2 * i + 8); // i4 q4 .. i7 q7
+        __m256 w = _mm256_mul_ps(_mm256_loadu_ps(window + i), g);
+        // In-lane shuffles give i0 i1 i4 i5 | i2 i3 i6 i7; fix the order across lanes.
+        __m256 ii = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 qq = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        ii = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(ii), _MM_SHUFFLE(3, 1, 2, 0)));
+        qq = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(qq), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(re + i, _mm256_mul_ps(ii, w));
+        _mm256_storeu_ps(im + i, _mm256_mul_ps(qq, w));
+    }
+    _mm256_zeroupper();
+    windowDeinterleaveScalar(iq + 2 * i, window + i, gain, re + i, im + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void logPowerAvx2(const float* re, const float* im, float offsetDb, float* outDb, int n) {
+    const __m256 floor = _mm256_set1_ps(POWER_FLOOR);
+    const __m256 scale = _mm256_set1_ps(DB_PER_LOG2);
+    const __m256 offset = _mm256_set1_ps(offsetDb);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(re + i);
+        __m256 q = _mm256_loadu_ps(im + i);
+        __m256 p = _mm256_max_ps(_mm256_fmadd_ps(r, r, _mm256_mul_ps(q, q)), floor);
+        _mm256_storeu_ps(outDb + i, _mm256_fmadd_ps(log2Avx2(p), scale, offset));
+    }
+    _mm256_zeroupper();
+    logPowerScalar(re + i, im + i, offsetDb, outDb + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void accumulatePowerAvx2(const float* re, const float* im, float* acc, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 r = _mm256_loadu_ps(re + i);
+        __m256 q = _mm256_loadu_ps(im + i);
+        __m256 p = _mm256_fmadd_ps(r, r, _mm256_mul_ps(q, q));
+        _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), p));
+    }
+    _mm256_zeroupper();
+    accumulatePowerScalar(re + i, im + i, acc + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void accumulateScaledAvx2(const float* in, float gain, float* acc, int n) {
+    const __m256 g = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(acc + i, _mm256_fmadd_ps(_mm256_loadu_ps(in + i), g, _mm256_loadu_ps(acc + i)));
+    }
+    _mm256_zeroupper();
+    accumulateScaledScalar(in + i, gain, acc + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void powerToDbAvx2(const float* power, float scale, float offsetDb, float* outDb, int n) {
+    const __m256 floor = _mm256_set1_ps(POWER_FLOOR);
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 db = _mm256_set1_ps(DB_PER_LOG2);
+    const __m256 offset = _mm256_set1_ps(offsetDb);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 p = _mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(power + i), s), floor);
+        _mm256_storeu_ps(outDb + i, _mm256_fmadd_ps(log2Avx2(p), db, offset));
+    }
+    _mm256_zeroupper();
+    powerToDbScalar(power + i, scale, offsetDb, outDb + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void int24BEToFloatAvx2(const uint8_t* in, float scale, float* out, int n) {
+    const __m256i order = _mm256_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+                                           -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+    const __m256 s = _mm256_set1_ps(scale);
+    int i = 0;
+    // The upper load starts 12 bytes in and reads 16, so 28 bytes must remain.
+    for (; i + 10 <= n; i += 8) {
+        const uint8_t* p = in + 3 * i;
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+        __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        __m256i values = _mm256_srai_epi32(_mm256_shuffle_epi8(bytes, order), 8);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), s));
+    }
+    _mm256_zeroupper();
+    int24BEToFloatScalar(in + 3 * i, scale, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void int16LEToFloatAvx2(const uint8_t* in, float scale, float* out, int n) {
+    const __m256 s = _mm256_set1_ps(scale);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i + 16));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(lo)), s));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(hi)), s));
+    }
+    _mm256_zeroupper();
+    int16LEToFloatScalar(in + 2 * i, scale, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void int24LEToFloatAvx2(const uint8_t* in, float scale, float* out, int n) {
+    const __m256i order = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                           -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256 s = _mm256_set1_ps(scale);
+    int i = 0;
+    for (; i + 10 <= n; i += 8) {
+        const uint8_t* p = in + 3 * i;
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+        __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        __m256i values = _mm256_srai_epi32(_mm256_shuffle_epi8(bytes, order), 8);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), s));
+    }
+    _mm256_zeroupper();
+    int24LEToFloatScalar(in + 3 * i, scale, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void int32LEToFloatAvx2(const uint8_t* in, float scale, float* out, int n) {
+    const __m256 s = _mm256_set1_ps(scale);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 4 * i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), s));
+    }
+    _mm256_zeroupper();
+    int32LEToFloatScalar(in + 4 * i, scale, out + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void dualDotProductAvx2(const float* taps, const float* a, const float* b, int n, float* out) {
+    __m256 accA = _mm256_setzero_ps();
+    __m256 accB = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 t = _mm256_loadu_ps(taps + i);
+        accA = _mm256_fmadd_ps(t, _mm256_loadu_ps(a + i), accA);
+        accB = _mm256_fmadd_ps(t, _mm256_loadu_ps(b + i), accB);
+    }
+    // Reduce both accumulators at once: lanes 0..3 of the sum hold A, 4..7 B.
+    __m256 lo = _mm256_permute2f128_ps(accA, accB, 0x20);
+    __m256 hi = _mm256_permute2f128_ps(accA, accB, 0x31);
+    __m256 sum = _mm256_add_ps(lo, hi);
+    sum = _mm256_hadd_ps(sum, sum);
+    sum = _mm256_hadd_ps(sum, sum);
+    float sumA = _mm256_cvtss_f32(sum);
+    float sumB = _mm_cvtss_f32(_mm256_extractf128_ps(sum, 1));
+    _mm256_zeroupper();
+    float tail[2];
+    dualDotProductScalar(taps + i, a + i, b + i, n - i, tail);
+    out[0] = sumA + tail[0];
+    out[1] = sumB + tail[1];
+}
+
+__attribute__((target("avx2,fma")))
+void rangeStatsAvx2(const float* in, int n, float* out) {
+    if (n < 16) {
+        rangeStatsSse2(in, n, out);
+        return;
+    }
+    __m256 lo = _mm256_loadu_ps(in);
+    __m256 hi = lo;
+    __m256 sum = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(in + i);
+        lo = _mm256_min_ps(lo, v);
+        hi = _mm256_max_ps(hi, v);
+        sum = _mm256_add_ps(sum, v);
+    }
+    __m128 lo4 = _mm_min_ps(_mm256_castps256_ps128(lo), _mm256_extractf128_ps(lo, 1));
+    __m128 hi4 = _mm_max_ps(_mm256_castps256_ps128(hi), _mm256_extractf128_ps(hi, 1));
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+    float lanes[8];
+    _mm_storeu_ps(lanes, lo4);
+    _mm_storeu_ps(lanes + 4, hi4);
+    float tail[3] = {lanes[0], lanes[4], 0.0f};
+    _mm256_zeroupper();
+    if (i < n) rangeStatsScalar(in + i, n - i, tail);
+    out[0] = std::min({lanes[0], lanes[1], lanes[2], lanes[3], tail[0]});
+    out[1] = std::max({lanes[4], lanes[5], lanes[6], lanes[7], tail[1]});
+    out[2] = horizontalSumSse2(sum4) + tail[2];
+}
+
+// Interleaved complex multiply; fmaddsub subtracts in the real lanes and
+// adds in the imaginary ones.
+__attribute__((target("avx2,fma")))
+inline __m256 complexMulAvx2(__m256 a, __m256 b) {
+    __m256 cross = _mm256_mul_ps(_mm256_permute_ps(a, 0xB1), _mm256_movehdup_ps(b));
+    return _mm256_fmaddsub_ps(a, _mm256_moveldup_ps(b), cross);
+}
+
+__attribute__((target("avx2,fma")))
+void mixPhasorsAvx2(const float* iq, const float* lanes, const float* step, float* out, int n) {
+    __m256 phasorLo = _mm256_loadu_ps(lanes);
+    __m256 phasorHi = _mm256_loadu_ps(lanes + 8);
+    __m256 rotate = _mm256_setr_ps(step[0], step[1], step[0], step[1],
+                                   step[0], step[1], step[0], step[1]);
+    int i = 0;
+    for (; i + DspKernels::MIX_LANES <= n; i += DspKernels::MIX_LANES) {
+        __m256 lo = _mm256_loadu_ps(iq + 2 * i);
+        __m256 hi = _mm256_loadu_ps(iq + 2 * i + 8);
+        _mm256_storeu_ps(out + 2 * i, complexMulAvx2(lo, phasorLo));
+        _mm256_storeu_ps(out + 2 * i + 8, complexMulAvx2(hi, phasorHi));
+        phasorLo = complexMulAvx2(phasorLo, rotate);
+        phasorHi = complexMulAvx2(phasorHi, rotate);
+    }
+    float tail[2 * DspKernels::MIX_LANES];
+    _mm256_storeu_ps(tail, phasorLo);
+    _mm256_storeu_ps(tail + 8, phasorHi);
+    _mm256_zeroupper();
+    mixPhasorsScalar(iq + 2 * i, tail, step, out + 2 * i, n - i);
+}
+
+#endif // DSPKERNELS_X86
+
+struct Dispatch {
+    void (*windowDeinterleave)(const float*, const float*, float, float*, float*, int);
+    void (*logPower)(const float*, const float*, float, float*, int);
+    void (*accumulatePower)(const float*, const float*, float*, int);
+    void (*accumulateScaled)(const float*, float, float*, int);
+    void (*powerToDb)(const float*, float, float, float*, int);
+    void (*int24BEToFloat)(const uint8_t*, float, float*, int);
+    void (*int16LEToFloat)(const uint8_t*, float, float*, int);
+    void (*int24LEToFloat)(const uint8_t*, float, float*, int);
+    void (*int32LEToFloat)(const uint8_t*, float, float*, int);
+    void (*dualDotProduct)(const float*, const float*, const float*, int, float*);
+    void (*mixPhasors)(const float*, const float*, const float*, float*, int);
+    void (*rangeStats)(const float*, int, float*);
+    const char* name;
+
+    Dispatch()
+        : windowDeinterleave(windowDeinterleaveScalar),
+          logPower(logPowerScalar),
+          accumulatePower(accumulatePowerScalar),
+          accumulateScaled(accumulateScaledScalar),
+          powerToDb(powerToDbScalar),
+          int24BEToFloat(int24BEToFloatScalar),
+          int16LEToFloat(int16LEToFloatScalar),
+          int24LEToFloat(int24LEToFloatScalar),
+          int32LEToFloat(int32LEToFloatScalar),
+          dualDotProduct(dualDotProductScalar),
+          mixPhasors(mixPhasorsScalar),
+          rangeStats(rangeStatsScalar),
+          name("scalar") {
+#ifdef DSPKERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            windowDeinterleave = windowDeinterleaveSse2;
+            logPower = logPowerSse2;
+            accumulatePower = accumulatePowerSse2;
+            accumulateScaled = accumulateScaledSse2;
+            powerToDb = powerToDbSse2;
+            int16LEToFloat = int16LEToFloatSse2;
+            int32LEToFloat = int32LEToFloatSse2;
+            dualDotProduct = dualDotProductSse2;
+            mixPhasors = mixPhasorsSse2;
+            rangeStats = rangeStatsSse2;
+            name = "sse2";
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            int24BEToFloat = int24BEToFloatSsse3;
+            int24LEToFloat = int24LEToFloatSsse3;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            windowDeinterleave = windowDeinterleaveAvx2;
+            logPower = logPowerAvx2;
+            accumulatePower = accumulatePowerAvx2;
+            accumulateScaled = accumulateScaledAvx2;
+            powerToDb = powerToDbAvx2;
+            int24BEToFloat = int24BEToFloatAvx2;
+            int16LEToFloat = int16LEToFloatAvx2;
+            int24LEToFloat = int24LEToFloatAvx2;
+            int32LEToFloat = int32LEToFloatAvx2;
+            dualDotProduct = dualDotProductAvx2;
+            mixPhasors = mixPhasorsAvx2;
+            rangeStats = rangeStatsAvx2;
+            name = "avx2";
+        }
+#endif
+    }
+};
+
+const Dispatch& dispatch() {
+    static const Dispatch instance;
+    return instance;
+}
+
+} // namespace
+
+namespace DspKernels {
+
+void windowDeinterleave(const float* iq, const float* window, float gain,
+                        float* re, float* im, int n) {
+    dispatch().windowDeinterleave(iq, window, gain, re, im, n);
+}
+
+void logPower(const float* re, const float* im, float offsetDb, float* outDb, int n) {
+    dispatch().logPower(re, im, offsetDb, outDb, n);
+}
+
+void fftShiftLogPower(const float* re, const float* im, float offsetDb, float* outDb, int n) {
+    int half = n / 2;
+    dispatch().logPower(re + half, im + half, offsetDb, outDb, n - half);
+    dispatch().logPower(re, im, offsetDb, outDb + (n - half), half);
+}
+
+void accumulatePower(const float* re, const float* im, float* acc, int n) {
+    dispatch().accumulatePower(re, im, acc, n);
+}
+
+void accumulateScaled(const float* in, float gain, float* acc, int n) {
+    dispatch().accumulateScaled(in, gain, acc, n);
+}
+
+void fftShiftPowerToDb(const float* power, float scale, float offsetDb, float* outDb, int n) {
+    int half = n / 2;
+    dispatch().powerToDb(power + half, scale, offsetDb, outDb, n - half);
+    dispatch().powerToDb(power, scale, offsetDb, outDb + (n - half), half);
+}
+
+void int24BEToFloat(const uint8_t* in, float scale, float* out, int n) {
+    dispatch().int24BEToFloat(in, scale, out, n);
+}
+
+void int16LEToFloat(const uint8_t* in, float scale, float* out, int n) {
+    dispatch().int16LEToFloat(in, scale, out, n);
+}
+
+void int24LEToFloat(const uint8_t* in, float scale, float* out, int n) {
+    dispatch().int24LEToFloat(in, scale, out, n);
+}
+
+void int32LEToFloat(const uint8_t* in, float scale, float* out, int n) {
+    dispatch().int32LEToFloat(in, scale, out, n);
+}
+
+void dualDotProduct(const float* taps, const float* a, const float* b, int n, float* out) {
+    dispatch().dualDotProduct(taps, a, b, n, out);
+}
+
+void mixPhasors(const float* iq, const float* lanes, const float* step, float* out, int n) {
+    dispatch().mixPhasors(iq, lanes, step, out, n);
+}
+
+void columnStats(const float* bins, int size, int columns,
+                 float* minOut, float* maxOut, float* meanOut) {
+    if (size <= 0 || columns <= 0) return;
+    float stats[3];
+    for (int x = 0; x < columns; ++x) {
+        int begin = static_cast<int>(static_cast<int64_t>(x) * size / columns);
+        int end = static_cast<int>(static_cast<int64_t>(x + 1) * size / columns);
+        if (end <= begin) end = begin + 1;
+        dispatch().rangeStats(bins + begin, end - begin, stats);
+        minOut[x] = stats[0];
+        maxOut[x] = stats[1];
+        meanOut[x] = stats[2] / (end - begin);
+    }
+}
+
+const char* isaName() {
+    return dispatch().name;
+}
+
+} // namespace DspKernels
@@ -0,0 +1,48 @@
+#include <DspThread.h>
+#include <QDebug>
+
+DspThread::DspThread(QObject* parent)
+    : QThread(parent),
+      wakeup_(0),
+      stopRequested_(false) {
+    qDebug() << "DspThread initialized";
+}
+
+DspThread::~DspThread() {
+    requestStop();
+    wait();
+    qDebug() << "DspThread destroyed";
+}
+
+void DspThread::setWorkFunction(WorkFunction work) {
+    work_ = std::move(work);
+}
+
+void DspThread::startProcessing(Priority priority) {
+    if (isRunning()) return;
+    stopRequested_.store(false);
+    start(priority);
+}
+
+void DspThread::wake() {
+    // One pending wakeup is enough; the work function drains everything.
+    if (wakeup_.available() == 0) {
+        wakeup_.release();
+    }
+}
+
+void DspThread::requestStop() {
+    stopRequested_.store(true);
+    wakeup_.release();
+}
+
+void DspThread::run() {
+    while (!stopRequested_.load(std::memory_order_relaxed)) {
+        wakeup_.tryAcquire(1, WAIT_TIMEOUT_MS);
+        if (stopRequested_.load(std::memory_order_relaxed)) break;
+        if (work_) work_();
+    }
+    // Drop wakeups left over from this run.
+    wakeup_.tryAcquire(wakeup_.available());
+    qDebug() << "DspThread: Exiting";
+}
@@ -0,0 +1,141 @@
+#include <FFTPlanCache.h>
+#include <QDir>
+#include <QDebug>
+#include <cmath>
+
+FFTPlanCache::FFTPlanCache(const QString& wisdomDir, Effort effort)
+    : wisdomFileD_(QDir(wisdomDir).filePath("fftw_wisdom.dat")),
+      wisdomFileF_(QDir(wisdomDir).filePath("fftwf_wisdom.dat")),
+      effort_(effort),
+      wisdomDirty_(false) {
+    loadWisdom();
+    qDebug() << "FFTPlanCache initialized, wisdom:" << wisdomFileD_ << wisdomFileF_;
+}
+
+FFTPlanCache::~FFTPlanCache() {
+    saveWisdom();
+    clear();
+    qDebug() << "FFTPlanCache destroyed";
+}
+
+void FFTPlanCache::Plan::execute() const {
+    if (precision == Precision::Double) {
+        fftw_execute(planD);
+    } else {
+        fftwf_execute(planF);
+    }
+}
+
+const FFTPlanCache::Plan* FFTPlanCache::acquire(int size, Direction direction,
+                                                Precision precision, WindowType windowType) {
+    if (size <= 0) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Key key(size, direction, precision, windowType);
+    auto it = plans_.find(key);
+    if (it != plans_.end()) {
+        return it->second.get();
+    }
+
+    std::unique_ptr<Plan> plan(new Plan{size, direction, precision, windowType, {}, 1.0f,
+                                        nullptr, nullptr, nullptr, nullptr, nullptr});
+    buildWindow(windowType, size, plan->window);
+    double sum = 0.0;
+    for (float w : plan->window) sum += w;
+    plan->windowGain = static_cast<float>(sum / size);
+
+    int sign = direction == Direction::Forward ? FFTW_FORWARD : FFTW_BACKWARD;
+    unsigned flags = effort_ == Effort::Patient ? FFTW_PATIENT : FFTW_MEASURE;
+    if (precision == Precision::Double) {
+        plan->bufferD = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * size));
+        if (plan->bufferD) {
+            plan->planD = fftw_plan_dft_1d(size, plan->bufferD, plan->bufferD, sign, flags);
+        }
+    } else {
+        plan->bufferRe = static_cast<float*>(fftwf_malloc(sizeof(float) * size));
+        plan->bufferIm = static_cast<float*>(fftwf_malloc(sizeof(float) * size));
+        if (plan->bufferRe && plan->bufferIm) {
+            // The split interface is always a forward transform; swapping the
+            // real and imaginary arrays gives the inverse.
+            fftwf_iodim dim = {size, 1, 1};
+            float* re = sign == FFTW_FORWARD ? plan->bufferRe : plan->bufferIm;
+            float* im = sign == FFTW_FORWARD ? plan->bufferIm : plan->bufferRe;
+            plan->planF = fftwf_plan_guru_split_dft(1, &dim, 0, nullptr, re, im, re, im, flags);
+        }
+    }
+    if (!plan->planD && !plan->planF) {
+        qDebug() << "FFTPlanCache: Failed to plan FFT of size" << size;
+        destroyPlan(plan.get());
+        return nullptr;
+    }
+
+    wisdomDirty_ = true;
+    qDebug() << "FFTPlanCache: Planned" << (precision == Precision::Double ? "double" : "single")
+             << "FFT, size:" << size << "window:" << static_cast<int>(windowType);
+    const Plan* result = plan.get();
+    plans_.emplace(key, std::move(plan));
+    return result;
+}
+
+bool FFTPlanCache::loadWisdom() {
+    bool okD = fftw_import_wisdom_from_filename(wisdomFileD_.toLocal8Bit().constData()) != 0;
+    bool okF = fftwf_import_wisdom_from_filename(wisdomFileF_.toLocal8Bit().constData()) != 0;
+    qDebug() << "FFTPlanCache: Wisdom loaded - double:" << okD << "single:" << okF;
+    return okD || okF;
+}
+
+bool FFTPlanCache::saveWisdom() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!wisdomDirty_) return true;
+    bool okD = fftw_export_wisdom_to_filename(wisdomFileD_.toLocal8Bit().constData()) != 0;
+    bool okF = fftwf_export_wisdom_to_filename(wisdomFileF_.toLocal8Bit().constData()) != 0;
+    if (!okD || !okF) {
+        qDebug() << "FFTPlanCache: Failed to save wisdom to" << wisdomFileD_ << wisdomFileF_;
+        return false;
+    }
+    wisdomDirty_ = false;
+    return true;
+}
+
+void FFTPlanCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : plans_) {
+        destroyPlan(entry.second.get());
+    }
+    plans_.clear();
+}
+
+void FFTPlanCache::buildWindow(WindowType type, int size, std::vector<float>& window) {
+    window.resize(size);
+    double denom = size > 1 ? static_cast<double>(size - 1) : 1.0;
+    for (int i = 0; i < size; ++i) {
+        double x = 2.0 * M_PI * i / denom;
+        switch (type) {
+        case WindowType::Hann:
+            window[i] = static_cast<float>(0.5 * (1.0 - std::cos(x)));
+            break;
+        case WindowType::BlackmanHarris:
+            window[i] = static_cast<float>(0.35875 - 0.48829 * std::cos(x) +
+                                           0.14128 * std::cos(2.0 * x) -
+                                           0.01168 * std::cos(3.0 * x));
+            break;
+        case WindowType::Rectangular:
+        default:
+            window[i] = 1.0f;
+            break;
+        }
+    }
+}
+
+void FFTPlanCache::destroyPlan(Plan* plan) {
+    if (plan->planD) fftw_destroy_plan(plan->planD);
+    if (plan->planF) fftwf_destroy_plan(plan->planF);
+    if (plan->bufferD) fftw_free(plan->bufferD);
+    if (plan->bufferRe) fftwf_free(plan->bufferRe);
+    if (plan->bufferIm) fftwf_free(plan->bufferIm);
+    plan->planD = nullptr;
+    plan->planF = nullptr;
+    plan->bufferD = nullptr;
+    plan->bufferRe = nullptr;
+    plan->bufferIm = nullptr;
+}
@@ -0,0 +1,108 @@
+#include <FileAudioBackend.h>
+#include <QDebug>
+#include <algorithm>
+
+FileAudioBackend::FileAudioBackend()
+    : resampling_(false),
+      pendingFrames_(0),
+      pendingRead_(0) {}
+
+FileAudioBackend::~FileAudioBackend() {
+    // The clock thread calls back into this class; stop it while it exists.
+    close();
+}
+
+const char* FileAudioBackend::name() const {
+    return "file";
+}
+
+bool FileAudioBackend::prepare(const Config& config) {
+    if (!config.inputFile.isEmpty() && config.inputChannels > 0) {
+        if (!reader_.open(config.inputFile)) {
+            return false;
+        }
+        const WavReader::Format& format = reader_.format();
+        resampling_ = format.sampleRate != config.sampleRate;
+        if (resampling_ && !resampler_.configure(format.sampleRate, config.sampleRate, config.inputChannels)) {
+            qDebug() << "FileAudioBackend: Cannot convert" << format.sampleRate << "Hz input";
+            reader_.close();
+            return false;
+        }
+        if (resampling_ && resampler_.wantedTaps() > resampler_.taps()) {
+            qDebug() << "FileAudioBackend: Filter truncated to" << resampler_.taps() << "of"
+                     << resampler_.wantedTaps() << "taps, passband edge will droop";
+        }
+        samples_.resize(static_cast<size_t>(CHUNK_FRAMES) * format.channels);
+        mapped_.resize(static_cast<size_t>(CHUNK_FRAMES) * config.inputChannels);
+        size_t output = resampling_ ? resampler_.maxOutput(CHUNK_FRAMES) : CHUNK_FRAMES;
+        pending_.resize(output * config.inputChannels);
+        pendingFrames_ = 0;
+        pendingRead_ = 0;
+    }
+    if (!config.outputFile.isEmpty()) {
+        WavRecorder::Format format;
+        format.channels = config.outputChannels;
+        format.sampleRate = config.sampleRate;
+        format.encoding = WavRecorder::Encoding::Float32;
+        format.dither = false;
+        if (!recorder_.start(config.outputFile, format)) {
+            reader_.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void FileAudioBackend::finish() {
+    recorder_.stop();
+    reader_.close();
+}
+
+double FileAudioBackend::speed() const {
+    return std::max(0.0, config_.speed);
+}
+
+void FileAudioBackend::readInput(float* input, unsigned long frames) {
+    const int channels = config_.inputChannels;
+    if (!reader_.isOpen() || reader_.format().frames == 0) {
+        std::fill(input, input + frames * channels, 0.0f);
+        return;
+    }
+    const int fileChannels = reader_.format().channels;
+    size_t done = 0;
+    while (done < frames) {
+        if (pendingRead_ < pendingFrames_) {
+            size_t n = std::min<size_t>(frames - done, pendingFrames_ - pendingRead_);
+            std::copy(pending_.data() + pendingRead_ * channels, pending_.data() + (pendingRead_ + n) * channels,
+                      input + done * channels);
+            pendingRead_ += n;
+            done += n;
+            continue;
+        }
+        pendingRead_ = 0;
+        pendingFrames_ = 0;
+        size_t n = reader_.read(samples_.data(), CHUNK_FRAMES);
+        if (n == 0) {
+            // Loop. The resampler keeps its history, so the seam is smooth.
+            if (!reader_.seek(0)) break;
+            continue;
+        }
+        float* mapped = resampling_ ? mapped_.data() : pending_.data();
+        for (size_t f = 0; f < n; ++f) {
+            for (int c = 0; c < channels; ++c) {
+                mapped[f * channels + c] = samples_[f * fileChannels + std::min(c, fileChannels - 1)];
+            }
+        }
+        pendingFrames_ = resampling_ ? resampler_.process(mapped, n, pending_.data()) : n;
+    }
+    std::fill(input + done * channels, input + frames * channels, 0.0f);
+}
+
+void FileAudioBackend::writeOutput(const float* output, unsigned long frames) {
+    if (!recorder_.isRecording()) return;
+    if (speed() > 0.0) {
+        recorder_.write(output, frames);
+    } else {
+        recorder_.writeWait(output, frames);
+    }
+}
@@ -0,0 +1,335 @@
+#include <HpsdrProtocol.h>
+#include <DspKernels.h>
+#include <Logging.h>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+const float INT24_SCALE = 1.0f / 8388608.0f; // 2^-23
+const double P2_CLOCK_HZ = 122.88e6;         // DDC phase word reference
+const char* const VERSION_NAMES[] = {"raw", "p1", "p2"};
+
+const uint32_t PttBit = 1u << 0;
+const uint32_t DotBit = 1u << 1;
+const uint32_t DashBit = 1u << 2;
+const uint32_t AdcOverloadBit = 1u << 3;
+
+inline uint32_t readBE32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+inline int readBE16(const uint8_t* p) {
+    return (p[0] << 8) | p[1];
+}
+
+inline void writeBE32(char* p, uint32_t value) {
+    p[0] = static_cast<char>(value >> 24);
+    p[1] = static_cast<char>(value >> 16);
+    p[2] = static_cast<char>(value >> 8);
+    p[3] = static_cast<char>(value);
+}
+
+} // namespace
+
+HpsdrProtocol::HpsdrProtocol(Version version)
+    : version_(version),
+      receivers_(1),
+      ddc_(0),
+      packed_(P1_FRAME_SIZE),
+      converted_(2 * P2_IQ_SAMPLES_PER_FRAME),
+      ddcSamples_(static_cast<size_t>(MAX_DDCS) * 2 * 2 * (P1_FRAME_SIZE / 8)),
+      lastSequence_(0),
+      statusBits_(0),
+      firmwareVersion_(0),
+      exciterPower_(0),
+      forwardPower_(0),
+      reversePower_(0),
+      packetsDecoded_(0),
+      malformedPackets_(0) {
+}
+
+void HpsdrProtocol::setVersion(Version version) {
+    version_ = version;
+    qDebug() << "HpsdrProtocol: Version set to" << versionName(version);
+}
+
+HpsdrProtocol::Version HpsdrProtocol::version() const {
+    return version_;
+}
+
+bool HpsdrProtocol::versionFromName(const char* name, Version* version) {
+    for (int v = 0; v < 3; ++v) {
+        if (strcasecmp(name, VERSION_NAMES[v]) == 0) {
+            *version = static_cast<Version>(v);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* HpsdrProtocol::versionName(Version version) {
+    return VERSION_NAMES[static_cast<int>(version)];
+}
+
+void HpsdrProtocol::setReceiverCount(int count) {
+    receivers_ = std::max(1, std::min(MAX_DDCS, count));
+    qDebug() << "HpsdrProtocol: Receiver count set to" << receivers_;
+}
+
+int HpsdrProtocol::receiverCount() const {
+    return receivers_;
+}
+
+void HpsdrProtocol::setDdc(int ddc) {
+    ddc_ = std::max(0, std::min(MAX_DDCS - 1, ddc));
+}
+
+void HpsdrProtocol::setSampleHandler(SampleHandler handler) {
+    handler_ = std::move(handler);
+}
+
+bool HpsdrProtocol::decode(const char* data, int size) {
+    bool ok = false;
+    switch (version_) {
+    case Version::Protocol1:
+        ok = decodeProtocol1(reinterpret_cast<const uint8_t*>(data), size);
+        break;
+    case Version::Protocol2:
+        ok = decodeProtocol2(reinterpret_cast<const uint8_t*>(data), size);
+        break;
+    case Version::Raw:
+    default:
+        ok = decodeRaw(data, size);
+        break;
+    }
+    if (ok) {
+        packetsDecoded_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        malformedPackets_.fetch_add(1, std::memory_order_relaxed);
+        THETIS_WARNING_EVERY_MS(lcNetwork, 1000) << "HpsdrProtocol: Malformed packet, size:" << size
+                                                 << "total:" << malformedPackets();
+    }
+    return ok;
+}
+
+bool HpsdrProtocol::decodeRaw(const char* data, int size) {
+    int count = size / static_cast<int>(2 * sizeof(float));
+    if (count <= 0) return false;
+    uint32_t sequence = lastSequence_.load(std::memory_order_relaxed) + 1;
+    lastSequence_.store(sequence, std::memory_order_relaxed);
+    // Already float; the channel decimator clips anything past +/-1.0.
+    deliver(0, sequence, reinterpret_cast<const float*>(data), count);
+    return true;
+}
+
+bool HpsdrProtocol::decodeProtocol1(const uint8_t* data, int size) {
+    if (size != P1_PACKET_SIZE || data[0] != 0xEF || data[1] != 0xFE || data[2] != 0x01) {
+        return false;
+    }
+    if (data[3] != P1_ENDPOINT_IQ) {
+        return true; // Bandscope (EP4) data is not handled; not an error.
+    }
+    uint32_t sequence = readBE32(data + 4);
+
+    int receivers = receivers_;
+    int slotBytes = 6 * receivers + 2;
+    int iqBytes = 6 * receivers;
+    int slotCount = (P1_FRAME_SIZE - P1_FRAME_HEADER_SIZE) / slotBytes;
+    int perFrame = 2 * receivers * slotCount; // Floats per frame, all receivers
+    int ddcStride = 2 * 2 * slotCount;        // Floats per receiver per packet
+
+    for (int f = 0; f < 2; ++f) {
+        const uint8_t* frame = data + P1_HEADER_SIZE + f * P1_FRAME_SIZE;
+        if (frame[0] != 0x7F || frame[1] != 0x7F || frame[2] != 0x7F) {
+            return false;
+        }
+        decodeP1Status(frame + 3);
+
+        const uint8_t* samples = frame + P1_FRAME_HEADER_SIZE;
+        float* out = ddcSamples_.data() + f * 2 * slotCount;
+        if (receivers == 1) {
+            // Drop the mic words so the I/Q bytes are contiguous, then convert
+            // straight into the receiver's output.
+            for (int s = 0; s < slotCount; ++s) {
+                std::memcpy(packed_.data() + s * iqBytes, samples + s * slotBytes, iqBytes);
+            }
+            DspKernels::int24BEToFloat(packed_.data(), INT24_SCALE, out, perFrame);
+        } else {
+            for (int s = 0; s < slotCount; ++s) {
+                std::memcpy(packed_.data() + s * iqBytes, samples + s * slotBytes, iqBytes);
+            }
+            if (converted_.size() < static_cast<size_t>(perFrame)) converted_.resize(perFrame);
+            DspKernels::int24BEToFloat(packed_.data(), INT24_SCALE, converted_.data(), perFrame);
+            for (int r = 0; r < receivers; ++r) {
+                float* dst = ddcSamples_.data() + r * ddcStride + f * 2 * slotCount;
+                const float* src = converted_.data() + 2 * r;
+                for (int s = 0; s < slotCount; ++s) {
+                    dst[2 * s] = src[s * 2 * receivers];
+                    dst[2 * s + 1] = src[s * 2 * receivers + 1];
+                }
+            }
+        }
+    }
+
+    lastSequence_.store(sequence, std::memory_order_relaxed);
+    for (int r = 0; r < receivers; ++r) {
+        deliver(r, sequence, ddcSamples_.data() + r * ddcStride, 2 * slotCount);
+    }
+    return true;
+}
+
+bool HpsdrProtocol::decodeProtocol2(const uint8_t* data, int size) {
+    if (size < P2_IQ_HEADER_SIZE) return false;
+
+    uint32_t sequence = readBE32(data);
+    int bitsPerSample = readBE16(data + 12);
+    int samples = readBE16(data + 14);
+    if (bitsPerSample != 24 || samples <= 0 || P2_IQ_HEADER_SIZE + samples * 6 > size) {
+        return false;
+    }
+    if (converted_.size() < static_cast<size_t>(2 * samples)) converted_.resize(2 * samples);
+    DspKernels::int24BEToFloat(data + P2_IQ_HEADER_SIZE, INT24_SCALE, converted_.data(), 2 * samples);
+    lastSequence_.store(sequence, std::memory_order_relaxed);
+    deliver(ddc_, sequence, converted_.data(), samples);
+    return true;
+}
+
+bool HpsdrProtocol::decodeStatus(const char* data, int size) {
+    if (size < P2_STATUS_SIZE) {
+        malformedPackets_.fetch_add(1, std::memory_order_relaxed);
+        THETIS_WARNING_EVERY_MS(lcNetwork, 1000) << "HpsdrProtocol: Malformed status packet, size:" << size;
+        return false;
+    }
+    decodeP2Status(reinterpret_cast<const uint8_t*>(data));
+    return true;
+}
+
+void HpsdrProtocol::decodeP1Status(const uint8_t* cc) {
+    uint32_t bits = statusBits_.load(std::memory_order_relaxed) & AdcOverloadBit;
+    if (cc[0] & 0x01) bits |= PttBit;
+    if (cc[0] & 0x02) bits |= DashBit;
+    if (cc[0] & 0x04) bits |= DotBit;
+
+    switch ((cc[0] >> 3) & 0x1F) {
+    case 0:
+        bits = (bits & ~AdcOverloadBit) | ((cc[1] & 0x01) ? AdcOverloadBit : 0);
+        firmwareVersion_.store(cc[4], std::memory_order_relaxed);
+        break;
+    case 1:
+        exciterPower_.store(readBE16(cc + 1), std::memory_order_relaxed);
+        forwardPower_.store(readBE16(cc + 3), std::memory_order_relaxed);
+        break;
+    case 2:
+        reversePower_.store(readBE16(cc + 1), std::memory_order_relaxed);
+        break;
+    default:
+        break;
+    }
+    statusBits_.store(bits, std::memory_order_relaxed);
+}
+
+void HpsdrProtocol::decodeP2Status(const uint8_t* data) {
+    uint32_t bits = 0;
+    if (data[4] & 0x01) bits |= PttBit;
+    if (data[4] & 0x02) bits |= DotBit;
+    if (data[4] & 0x04) bits |= DashBit;
+    if (data[5]) bits |= AdcOverloadBit;
+    statusBits_.store(bits, std::memory_order_relaxed);
+    exciterPower_.store(readBE16(data + 6), std::memory_order_relaxed);
+    forwardPower_.store(readBE16(data + 14), std::memory_order_relaxed);
+    reversePower_.store(readBE16(data + 22), std::memory_order_relaxed);
+}
+
+void HpsdrProtocol::deliver(int ddc, uint32_t sequence, const float* iq, int count) {
+    if (handler_) {
+        handler_(ddc, sequence, iq, count);
+    }
+}
+
+HpsdrProtocol::Status HpsdrProtocol::status() const {
+    Status status;
+    uint32_t bits = statusBits_.load(std::memory_order_relaxed);
+    status.ptt = bits & PttBit;
+    status.dot = bits & DotBit;
+    status.dash = bits & DashBit;
+    status.adcOverload = bits & AdcOverloadBit;
+    status.firmwareVersion = firmwareVersion_.load(std::memory_order_relaxed);
+    status.exciterPower = exciterPower_.load(std::memory_order_relaxed);
+    status.forwardPower = forwardPower_.load(std::memory_order_relaxed);
+    status.reversePower = reversePower_.load(std::memory_order_relaxed);
+    return status;
+}
+
+uint32_t HpsdrProtocol::lastSequence() const {
+    return lastSequence_.load(std::memory_order_relaxed);
+}
+
+uint64_t HpsdrProtocol::packetsDecoded() const {
+    return packetsDecoded_.load(std::memory_order_relaxed);
+}
+
+uint64_t HpsdrProtocol::malformedPackets() const {
+    return malformedPackets_.load(std::memory_order_relaxed);
+}
+
+void HpsdrProtocol::resetCounters() {
+    packetsDecoded_.store(0, std::memory_order_relaxed);
+    malformedPackets_.store(0, std::memory_order_relaxed);
+    lastSequence_.store(0, std::memory_order_relaxed);
+}
+
+std::vector<char> HpsdrProtocol::buildP1StartStop(bool start) {
+    std::vector<char> packet(P1_COMMAND_SIZE, 0);
+    packet[0] = static_cast<char>(0xEF);
+    packet[1] = static_cast<char>(0xFE);
+    packet[2] = 0x04;
+    packet[3] = start ? 0x01 : 0x00; // Bit 0: I/Q stream
+    return packet;
+}
+
+std::vector<char> HpsdrProtocol::buildP1Control(uint32_t sequence, int sampleRate,
+                                                int receiverCount, int64_t rxFrequency) {
+    std::vector<char> packet(P1_PACKET_SIZE, 0);
+    packet[0] = static_cast<char>(0xEF);
+    packet[1] = static_cast<char>(0xFE);
+    packet[2] = 0x01;
+    packet[3] = P1_ENDPOINT_CONTROL;
+    writeBE32(packet.data() + 4, sequence);
+
+    int rateCode = 0;
+    if (sampleRate >= 384000) rateCode = 3;
+    else if (sampleRate >= 192000) rateCode = 2;
+    else if (sampleRate >= 96000) rateCode = 1;
+    int receivers = std::max(1, std::min(MAX_DDCS, receiverCount));
+
+    for (int f = 0; f < 2; ++f) {
+        char* frame = packet.data() + P1_HEADER_SIZE + f * P1_FRAME_SIZE;
+        frame[0] = frame[1] = frame[2] = 0x7F;
+        char* cc = frame + 3;
+        if (f == 0) {
+            cc[0] = 0x00; // Address 0: general configuration
+            cc[1] = static_cast<char>(rateCode);
+            cc[4] = static_cast<char>(0x04 | ((receivers - 1) << 3)); // Duplex, receiver count
+        } else {
+            cc[0] = 0x04; // Address 2: RX1 NCO frequency
+            writeBE32(cc + 1, static_cast<uint32_t>(std::max<int64_t>(0, rxFrequency)));
+        }
+    }
+    return packet;
+}
+
+std::vector<char> HpsdrProtocol::buildP2HighPriority(uint32_t sequence, bool run,
+                                                     int64_t rxFrequency) {
+    std::vector<char> packet(P2_HIGH_PRIORITY_SIZE, 0);
+    writeBE32(packet.data(), sequence);
+    packet[4] = run ? 0x01 : 0x00;
+    uint32_t phase = static_cast<uint32_t>(
+        std::llround(std::max<int64_t>(0, rxFrequency) * 4294967296.0 / P2_CLOCK_HZ));
+    writeBE32(packet.data() + 9, phase); // DDC0 phase word
+    return packet;
+}
@@ -0,0 +1,164 @@
+#include <IQReceiver.h>
+#include <Logging.h>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+
+IQReceiver::IQReceiver(QObject* parent)
+    : QThread(parent),
+      socket_(-1),
+      stopRequested_(false),
+      slab_(static_cast<size_t>(BATCH_SIZE) * MAX_DATAGRAM_SIZE),
+      messages_(BATCH_SIZE),
+      iovecs_(BATCH_SIZE),
+      datagramsReceived_(0),
+      batchesReceived_(0),
+      truncatedDatagrams_(0) {
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        iovecs_[i].iov_base = slab_.data() + static_cast<size_t>(i) * MAX_DATAGRAM_SIZE;
+        iovecs_[i].iov_len = MAX_DATAGRAM_SIZE;
+        std::memset(&messages_[i], 0, sizeof(struct mmsghdr));
+        messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+        messages_[i].msg_hdr.msg_iovlen = 1;
+    }
+    qDebug() << "IQReceiver initialized, batch size:" << BATCH_SIZE;
+}
+
+IQReceiver::~IQReceiver() {
+    requestStop();
+    wait();
+    close();
+    qDebug() << "IQReceiver destroyed";
+}
+
+bool IQReceiver::open(const QString& host, int port) {
+    close();
+
+    socket_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (socket_ < 0) {
+        emit errorOccurred(QString("Failed to create UDP socket: ") + strerror(errno));
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    int rcvbuf = SOCKET_RCVBUF;
+    if (setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) != 0) {
+        qDebug() << "IQReceiver: Failed to set receive buffer size:" << strerror(errno);
+    }
+
+    // Bind to all interfaces like the event loop path; host only names the peer.
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::bind(socket_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        emit errorOccurred(QString("Failed to bind UDP socket: ") + strerror(errno));
+        close();
+        return false;
+    }
+
+    stopRequested_.store(false);
+    qDebug() << "IQReceiver: Bound to port" << port << "for host" << host;
+    return true;
+}
+
+void IQReceiver::close() {
+    if (socket_ >= 0) {
+        ::close(socket_);
+        socket_ = -1;
+    }
+}
+
+void IQReceiver::requestStop() {
+    stopRequested_.store(true);
+}
+
+bool IQReceiver::sendTo(const char* data, int size, quint32 ipv4Address, int port) {
+    if (socket_ < 0) return false;
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(ipv4Address);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    ssize_t sent = ::sendto(socket_, data, size, 0, reinterpret_cast<struct sockaddr*>(&addr),
+                            sizeof(addr));
+    if (sent != size) {
+        qDebug() << "IQReceiver: Send failed:" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void IQReceiver::setDatagramHandler(DatagramHandler handler) {
+    handler_ = std::move(handler);
+}
+
+quint64 IQReceiver::datagramsReceived() const {
+    return datagramsReceived_.load(std::memory_order_relaxed);
+}
+
+quint64 IQReceiver::batchesReceived() const {
+    return batchesReceived_.load(std::memory_order_relaxed);
+}
+
+quint64 IQReceiver::truncatedDatagrams() const {
+    return truncatedDatagrams_.load(std::memory_order_relaxed);
+}
+
+void IQReceiver::run() {
+    if (socket_ < 0) {
+        qDebug() << "IQReceiver: Socket not open, thread exiting";
+        return;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = socket_;
+    pfd.events = POLLIN;
+
+    while (!stopRequested_.load(std::memory_order_relaxed)) {
+        // Poll with a timeout so requestStop() is honoured promptly.
+        int ready = ::poll(&pfd, 1, POLL_TIMEOUT_MS);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            emit errorOccurred(QString("UDP poll failed: ") + strerror(errno));
+            break;
+        }
+        if (ready == 0) continue;
+
+        // Drain everything queued in the kernel, BATCH_SIZE datagrams per syscall.
+        while (!stopRequested_.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < BATCH_SIZE; ++i) {
+                messages_[i].msg_hdr.msg_flags = 0;
+            }
+            int count = ::recvmmsg(socket_, messages_.data(), BATCH_SIZE, MSG_DONTWAIT, nullptr);
+            if (count < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    emit errorOccurred(QString("UDP receive failed: ") + strerror(errno));
+                }
+                break;
+            }
+            if (count == 0) break;
+
+            batchesReceived_.fetch_add(1, std::memory_order_relaxed);
+            datagramsReceived_.fetch_add(count, std::memory_order_relaxed);
+            THETIS_TRACE("iq.batch", count, 0);
+            for (int i = 0; i < count; ++i) {
+                if (messages_[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                    truncatedDatagrams_.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (handler_) {
+                    handler_(static_cast<const char*>(iovecs_[i].iov_base),
+                             static_cast<int>(messages_[i].msg_len));
+                }
+            }
+            if (count < BATCH_SIZE) break;
+        }
+    }
+    qDebug() << "IQReceiver: Receive thread exiting, datagrams:" << datagramsReceived()
+             << "batches:" << batchesReceived();
+}
@@ -0,0 +1,160 @@
+#include <JitterBuffer.h>
+#include <Logging.h>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+JitterBuffer::JitterBuffer(int depth, int maxSamples)
+    : depth_(1),
+      maxSamples_(std::max(1, maxSamples)),
+      started_(false),
+      expected_(0),
+      highest_(0),
+      held_(0),
+      lastCount_(0),
+      received_(0),
+      lost_(0),
+      reordered_(0),
+      late_(0),
+      duplicates_(0),
+      resyncs_(0),
+      zeroSamples_(0) {
+    setDepth(depth);
+}
+
+void JitterBuffer::setDepth(int depth) {
+    int size = 1;
+    while (size < depth && size < MAX_DEPTH) size <<= 1;
+    depth_ = size;
+    slots_.assign(depth_, Slot{0, 0, false, std::vector<float>(2 * static_cast<size_t>(maxSamples_))});
+    started_ = false;
+    held_ = 0;
+    qDebug() << "JitterBuffer: Depth set to" << depth_ << "packets";
+}
+
+int JitterBuffer::depth() const {
+    return depth_;
+}
+
+void JitterBuffer::setOutputHandler(OutputHandler handler) {
+    handler_ = std::move(handler);
+}
+
+void JitterBuffer::push(uint32_t sequence, const float* iq, int count) {
+    received_.fetch_add(1, std::memory_order_relaxed);
+    if (!started_) {
+        started_ = true;
+        expected_ = sequence;
+        highest_ = sequence;
+    }
+
+    int32_t ahead = static_cast<int32_t>(sequence - expected_);
+    if (ahead < 0 && ahead > -RESYNC_THRESHOLD) {
+        late_.fetch_add(1, std::memory_order_relaxed);
+        THETIS_TRACE("jitter.late", sequence, expected_);
+        return;
+    }
+    if (ahead < 0 || ahead >= RESYNC_THRESHOLD) {
+        // The sender restarted or we lost a long burst: start over here.
+        resyncs_.fetch_add(1, std::memory_order_relaxed);
+        THETIS_WARNING_EVERY_MS(lcNetwork, 1000) << "JitterBuffer: Sequence jumped from" << expected_
+                                                 << "to" << sequence << ", resyncing";
+        flush();
+        started_ = true;
+        expected_ = sequence;
+        highest_ = sequence;
+        ahead = 0;
+    }
+
+    if (static_cast<int32_t>(sequence - highest_) < 0) {
+        reordered_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        highest_ = sequence;
+    }
+    lastCount_ = count;
+
+    // In-order packet with nothing held: no copy.
+    if (ahead == 0 && held_ == 0) {
+        output(iq, count);
+        ++expected_;
+        return;
+    }
+
+    // Give up on the oldest gaps until the packet fits in the window.
+    while (static_cast<int32_t>(sequence - expected_) >= depth_) {
+        releaseNext();
+    }
+
+    Slot& slot = slots_[sequence & (depth_ - 1)];
+    if (slot.valid) {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (slot.samples.size() < 2 * static_cast<size_t>(count)) {
+        slot.samples.resize(2 * static_cast<size_t>(count));
+    }
+    std::memcpy(slot.samples.data(), iq, sizeof(float) * 2 * count);
+    slot.sequence = sequence;
+    slot.count = count;
+    slot.valid = true;
+    ++held_;
+
+    while (held_ > 0 && slots_[expected_ & (depth_ - 1)].valid) {
+        releaseNext();
+    }
+}
+
+// Emits the packet for expected_, or zeros if it never arrived.
+void JitterBuffer::releaseNext() {
+    Slot& slot = slots_[expected_ & (depth_ - 1)];
+    if (slot.valid && slot.sequence == expected_) {
+        output(slot.samples.data(), slot.count);
+        slot.valid = false;
+        --held_;
+    } else {
+        lost_.fetch_add(1, std::memory_order_relaxed);
+        zeroSamples_.fetch_add(lastCount_, std::memory_order_relaxed);
+        THETIS_TRACE("jitter.lost", expected_, lastCount_);
+        output(nullptr, lastCount_);
+    }
+    ++expected_;
+}
+
+void JitterBuffer::flush() {
+    while (held_ > 0) {
+        releaseNext();
+    }
+    started_ = false;
+}
+
+void JitterBuffer::reset() {
+    for (Slot& slot : slots_) slot.valid = false;
+    held_ = 0;
+    started_ = false;
+    lastCount_ = 0;
+    received_.store(0, std::memory_order_relaxed);
+    lost_.store(0, std::memory_order_relaxed);
+    reordered_.store(0, std::memory_order_relaxed);
+    late_.store(0, std::memory_order_relaxed);
+    duplicates_.store(0, std::memory_order_relaxed);
+    resyncs_.store(0, std::memory_order_relaxed);
+    zeroSamples_.store(0, std::memory_order_relaxed);
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const {
+    Stats stats;
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.lost = lost_.load(std::memory_order_relaxed);
+    stats.reordered = reordered_.load(std::memory_order_relaxed);
+    stats.late = late_.load(std::memory_order_relaxed);
+    stats.duplicates = duplicates_.load(std::memory_order_relaxed);
+    stats.resyncs = resyncs_.load(std::memory_order_relaxed);
+    stats.zeroSamples = zeroSamples_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void JitterBuffer::output(const float* iq, int count) {
+    if (handler_ && count > 0) {
+        handler_(iq, count);
+    }
+}
@@ -0,0 +1,111 @@
+#include <LatencyHistogram.h>
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram()
+    : count_(0),
+      sum_(0),
+      min_(UINT64_MAX),
+      max_(0) {
+    for (int i = 0; i < BUCKETS; ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Bucket k*SUB_BUCKETS + m (k >= 1) holds values whose top bit is
+// SUB_BUCKET_BITS + k - 1 and whose next SUB_BUCKET_BITS bits are m.
+int LatencyHistogram::bucketFor(uint64_t value) {
+    if (value > MAX_VALUE) value = MAX_VALUE;
+    if (value < static_cast<uint64_t>(SUB_BUCKETS)) {
+        return static_cast<int>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int shift = exponent - SUB_BUCKET_BITS;
+    int mantissa = static_cast<int>(value >> shift) - SUB_BUCKETS;
+    return (shift + 1) * SUB_BUCKETS + mantissa;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t mantissa = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS);
+    return mantissa << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    return bucketLowerBound(bucket) + (uint64_t(1) << shift) - 1;
+}
+
+// Single writer, so the min/max updates need no compare-exchange loop.
+void LatencyHistogram::record(uint64_t value) {
+    counts_[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    if (value < min_.load(std::memory_order_relaxed)) {
+        min_.store(value, std::memory_order_relaxed);
+    }
+    if (value > max_.load(std::memory_order_relaxed)) {
+        max_.store(value, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot result;
+    result.counts.resize(BUCKETS);
+    for (int i = 0; i < BUCKETS; ++i) {
+        result.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        result.count += result.counts[i];
+    }
+    result.sum = sum_.load(std::memory_order_relaxed);
+    uint64_t min = min_.load(std::memory_order_relaxed);
+    result.min = result.count && min != UINT64_MAX ? min : 0;
+    result.max = max_.load(std::memory_order_relaxed);
+    return result;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double fraction) const {
+    if (count == 0) return 0;
+    fraction = std::max(0.0, std::min(fraction, 1.0));
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            // The exact maximum is tighter than the top bucket's bound.
+            return std::min(bucketUpperBound(static_cast<int>(i)), max);
+        }
+    }
+    return max;
+}
+
+double LatencyHistogram::Snapshot::mean() const {
+    return count ? static_cast<double>(sum) / count : 0.0;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::since(const Snapshot& earlier) const {
+    Snapshot result;
+    result.counts.resize(counts.size());
+    int lowest = -1;
+    int highest = -1;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        uint64_t before = i < earlier.counts.size() ? earlier.counts[i] : 0;
+        result.counts[i] = counts[i] >= before ? counts[i] - before : 0;
+        result.count += result.counts[i];
+        if (result.counts[i]) {
+            if (lowest < 0) lowest = static_cast<int>(i);
+            highest = static_cast<int>(i);
+        }
+    }
+    result.sum = sum >= earlier.sum ? sum - earlier.sum : 0;
+    if (result.count) {
+        result.min = std::max(bucketLowerBound(lowest), min);
+        result.max = std::min(bucketUpperBound(highest), max);
+    }
+    return result;
+}
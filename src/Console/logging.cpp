@@ -0,0 +1,156 @@
+#include <Logging.h>
+#include <QDateTime>
+#include <QDir>
+#include <QObject>
+#include <QTimer>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <vector>
+
+Q_LOGGING_CATEGORY(lcNetwork, "thetis.network")
+Q_LOGGING_CATEGORY(lcDsp, "thetis.dsp")
+Q_LOGGING_CATEGORY(lcDisplay, "thetis.display")
+Q_LOGGING_CATEGORY(lcAudio, "thetis.audio")
+
+namespace Logging {
+
+namespace {
+
+volatile std::sig_atomic_t dumpRequested = 0;
+
+void handleDumpSignal(int) {
+    dumpRequested = 1;
+}
+
+} // namespace
+
+int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+RateLimiter::RateLimiter(int intervalMs)
+    : intervalNs_(static_cast<int64_t>(intervalMs) * 1000000),
+      next_(0),
+      suppressed_(0) {
+}
+
+bool RateLimiter::allow() {
+    int64_t now = monotonicNs();
+    int64_t next = next_.load(std::memory_order_relaxed);
+    if (now >= next && next_.compare_exchange_strong(next, now + intervalNs_,
+                                                     std::memory_order_relaxed)) {
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+uint64_t RateLimiter::suppressed() const {
+    return suppressed_.load(std::memory_order_relaxed);
+}
+
+Sampler::Sampler(int n)
+    : n_(n > 0 ? static_cast<uint32_t>(n) : 1),
+      count_(0) {
+}
+
+bool Sampler::allow() {
+    return count_.fetch_add(1, std::memory_order_relaxed) % n_ == 0;
+}
+
+TraceRing::TraceRing()
+    : head_(0) {
+    for (Entry& entry : entries_) {
+        entry.seq.store(0, std::memory_order_relaxed);
+        entry.timestampNs.store(0, std::memory_order_relaxed);
+        entry.event.store(nullptr, std::memory_order_relaxed);
+        entry.a.store(0, std::memory_order_relaxed);
+        entry.b.store(0, std::memory_order_relaxed);
+    }
+}
+
+void TraceRing::record(const char* event, int64_t a, int64_t b) {
+    uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Entry& entry = entries_[index & (CAPACITY - 1)];
+    entry.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.timestampNs.store(monotonicNs(), std::memory_order_relaxed);
+    entry.event.store(event, std::memory_order_relaxed);
+    entry.a.store(a, std::memory_order_relaxed);
+    entry.b.store(b, std::memory_order_relaxed);
+    entry.seq.store(2 * index + 2, std::memory_order_release);
+}
+
+QString TraceRing::dump() const {
+    struct Snapshot {
+        uint64_t index;
+        int64_t timestampNs;
+        const char* event;
+        int64_t a;
+        int64_t b;
+    };
+    std::vector<Snapshot> snapshot;
+    snapshot.reserve(CAPACITY);
+    for (const Entry& entry : entries_) {
+        uint64_t before = entry.seq.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1)) continue; // Empty or being written
+        Snapshot s{before / 2 - 1,
+                   entry.timestampNs.load(std::memory_order_relaxed),
+                   entry.event.load(std::memory_order_relaxed),
+                   entry.a.load(std::memory_order_relaxed),
+                   entry.b.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.seq.load(std::memory_order_relaxed) != before) continue; // Overwritten
+        snapshot.push_back(s);
+    }
+    std::sort(snapshot.begin(), snapshot.end(),
+              [](const Snapshot& x, const Snapshot& y) { return x.index < y.index; });
+
+    QString out;
+    int64_t origin = snapshot.empty() ? 0 : snapshot.front().timestampNs;
+    for (const Snapshot& s : snapshot) {
+        out += QString("%1 +%2us %3 %4 %5\n")
+                   .arg(s.index)
+                   .arg((s.timestampNs - origin) / 1000)
+                   .arg(s.event ? s.event : "?")
+                   .arg(s.a)
+                   .arg(s.b);
+    }
+    return out;
+}
+
+bool TraceRing::dumpToFile(const QString& path) const {
+    FILE* file = fopen(path.toLocal8Bit().constData(), "w");
+    if (!file) {
+        qDebug() << "Logging: Failed to open trace dump file:" << path;
+        return false;
+    }
+    QByteArray text = dump().toUtf8();
+    bool ok = fwrite(text.constData(), 1, text.size(), file) == static_cast<size_t>(text.size());
+    fclose(file);
+    qDebug() << "Logging: Trace dumped to" << path;
+    return ok;
+}
+
+TraceRing& trace() {
+    static TraceRing ring;
+    return ring;
+}
+
+void installTraceDumpOnSignal(QObject* parent, const QString& dir) {
+    std::signal(SIGUSR1, handleDumpSignal);
+    QTimer* timer = new QTimer(parent);
+    QObject::connect(timer, &QTimer::timeout, parent, [dir]() {
+        if (!dumpRequested) return;
+        dumpRequested = 0;
+        QString name = QString("trace-%1.txt").arg(QDateTime::currentMSecsSinceEpoch());
+        trace().dumpToFile(QDir(dir).filePath(name));
+    });
+    timer->start(250);
+    qDebug() << "Logging: SIGUSR1 dumps the trace ring to" << dir;
+}
+
+} // namespace Logging
@@ -1,27 +1,96 @@
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QDebug>
 #include <Console.h>
 #include <WaveControl.h>
 #include <Radio.h>
 #include <NetworkIO.h>
 #include <Display.h>
+#include <DisplayScheduler.h>
+#include <Audio.h>
+#include <RxChain.h>
+#include <Logging.h>
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
     qDebug() << "ThetisCpp starting";
 
+    // Audio can run without a sound card: --audio-backend null keeps the
+    // pipeline clocked in real time, --audio-backend file runs it against
+    // WAV files as fast as it will go.
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption audioBackendOption("audio-backend", "Audio backend: portaudio, null or file.",
+                                          "name", "portaudio");
+    QCommandLineOption audioDeviceOption("audio-device", "Audio output device (part of its name).", "name");
+    QCommandLineOption audioOutputOption("audio-output-file", "File backend: record the output to this WAV file.",
+                                         "path");
+    QCommandLineOption audioInputOption("audio-input-file", "File backend: loop this WAV file as the input.",
+                                        "path");
+    QCommandLineOption audioSpeedOption("audio-speed", "File backend: multiple of real time; 0 = unpaced.",
+                                        "factor", "0");
+    QCommandLineOption audioInputDeviceOption("audio-input-device",
+                                              "Capture the mic from this input device (part of its name), "
+                                              "full duplex with the output.", "name");
+    QCommandLineOption audioOutputLatencyOption("audio-output-latency",
+                                                "Suggested output latency in ms; 0 = the device's default.",
+                                                "ms", "0");
+    QCommandLineOption audioInputLatencyOption("audio-input-latency",
+                                               "Suggested input latency in ms; 0 = the device's default.",
+                                               "ms", "0");
+    QCommandLineOption radioProtocolOption("radio-protocol",
+                                           "Radio wire format: raw (float I/Q), p1 or p2 (openHPSDR).",
+                                           "name", "raw");
+    QCommandLineOption radioPortOption("radio-port",
+                                       "Local UDP port for radio I/Q; 0 = the protocol's default "
+                                       "(50001, or 1035 for DDC 0 with p2).",
+                                       "port", "0");
+    parser.addOption(audioBackendOption);
+    parser.addOption(audioDeviceOption);
+    parser.addOption(audioOutputOption);
+    parser.addOption(audioInputOption);
+    parser.addOption(audioSpeedOption);
+    parser.addOption(audioInputDeviceOption);
+    parser.addOption(audioOutputLatencyOption);
+    parser.addOption(audioInputLatencyOption);
+    parser.addOption(radioProtocolOption);
+    parser.addOption(radioPortOption);
+    parser.process(app);
+
     // Initialize components
     Console console;
+    Logging::installTraceDumpOnSignal(&app, console.getAppDataPath());
+    RxChain rxChain; // Outlives NetworkIO's DSP thread and the audio stream
+    DisplayScheduler displayScheduler; // Also fed from the DSP thread
     Radio radio(&console);
     NetworkIO networkIO(&console);
+    Audio audio(&console);
     WaveControl waveControl(&console);
     Display display(&console, nullptr);
 
-    // Connect NetworkIO to Display for spectrum updates
-    bool connected = QObject::connect(&networkIO, &NetworkIO::spectrumDataAvailable,
+    // Spectrum frames go into the scheduler's mailbox straight from the DSP
+    // thread; the display is fed at the screen rate with the newest frame.
+    QObject::connect(&networkIO, &NetworkIO::spectrumFrameAvailable,
+                     &displayScheduler, &DisplayScheduler::post, Qt::DirectConnection);
+    bool connected = QObject::connect(&displayScheduler, &DisplayScheduler::frameReady,
                                       &display, &Display::updateSpectrum);
     qDebug() << "NetworkIO to Display connection:" << (connected ? "Success" : "Failed");
+    // Receive chain: decimated channel -> demodulator -> audio callback
+    rxChain.setSampleRate(networkIO.getChannelRate());
+    networkIO.setBasebandHandler([&rxChain](const float* iq, int count) {
+        rxChain.process(iq, count);
+    });
+    QObject::connect(&console, &Console::rxModeChanged, [&rxChain](const QString& name) {
+        RxChain::Mode mode;
+        if (RxChain::modeFromName(name.toUtf8().constData(), &mode)) rxChain.setMode(mode);
+    });
+    QObject::connect(&console, &Console::filterBandwidthChanged, [&rxChain](int bandwidth) {
+        rxChain.setBandwidth(bandwidth);
+    });
+    audio.setReceiveAudio(&rxChain.audioBuffer());
+    // Clicking the spectrum tunes the receive channel within the span
+    QObject::connect(&display, &Display::frequencyChanged, &networkIO, &NetworkIO::setRxFrequency);
 
     // Show main components
     waveControl.show();
@@ -30,9 +99,41 @@ int main(int argc, char *argv[])
     // Configure initial settings
     radio.setFrequency(14.0e6); // 14 MHz
     display.setCenterFrequency(14.0e6);
-    display.setBandwidth(96000); // 96 kHz
-    networkIO.setHost("localhost", 50001);
+    display.setBandwidth(console.getSampleRate()); // The spectrum spans the sample rate
+    HpsdrProtocol::Version protocol;
+    if (HpsdrProtocol::versionFromName(parser.value(radioProtocolOption).toUtf8().constData(), &protocol)) {
+        networkIO.setProtocol(protocol);
+    } else {
+        qDebug() << "Unknown radio protocol" << parser.value(radioProtocolOption) << "- using raw";
+    }
+    int radioPort = parser.value(radioPortOption).toInt();
+    if (radioPort <= 0) {
+        radioPort = networkIO.getProtocol() == HpsdrProtocol::Version::Protocol2
+                        ? HpsdrProtocol::P2_DDC_BASE_PORT
+                        : 50001;
+    }
+    networkIO.setHost("localhost", radioPort);
     networkIO.start();
+    AudioBackend::Config audioOptions;
+    audioOptions.outputDevice = parser.value(audioDeviceOption);
+    audioOptions.outputFile = parser.value(audioOutputOption);
+    audioOptions.inputFile = parser.value(audioInputOption);
+    audioOptions.inputDevice = parser.value(audioInputDeviceOption);
+    audioOptions.outputLatency = parser.value(audioOutputLatencyOption).toDouble() / 1000.0;
+    audioOptions.inputLatency = parser.value(audioInputLatencyOption).toDouble() / 1000.0;
+    // A mic is one channel; a file's channels are mapped onto two.
+    if (!audioOptions.inputFile.isEmpty()) {
+        audioOptions.inputChannels = 2;
+    } else if (parser.isSet(audioInputDeviceOption)) {
+        audioOptions.inputChannels = 1;
+    }
+    audioOptions.speed = parser.value(audioSpeedOption).toDouble();
+    if (!audio.setBackend(parser.value(audioBackendOption), audioOptions)) {
+        return 1;
+    }
+    if (audio.initialize(networkIO.getChannelRate(), 512)) {
+        audio.start();
+    }
 
     qDebug() << "Main application loop starting";
     return app.exec();
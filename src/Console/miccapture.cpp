@@ -0,0 +1,97 @@
+#include <MicCapture.h>
+#include <QDebug>
+#include <algorithm>
+
+MicCapture::MicCapture()
+    : sampleRate_(0),
+      channel_(0),
+      stamps_(STAMP_CAPACITY),
+      written_(0),
+      consumed_(0),
+      dropped_(0) {}
+
+bool MicCapture::configure(int sampleRate, int channel) {
+    if (sampleRate <= 0 || channel < 0) {
+        qDebug() << "MicCapture: Unsupported setup," << sampleRate << "Hz, channel" << channel;
+        return false;
+    }
+    size_t capacity = static_cast<size_t>(sampleRate) * CAPACITY_MS / 1000;
+    if (!ring_ || sampleRate != sampleRate_) {
+        ring_.reset(new AudioRingBuffer(std::max<size_t>(capacity, WINDOW), WINDOW));
+    }
+    sampleRate_ = sampleRate;
+    channel_ = channel;
+    reset();
+    qDebug() << "MicCapture: Input channel" << channel << "at" << sampleRate << "Hz";
+    return true;
+}
+
+void MicCapture::reset() {
+    if (ring_) ring_->reset();
+    stamps_.reset();
+    written_ = 0;
+    consumed_ = 0;
+    current_ = Stamp();
+}
+
+bool MicCapture::isConfigured() const {
+    return ring_ != nullptr;
+}
+
+int MicCapture::sampleRate() const {
+    return sampleRate_;
+}
+
+void MicCapture::write(const float* input, int channels, unsigned long frames, int64_t outputFrame,
+                       double adcTime) {
+    if (!ring_ || !input || channels < 1) return;
+    size_t n = std::min<size_t>(frames, ring_->space());
+    if (n < frames) {
+        dropped_.fetch_add(frames - n, std::memory_order_relaxed);
+    }
+    if (n == 0) return;
+
+    Stamp stamp;
+    stamp.sample = written_;
+    stamp.outputFrame = outputFrame;
+    stamp.adcTime = adcTime;
+    // A lost stamp only costs precision: read() extrapolates from the last.
+    if (stamps_.space() > 0) stamps_.write(&stamp, 1);
+
+    const float* source = input + std::min(channel_, channels - 1);
+    float chunk[256];
+    for (size_t done = 0; done < n;) {
+        size_t count = std::min<size_t>(n - done, sizeof(chunk) / sizeof(chunk[0]));
+        for (size_t i = 0; i < count; ++i) {
+            chunk[i] = source[(done + i) * channels];
+        }
+        ring_->write(chunk, count);
+        done += count;
+    }
+    written_ += n;
+}
+
+size_t MicCapture::available() const {
+    return ring_ ? ring_->available() : 0;
+}
+
+size_t MicCapture::read(float* dest, size_t frames, Stamp* stamp) {
+    if (!ring_) return 0;
+    for (const Stamp* next = stamps_.peek(1); next && next->sample <= consumed_; next = stamps_.peek(1)) {
+        current_ = *next;
+        stamps_.consume(1);
+    }
+    if (stamp) {
+        int64_t since = static_cast<int64_t>(consumed_ - current_.sample);
+        stamp->sample = consumed_;
+        stamp->outputFrame = current_.outputFrame + since;
+        stamp->adcTime = current_.adcTime > 0.0 ? current_.adcTime + static_cast<double>(since) / sampleRate_ : 0.0;
+    }
+    size_t n = ring_->read(dest, std::min(frames, ring_->available()));
+    consumed_ += n;
+    return n;
+}
+
+uint64_t MicCapture::droppedSamples() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,74 @@
+#include <Nco.h>
+#include <cmath>
+
+namespace {
+
+const double TWO_PI = 6.283185307179586;
+
+} // namespace
+
+Nco::Nco()
+    : sampleRate_(48000.0),
+      pendingFrequency_(0.0),
+      frequency_(0.0),
+      omega_(0.0),
+      phase_(0.0),
+      lanes_(),
+      step_() {
+    step_[0] = 1.0f;
+}
+
+void Nco::setSampleRate(double rate) {
+    if (rate <= 0.0) return;
+    sampleRate_ = rate;
+    frequency_ = pendingFrequency_.load(std::memory_order_relaxed);
+    omega_ = TWO_PI * frequency_ / sampleRate_;
+    step_[0] = static_cast<float>(std::cos(omega_ * DspKernels::MIX_LANES));
+    step_[1] = static_cast<float>(std::sin(omega_ * DspKernels::MIX_LANES));
+}
+
+double Nco::sampleRate() const {
+    return sampleRate_;
+}
+
+void Nco::setFrequency(double hz) {
+    pendingFrequency_.store(hz, std::memory_order_relaxed);
+}
+
+double Nco::frequency() const {
+    return pendingFrequency_.load(std::memory_order_relaxed);
+}
+
+void Nco::reset() {
+    phase_ = 0.0;
+}
+
+void Nco::applyFrequency() {
+    double frequency = pendingFrequency_.load(std::memory_order_relaxed);
+    if (frequency == frequency_) return;
+    frequency_ = frequency;
+    omega_ = TWO_PI * frequency_ / sampleRate_;
+    step_[0] = static_cast<float>(std::cos(omega_ * DspKernels::MIX_LANES));
+    step_[1] = static_cast<float>(std::sin(omega_ * DspKernels::MIX_LANES));
+}
+
+void Nco::seed() {
+    for (int k = 0; k < DspKernels::MIX_LANES; ++k) {
+        double phase = phase_ + omega_ * k;
+        lanes_[2 * k] = static_cast<float>(std::cos(phase));
+        lanes_[2 * k + 1] = static_cast<float>(std::sin(phase));
+    }
+}
+
+void Nco::mix(const float* iq, float* out, int count) {
+    applyFrequency();
+    while (count > 0) {
+        int n = count < RESEED_INTERVAL ? count : RESEED_INTERVAL;
+        seed();
+        DspKernels::mixPhasors(iq, lanes_, step_, out, n);
+        phase_ = std::remainder(phase_ + omega_ * n, TWO_PI);
+        iq += 2 * n;
+        out += 2 * n;
+        count -= n;
+    }
+}
@@ -1,26 +1,68 @@
 #include <NetworkIO.h>
 #include <Console.h>
+#include <IQReceiver.h>
+#include <DspThread.h>
+#include <SpectrumEngine.h>
+#include <DspKernels.h>
+#include <JitterBuffer.h>
+#include <Logging.h>
 #include <QDebug>
-#include <fftw3.h>
-#include <cmath>
+#include <QHostInfo>
+#include <QThread>
 #include <algorithm>
+#include <cmath>
 
 NetworkIO::NetworkIO(Console* console, QObject* parent)
     : QObject(parent),
       console_(console),
       udpSocket_(new QUdpSocket(this)),
+      statusSocket_(new QUdpSocket(this)),
+      receiver_(new IQReceiver(this)),
+      dspThread_(new DspThread(this)),
+      ingestMode_(IngestMode::Thread),
       host_("localhost"),
       port_(50001),
       frequency_(14.0e6),
-      gain_(1.0), // Reduced gain
-      iqBuffer_(BUFFER_SIZE, 0.0f),
-      running_(false) {
+      rxFrequency_(14.0e6),
+      iqRing_(IQ_RING_CAPACITY, SpectrumEngine::MAX_FFT_SIZE),
+      fftCache_(new FFTPlanCache(console->getAppDataPath())),
+      spectrumEngine_(new SpectrumEngine(fftCache_.get())),
+      framePool_(SpectrumFramePool::create(FRAME_POOL_SIZE)),
+      running_(false),
+      protocol_(new HpsdrProtocol(HpsdrProtocol::Version::Raw)),
+      controlSequence_(0),
+      hostLookupId_(-1),
+      channelRate_(48000),
+      decimator_(new Decimator()),
+      reportedClips_(0),
+      channelOffset_(0) {
+    for (int ddc = 0; ddc < HpsdrProtocol::MAX_DDCS; ++ddc) {
+        std::unique_ptr<JitterBuffer> buffer(
+            new JitterBuffer(DEFAULT_JITTER_DEPTH, HpsdrProtocol::P2_IQ_SAMPLES_PER_FRAME));
+        buffer->setOutputHandler([this, ddc](const float* iq, int count) {
+            processSamples(ddc, iq, count);
+        });
+        jitterBuffers_.push_back(std::move(buffer));
+    }
     qRegisterMetaType<QAbstractSocket::SocketError>("QAbstractSocket::SocketError");
+    qRegisterMetaType<SpectrumFrameRef>("SpectrumFrameRef");
     connect(udpSocket_, &QUdpSocket::readyRead, this, &NetworkIO::processPendingDatagrams);
+    connect(statusSocket_, &QUdpSocket::readyRead, this, &NetworkIO::processStatusDatagrams);
     connect(udpSocket_, &QUdpSocket::errorOccurred, this, [](QAbstractSocket::SocketError error) {
         qDebug() << "NetworkIO: Socket error:" << error;
     });
-    qDebug() << "NetworkIO initialized";
+    receiver_->setDatagramHandler([this](const char* data, int size) {
+        processIQData(data, size);
+    });
+    protocol_->setSampleHandler([this](int ddc, uint32_t sequence, const float* iq, int count) {
+        jitterBuffers_[ddc]->push(sequence, iq, count);
+    });
+    connect(receiver_, &IQReceiver::errorOccurred, this, &NetworkIO::errorOccurred);
+    dspThread_->setWorkFunction([this]() { processRing(); });
+    spectrumEngine_->setFrameHandler([this](const float* bins, const float* peak, int size) {
+        publishSpectrum(bins, peak, size);
+    });
+    qDebug() << "NetworkIO initialized, DSP kernels:" << DspKernels::isaName();
 }
 
 NetworkIO::~NetworkIO() {
@@ -36,124 +78,418 @@ void NetworkIO::setHost(const QString& host, int port) {
 
 void NetworkIO::setFrequency(double freq) {
     frequency_ = freq;
+    if (running_) sendRadioControl(true);
+    updateRxOffset();
     qDebug() << "NetworkIO: Frequency set to" << freq << "Hz";
 }
 
+void NetworkIO::setRxFrequency(double freq) {
+    rxFrequency_ = freq;
+    updateRxOffset();
+    THETIS_DEBUG_EVERY_MS(lcDsp, 250) << "NetworkIO: RX frequency set to" << freq << "Hz";
+}
+
+double NetworkIO::getRxFrequency() const {
+    return rxFrequency_.load(std::memory_order_relaxed);
+}
+
+// Retunes the channel mixer; takes effect at the DSP thread's next block.
+// An RX frequency outside the span snaps back to the centre.
+void NetworkIO::updateRxOffset() {
+    double offset = rxFrequency_.load(std::memory_order_relaxed) - frequency_.load(std::memory_order_relaxed);
+    if (std::abs(offset) > console_->getSampleRate() / 2.0) {
+        qDebug() << "NetworkIO: RX frequency outside the span, offset" << offset << "Hz; recentred";
+        rxFrequency_ = frequency_.load(std::memory_order_relaxed);
+        offset = 0.0;
+    }
+    nco_.setFrequency(-offset);
+}
+
 void NetworkIO::setGain(double gain) {
-    gain_ = gain;
+    spectrumEngine_->setGain(gain);
     qDebug() << "NetworkIO: Gain set to" << gain;
 }
 
+void NetworkIO::setIngestMode(IngestMode mode) {
+    if (running_) {
+        qDebug() << "NetworkIO: Cannot change ingest mode while running";
+        return;
+    }
+    ingestMode_ = mode;
+    qDebug() << "NetworkIO: Ingest mode set to"
+             << (mode == IngestMode::Thread ? "Thread" : "EventLoop");
+}
+
+NetworkIO::IngestMode NetworkIO::getIngestMode() const {
+    return ingestMode_;
+}
+
+void NetworkIO::setProtocol(HpsdrProtocol::Version version) {
+    if (running_) {
+        qDebug() << "NetworkIO: Cannot change protocol while running";
+        return;
+    }
+    protocol_->setVersion(version);
+}
+
+HpsdrProtocol::Version NetworkIO::getProtocol() const {
+    return protocol_->version();
+}
+
+void NetworkIO::setReceiverCount(int count) {
+    if (running_) {
+        qDebug() << "NetworkIO: Cannot change receiver count while running";
+        return;
+    }
+    protocol_->setReceiverCount(count);
+}
+
+void NetworkIO::setJitterDepth(int packets) {
+    if (running_) {
+        qDebug() << "NetworkIO: Cannot change jitter buffer depth while running";
+        return;
+    }
+    for (auto& buffer : jitterBuffers_) {
+        buffer->setDepth(packets);
+    }
+}
+
+JitterBuffer::Stats NetworkIO::getJitterStats(int ddc) const {
+    if (ddc < 0 || ddc >= static_cast<int>(jitterBuffers_.size())) return JitterBuffer::Stats();
+    return jitterBuffers_[ddc]->stats();
+}
+
+bool NetworkIO::setChannelRate(int rate) {
+    if (rate != 48000 && rate != 24000 && rate != 12000) {
+        qDebug() << "NetworkIO: Unsupported channel rate" << rate;
+        return false;
+    }
+    if (running_) {
+        qDebug() << "NetworkIO: Cannot change channel rate while running";
+        return false;
+    }
+    channelRate_ = rate;
+    return true;
+}
+
+int NetworkIO::getChannelRate() const {
+    return channelRate_;
+}
+
+double NetworkIO::getChannelGroupDelay() const {
+    return decimator_->groupDelaySeconds();
+}
+
+void NetworkIO::setBasebandHandler(BasebandHandler handler) {
+    if (running_) {
+        qDebug() << "NetworkIO: Cannot change baseband handler while running";
+        return;
+    }
+    basebandHandler_ = handler;
+}
+
+HpsdrProtocol::Status NetworkIO::getRadioStatus() const {
+    return protocol_->status();
+}
+
+quint64 NetworkIO::getMalformedPackets() const {
+    return protocol_->malformedPackets();
+}
+
+SpectrumEngine* NetworkIO::getSpectrumEngine() const {
+    return spectrumEngine_.get();
+}
+
+quint64 NetworkIO::getIQOverruns() const {
+    return iqRing_.overruns();
+}
+
+quint64 NetworkIO::getIQDroppedSamples() const {
+    return iqRing_.droppedItems();
+}
+
+quint64 NetworkIO::getDroppedSpectrumFrames() const {
+    return framePool_->droppedFrames();
+}
+
 void NetworkIO::start() {
     if (running_) return;
-    if (!udpSocket_->bind(QHostAddress::Any, port_, QUdpSocket::ReuseAddressHint)) {
+    iqRing_.reset();
+    protocol_->resetCounters();
+    for (auto& buffer : jitterBuffers_) {
+        buffer->reset();
+    }
+    if (protocol_->version() == HpsdrProtocol::Version::Protocol2) {
+        // The radio sends DDC n to port 1035+n; any other port hears nothing.
+        int ddc = port_ - HpsdrProtocol::P2_DDC_BASE_PORT;
+        if (ddc < 0 || ddc >= HpsdrProtocol::MAX_DDCS) {
+            emit errorOccurred(QString("Port %1 is not a Protocol 2 DDC port (%2-%3)")
+                                   .arg(port_).arg(HpsdrProtocol::P2_DDC_BASE_PORT)
+                                   .arg(HpsdrProtocol::P2_DDC_BASE_PORT + HpsdrProtocol::MAX_DDCS - 1));
+            qDebug() << "NetworkIO: Port" << port_ << "is not a Protocol 2 DDC port";
+            return;
+        }
+        protocol_->setDdc(ddc);
+    }
+    radioAddress_ = QHostAddress(host_);
+    if (radioAddress_.isNull()) {
+        // Resolved off the GUI thread; hostResolved() sends the start command.
+        hostLookupId_ = QHostInfo::lookupHost(host_, this, [this](const QHostInfo& info) {
+            hostResolved(info);
+        });
+    }
+    spectrumEngine_->setSampleRate(console_->getSampleRate());
+    // Plan before any samples arrive; measured wisdom makes this fast after the first run.
+    if (!spectrumEngine_->applyPendingConfig()) {
+        emit errorOccurred("Failed to create FFT plan");
+        return;
+    }
+    spectrumEngine_->reset();
+    if (!decimator_->configure(console_->getSampleRate(), channelRate_)) {
+        emit errorOccurred(QString("Cannot decimate %1 Hz to %2 Hz")
+                               .arg(console_->getSampleRate()).arg(channelRate_));
+        return;
+    }
+    decimator_->reset();
+    reportedClips_ = decimator_->clippedSamples();
+    updateRxOffset();
+    nco_.setSampleRate(console_->getSampleRate());
+    nco_.reset();
+    mixed_.resize(2 * CHANNEL_BLOCK);
+    baseband_.resize(2 * decimator_->maxOutput(CHANNEL_BLOCK));
+    channelOffset_ = 0;
+    qDebug() << "NetworkIO: Channel" << console_->getSampleRate() << "->" << channelRate_
+             << "Hz, delay" << decimator_->groupDelaySeconds() * 1000.0 << "ms";
+    dspThread_->startProcessing(QThread::HighPriority);
+    if (ingestMode_ == IngestMode::Thread) {
+        if (!receiver_->open(host_, port_)) {
+            qDebug() << "NetworkIO: Bind failed on port" << port_;
+            dspThread_->requestStop();
+            dspThread_->wait();
+            return;
+        }
+        receiver_->start(QThread::TimeCriticalPriority);
+    } else if (!udpSocket_->bind(QHostAddress::Any, port_, QUdpSocket::ReuseAddressHint)) {
         emit errorOccurred("Failed to bind UDP socket: " + udpSocket_->errorString());
         qDebug() << "NetworkIO: Bind failed on port" << port_;
+        dspThread_->requestStop();
+        dspThread_->wait();
         return;
     }
+    if (protocol_->version() == HpsdrProtocol::Version::Protocol2 &&
+        !statusSocket_->bind(QHostAddress::Any, HpsdrProtocol::P2_HIGH_PRIORITY_FROM_RADIO_PORT,
+                             QUdpSocket::ReuseAddressHint)) {
+        // Samples still flow; only PTT, overload and power readings are missing.
+        qDebug() << "NetworkIO: Cannot bind status port" << HpsdrProtocol::P2_HIGH_PRIORITY_FROM_RADIO_PORT
+                 << ":" << statusSocket_->errorString();
+    }
     running_ = true;
+    sendRadioControl(true);
     qDebug() << "NetworkIO started on port" << port_;
 }
 
 void NetworkIO::stop() {
+    if (hostLookupId_ >= 0) {
+        QHostInfo::abortHostLookup(hostLookupId_);
+        hostLookupId_ = -1;
+    }
     if (!running_) return;
+    sendRadioControl(false);
     running_ = false;
-    udpSocket_->close();
-    qDebug() << "NetworkIO stopped";
+    if (ingestMode_ == IngestMode::Thread) {
+        receiver_->requestStop();
+        receiver_->wait();
+        receiver_->close();
+    } else {
+        udpSocket_->close();
+    }
+    statusSocket_->close();
+    // Nothing pushes any more: release the packets still held for
+    // reordering (gaps among them count as lost), and once the DSP thread
+    // is down give their samples one last pass here.
+    for (auto& buffer : jitterBuffers_) {
+        buffer->flush();
+    }
+    dspThread_->requestStop();
+    dspThread_->wait();
+    processRing();
+    JitterBuffer::Stats stats = jitterBuffers_[0]->stats();
+    qDebug() << "NetworkIO stopped, packets:" << stats.received << "lost:" << stats.lost
+             << "reordered:" << stats.reordered << "late:" << stats.late
+             << "resyncs:" << stats.resyncs;
 }
 
 void NetworkIO::processPendingDatagrams() {
     while (running_ && udpSocket_->hasPendingDatagrams()) {
-        QByteArray datagram;
-        datagram.resize(udpSocket_->pendingDatagramSize());
+        datagram_.resize(udpSocket_->pendingDatagramSize());
         QHostAddress sender;
         quint16 senderPort;
-        udpSocket_->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-        qDebug() << "NetworkIO: Received datagram, size:" << datagram.size()
-                 << "from" << sender.toString() << ":" << senderPort;
-        processIQData(datagram);
+        udpSocket_->readDatagram(datagram_.data(), datagram_.size(), &sender, &senderPort);
+        THETIS_DEBUG_EVERY_MS(lcNetwork, 1000) << "NetworkIO: Received datagram, size:"
+                                               << datagram_.size() << "from"
+                                               << sender.toString() << ":" << senderPort;
+        processIQData(datagram_.constData(), datagram_.size());
     }
 }
 
-void NetworkIO::processIQData(const QByteArray& data) {
-    int floatSize = sizeof(float);
-    if (data.size() < 2 * floatSize) {
-        qDebug() << "NetworkIO: Datagram too small, size:" << data.size();
-        return;
+// GUI thread. Status packets are small and rare (a few per second), so
+// they do not need the receive thread.
+void NetworkIO::processStatusDatagrams() {
+    while (statusSocket_->hasPendingDatagrams()) {
+        datagram_.resize(statusSocket_->pendingDatagramSize());
+        statusSocket_->readDatagram(datagram_.data(), datagram_.size());
+        protocol_->decodeStatus(datagram_.constData(), datagram_.size());
     }
-    int sampleCount = data.size() / (2 * floatSize);
-    qDebug() << "NetworkIO: Processing" << sampleCount << "I/Q sample pairs";
+}
 
-    const float* samples = reinterpret_cast<const float*>(data.constData());
-    qDebug() << "NetworkIO: Sample values (first 4):"
-             << samples[0] << samples[1] << samples[2] << samples[3];
+// Runs on whichever thread reads the socket. The protocol layer converts
+// the payload; each DDC's jitter buffer puts packets back in sequence order
+// and calls processSamples().
+void NetworkIO::processIQData(const char* data, int size) {
+    if (!protocol_->decode(data, size)) return;
+    THETIS_DEBUG_EVERY_MS(lcNetwork, 1000) << "NetworkIO: Decoded packet" << protocol_->lastSequence()
+                                           << "size:" << size;
+    dspThread_->wake();
+}
 
-    iqBuffer_.clear();
-    for (int i = 0; i < sampleCount * 2; ++i) {
-        iqBuffer_.push_back(samples[i]);
+void NetworkIO::processSamples(int ddc, const float* iq, int count) {
+    if (ddc != 0) return; // Only the first DDC feeds the spectrum for now
+    size_t written = iq ? iqRing_.write(reinterpret_cast<const std::complex<float>*>(iq), count)
+                        : iqRing_.writeZeros(count); // Lost packet
+    if (!iq) {
+        THETIS_WARNING_EVERY_MS(lcNetwork, 1000) << "NetworkIO: Lost packets, zero-filled:"
+                                                 << jitterBuffers_[0]->stats().lost;
     }
+    THETIS_TRACE("iq.write", count, static_cast<int64_t>(written));
+}
 
-    if (iqBuffer_.size() >= FFT_SIZE * 2) {
-        computeSpectrum(iqBuffer_.data(), FFT_SIZE);
-        iqBuffer_.erase(iqBuffer_.begin(), iqBuffer_.begin() + FFT_SIZE * 2);
-        qDebug() << "NetworkIO: Computed spectrum, buffer size now:" << iqBuffer_.size();
+// GUI thread: picks the first IPv4 address and, if the stream is already
+// running, sends the control packets that start() could not.
+void NetworkIO::hostResolved(const QHostInfo& info) {
+    if (info.lookupId() != hostLookupId_) return;
+    hostLookupId_ = -1;
+    for (const QHostAddress& address : info.addresses()) {
+        if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+            radioAddress_ = address;
+            break;
+        }
+    }
+    if (radioAddress_.isNull()) {
+        qDebug() << "NetworkIO: Cannot resolve radio host" << host_ << ":" << info.errorString();
+        return;
     }
+    qDebug() << "NetworkIO: Radio host" << host_ << "is" << radioAddress_.toString();
+    if (running_) sendRadioControl(true);
 }
 
-void NetworkIO::computeSpectrum(const float* iqData, int size) {
-    fftw_complex* in = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * size);
-    fftw_complex* out = (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * size);
-    fftw_plan plan = fftw_plan_dft_1d(size, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
-
-    // Apply Hann window
-    std::vector<float> window(size);
-    float sum = 0.0f;
-    for (int i = 0; i < size; ++i) {
-        window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (size - 1)));
-        sum += window[i];
+void NetworkIO::sendToRadio(const std::vector<char>& packet, int port) {
+    if (radioAddress_.isNull()) {
+        // Nothing to warn about while the lookup is still in flight.
+        if (hostLookupId_ < 0) {
+            THETIS_WARNING_EVERY_MS(lcNetwork, 5000) << "NetworkIO: Cannot resolve radio host" << host_;
+        }
+        return;
     }
-    float scale = 1.0f;
-
-    float maxInputRaw = 0.0f;
-    for (int i = 0; i < size * 2; ++i) {
-        maxInputRaw = std::max(maxInputRaw, fabsf(iqData[i]));
-        if (i < 4) qDebug() << "NetworkIO: iqData[" << i << "]:" << iqData[i];
+    if (ingestMode_ == IngestMode::Thread) {
+        receiver_->sendTo(packet.data(), static_cast<int>(packet.size()),
+                          radioAddress_.toIPv4Address(), port);
+    } else {
+        udpSocket_->writeDatagram(packet.data(), packet.size(), radioAddress_, port);
     }
-    qDebug() << "NetworkIO: Raw input max amplitude:" << maxInputRaw;
+}
 
-    float maxInput = 0.0f;
-    for (int i = 0; i < size; ++i) {
-        in[i][0] = iqData[2 * i] * window[i] * scale * gain_;
-        in[i][1] = iqData[2 * i + 1] * window[i] * scale * gain_;
-        maxInput = std::max(maxInput, std::max(fabsf(in[i][0]), fabsf(in[i][1])));
+// Starts/stops the radio's I/Q stream and pushes the receive frequency.
+void NetworkIO::sendRadioControl(bool run) {
+    int64_t frequency = static_cast<int64_t>(frequency_.load(std::memory_order_relaxed));
+    switch (protocol_->version()) {
+    case HpsdrProtocol::Version::Protocol1:
+        if (run) {
+            sendToRadio(HpsdrProtocol::buildP1Control(controlSequence_++, console_->getSampleRate(),
+                                                      protocol_->receiverCount(), frequency),
+                        HpsdrProtocol::P1_PORT);
+        }
+        sendToRadio(HpsdrProtocol::buildP1StartStop(run), HpsdrProtocol::P1_PORT);
+        break;
+    case HpsdrProtocol::Version::Protocol2:
+        sendToRadio(HpsdrProtocol::buildP2HighPriority(controlSequence_++, run, frequency),
+                    HpsdrProtocol::P2_HIGH_PRIORITY_TO_RADIO_PORT);
+        break;
+    case HpsdrProtocol::Version::Raw:
+    default:
+        break;
     }
-    qDebug() << "NetworkIO: FFT input max amplitude:" << maxInput;
-
-    fftw_execute(plan);
+}
 
-    // Shift FFT and find peak
-    float spectrum[size];
-    int half = size / 2;
-    float maxMag = 0.0f;
-    int peakIdx = 0;
-    for (int i = 0; i < size; ++i) {
-        int idx = (i + half) % size;
-        float mag = sqrtf(out[idx][0] * out[idx][0] + out[idx][1] * out[idx][1]);
-        spectrum[i] = 20.0f * log10f(std::max(mag, 1e-10f));
-        if (mag > maxMag) {
-            maxMag = mag;
-            peakIdx = i;
+// Runs on the DSP thread. Every new sample goes through the channel
+// decimator first; the spectrum then reads overlapping windows from the
+// same ring and only consumes what the decimator has already seen.
+// Samples short of a full window stay in the ring. The channel is topped
+// up between windows and never waits on the spectrum: without a spectrum
+// configuration its samples are released at once, and a spectrum that
+// falls too far behind skips windows instead of filling the ring.
+void NetworkIO::processRing() {
+    processChannel();
+    if (!spectrumEngine_->applyPendingConfig()) {
+        // Nobody else reads the ring: release what the channel has used.
+        iqRing_.consume(channelOffset_);
+        channelOffset_ = 0;
+        return;
+    }
+    size_t window = spectrumEngine_->windowSize();
+    size_t hop = spectrumEngine_->hopSize();
+    while (channelOffset_ >= window) {
+        if (channelOffset_ > window + MAX_SPECTRUM_BACKLOG) {
+            // The spectrum has fallen behind; drop its oldest windows before
+            // the ring fills and the writer starts dropping channel samples.
+            size_t skip = (channelOffset_ - window) / hop * hop;
+            iqRing_.consume(skip);
+            channelOffset_ -= skip;
+            THETIS_WARNING_EVERY_MS(lcDsp, 1000) << "NetworkIO: Spectrum behind, skipped" << skip << "samples";
         }
+        const std::complex<float>* frame = iqRing_.peek(window);
+        if (!frame) break;
+        spectrumEngine_->processWindow(reinterpret_cast<const float*>(frame));
+        iqRing_.consume(hop);
+        channelOffset_ -= hop;
+        processChannel();
     }
-    qDebug() << "NetworkIO: Peak at index:" << peakIdx << "mag:" << maxMag;
+}
 
-    float minVal = *std::min_element(spectrum, spectrum + size);
-    float maxVal = *std::max_element(spectrum, spectrum + size);
-    qDebug() << "NetworkIO: Emitting spectrum, size:" << size
-             << "min:" << minVal << "max:" << maxVal;
-    emit spectrumDataAvailable(spectrum, size);
+// Runs on the DSP thread: mixes ring samples past channelOffset_ down by
+// the RX offset and decimates them to the channel rate, in blocks small
+// enough to always be contiguous.
+void NetworkIO::processChannel() {
+    size_t available = iqRing_.available();
+    while (channelOffset_ < available) {
+        size_t count = std::min(available - channelOffset_, static_cast<size_t>(CHANNEL_BLOCK));
+        const std::complex<float>* block = iqRing_.peek(count, channelOffset_);
+        if (!block) break;
+        nco_.mix(reinterpret_cast<const float*>(block), mixed_.data(), static_cast<int>(count));
+        int produced = decimator_->process(mixed_.data(), static_cast<int>(count), baseband_.data());
+        channelOffset_ += count;
+        if (decimator_->clippedSamples() != reportedClips_) {
+            reportedClips_ = decimator_->clippedSamples();
+            THETIS_WARNING_EVERY_MS(lcDsp, 1000) << "NetworkIO: I/Q beyond +/-1.0 full scale, clipped:"
+                                                 << reportedClips_;
+        }
+        if (produced > 0 && basebandHandler_) {
+            basebandHandler_(baseband_.data(), produced);
+        }
+    }
+}
 
-    fftw_destroy_plan(plan);
-    fftw_free(in);
-    fftw_free(out);
+// Runs on the DSP thread. The bins are copied once into a pooled frame; the
+// frame itself is shared with every receiver, across threads, by reference.
+void NetworkIO::publishSpectrum(const float* bins, const float* peak, int size) {
+    SpectrumFrameRef frame = framePool_->acquire(bins, peak, size,
+                                                 frequency_.load(std::memory_order_relaxed),
+                                                 spectrumEngine_->sampleRate());
+    if (!frame) {
+        THETIS_WARNING_EVERY_MS(lcDsp, 1000) << "NetworkIO: Spectrum frame pool exhausted, frames dropped:"
+                                             << framePool_->droppedFrames();
+        return;
+    }
+    THETIS_TRACE("dsp.frame", size, frame->timestampNs());
+    THETIS_DEBUG_EVERY_MS(lcDsp, 1000) << "NetworkIO: Emitting spectrum frame, size:" << size;
+    emit spectrumFrameAvailable(frame);
 }
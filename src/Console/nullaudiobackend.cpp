@@ -0,0 +1,166 @@
+#include <NullAudioBackend.h>
+#include <AudioCallbackMonitor.h>
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+#include <ctime>
+
+class NullAudioBackend::ClockThread : public QThread {
+public:
+    explicit ClockThread(NullAudioBackend* backend) : backend_(backend) {}
+
+protected:
+    void run() override {
+        backend_->run();
+    }
+
+private:
+    NullAudioBackend* backend_;
+};
+
+namespace {
+
+const int64_t NS_PER_SECOND = 1000000000;
+
+int64_t monotonicNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * NS_PER_SECOND + ts.tv_nsec;
+}
+
+void sleepUntil(int64_t deadlineNs) {
+    struct timespec ts;
+    ts.tv_sec = deadlineNs / NS_PER_SECOND;
+    ts.tv_nsec = deadlineNs % NS_PER_SECOND;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) != 0) {
+        // EINTR: go back to sleep until the same deadline.
+    }
+}
+
+} // namespace
+
+NullAudioBackend::NullAudioBackend()
+    : open_(false),
+      running_(false),
+      frames_(0) {}
+
+NullAudioBackend::~NullAudioBackend() {
+    close();
+}
+
+const char* NullAudioBackend::name() const {
+    return "null";
+}
+
+bool NullAudioBackend::open(const Config& config, Callback callback) {
+    close();
+    if (config.sampleRate <= 0 || config.framesPerBuffer <= 0 || config.outputChannels < 1 ||
+        config.inputChannels < 0) {
+        qDebug() << "NullAudioBackend: Unsupported stream," << config.sampleRate << "Hz,"
+                 << config.framesPerBuffer << "frames," << config.outputChannels << "channels";
+        return false;
+    }
+    config_ = config;
+    if (!prepare(config_)) {
+        return false;
+    }
+    callback_ = std::move(callback);
+    input_.assign(static_cast<size_t>(config.framesPerBuffer) * config.inputChannels, 0.0f);
+    output_.assign(static_cast<size_t>(config.framesPerBuffer) * config.outputChannels, 0.0f);
+    frames_.store(0);
+    open_ = true;
+    qDebug() << "NullAudioBackend:" << name() << "stream," << config.sampleRate << "Hz,"
+             << config.framesPerBuffer << "frames per buffer, speed" << speed();
+    return true;
+}
+
+bool NullAudioBackend::start() {
+    if (!open_) return false;
+    if (running_.load()) return true;
+    running_.store(true);
+    thread_.reset(new ClockThread(this));
+    thread_->start(QThread::TimeCriticalPriority);
+    return true;
+}
+
+void NullAudioBackend::stop() {
+    running_.store(false);
+    if (thread_) {
+        thread_->wait();
+        thread_.reset();
+    }
+}
+
+void NullAudioBackend::close() {
+    stop();
+    if (open_) {
+        finish();
+        open_ = false;
+    }
+}
+
+bool NullAudioBackend::isOpen() const {
+    return open_;
+}
+
+bool NullAudioBackend::isRunning() const {
+    return running_.load();
+}
+
+double NullAudioBackend::streamTime() const {
+    return static_cast<double>(frames_.load(std::memory_order_relaxed)) / config_.sampleRate;
+}
+
+uint64_t NullAudioBackend::framesProcessed() const {
+    return frames_.load(std::memory_order_relaxed);
+}
+
+bool NullAudioBackend::prepare(const Config&) {
+    return true;
+}
+
+void NullAudioBackend::finish() {}
+
+void NullAudioBackend::readInput(float* input, unsigned long frames) {
+    std::fill(input, input + frames * config_.inputChannels, 0.0f);
+}
+
+void NullAudioBackend::writeOutput(const float*, unsigned long) {}
+
+double NullAudioBackend::speed() const {
+    return 1.0;
+}
+
+void NullAudioBackend::run() {
+    const unsigned long frames = static_cast<unsigned long>(config_.framesPerBuffer);
+    const double pace = speed();
+    const double periodSeconds = static_cast<double>(frames) / config_.sampleRate;
+    const int64_t periodNs = pace > 0.0 ? static_cast<int64_t>(periodSeconds * NS_PER_SECOND / pace) : 0;
+    float* input = config_.inputChannels > 0 ? input_.data() : nullptr;
+    int64_t deadline = monotonicNow();
+
+    while (running_.load(std::memory_order_relaxed)) {
+        Timing timing;
+        if (periodNs > 0) {
+            sleepUntil(deadline);
+            int64_t now = monotonicNow();
+            if (now - deadline > periodNs) {
+                timing.flags |= AudioCallbackMonitor::OutputUnderflow;
+                deadline = now;
+            }
+            deadline += periodNs;
+        }
+        timing.currentTime = streamTime();
+        // The buffer is due when the next period starts; the input was
+        // captured over the period that just ended.
+        if (periodNs > 0) {
+            timing.outputDacTime = timing.currentTime + periodSeconds / pace;
+            if (input) timing.inputAdcTime = timing.currentTime - periodSeconds / pace;
+        }
+        if (input) readInput(input, frames);
+        std::fill(output_.begin(), output_.end(), 0.0f);
+        callback_(input, output_.data(), frames, timing);
+        writeOutput(output_.data(), frames);
+        frames_.fetch_add(frames, std::memory_order_relaxed);
+    }
+}
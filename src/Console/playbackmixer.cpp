@@ -0,0 +1,190 @@
+#include <PlaybackMixer.h>
+#include <DspKernels.h>
+#include <QDebug>
+#include <algorithm>
+#include <thread>
+
+PlaybackMixer::PlaybackMixer()
+    : streams_(new Stream[MAX_STREAMS]),
+      scratch_(new float[2 * FILL_FRAMES]),
+      inCallback_(false),
+      clock_(0),
+      underruns_(0) {}
+
+PlaybackMixer::~PlaybackMixer() {
+    stopAll();
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        if (streams_[i].state.load() != Free) retire(streams_[i]);
+    }
+}
+
+bool PlaybackMixer::start(int id, std::unique_ptr<PlaybackSource> source, const Options& options) {
+    stop(id);
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        Stream& stream = streams_[i];
+        int expected = Free;
+        if (!stream.state.compare_exchange_strong(expected, Loading)) continue;
+        stream.source = std::move(source);
+        stream.gain.store(options.gain, std::memory_order_relaxed);
+        stream.loop = options.loop;
+        stream.startFrame = options.startFrame;
+        stream.id = id;
+        stream.ended.store(false, std::memory_order_relaxed);
+        stream.state.store(Queued);
+        qDebug() << "PlaybackMixer: Queued stream" << i << "for ID:" << id << "gain:" << options.gain
+                 << "loop:" << options.loop << "start:" << options.startFrame;
+        return true;
+    }
+    qDebug() << "PlaybackMixer: No free stream for ID:" << id;
+    return false;
+}
+
+bool PlaybackMixer::stop(int id) {
+    bool found = false;
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        Stream& stream = streams_[i];
+        if (stream.id != id) continue;
+        // The disk thread may move Queued to Playing at the same time.
+        int expected = Queued;
+        if (stream.state.compare_exchange_strong(expected, Stopping)) {
+            found = true;
+            continue;
+        }
+        expected = Playing;
+        if (stream.state.compare_exchange_strong(expected, Stopping)) {
+            found = true;
+        }
+    }
+    return found;
+}
+
+void PlaybackMixer::stopAll() {
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        int expected = Queued;
+        if (!streams_[i].state.compare_exchange_strong(expected, Stopping)) {
+            expected = Playing;
+            streams_[i].state.compare_exchange_strong(expected, Stopping);
+        }
+    }
+}
+
+bool PlaybackMixer::setGain(int id, float gain) {
+    bool found = false;
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        Stream& stream = streams_[i];
+        int state = stream.state.load();
+        if (stream.id == id && (state == Queued || state == Playing)) {
+            stream.gain.store(gain, std::memory_order_relaxed);
+            found = true;
+        }
+    }
+    return found;
+}
+
+bool PlaybackMixer::isPlaying(int id) const {
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        int state = streams_[i].state.load();
+        if (streams_[i].id == id && (state == Queued || state == Playing)) return true;
+    }
+    return false;
+}
+
+int PlaybackMixer::activeStreams() const {
+    int count = 0;
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        int state = streams_[i].state.load();
+        if (state == Queued || state == Playing) ++count;
+    }
+    return count;
+}
+
+uint64_t PlaybackMixer::now() const {
+    return clock_.load(std::memory_order_relaxed);
+}
+
+uint64_t PlaybackMixer::underruns() const {
+    return underruns_.load(std::memory_order_relaxed);
+}
+
+void PlaybackMixer::service() {
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        Stream& stream = streams_[i];
+        int state = stream.state.load();
+        if (state == Queued) {
+            fill(stream);
+            stream.state.compare_exchange_strong(state, Playing);
+        } else if (state == Playing) {
+            fill(stream);
+            if (stream.ended.load() && stream.ring.available() == 0 &&
+                stream.state.compare_exchange_strong(state, Stopping)) {
+                qDebug() << "PlaybackMixer: Stream" << i << "finished";
+            }
+        }
+        if (stream.state.load() == Stopping) {
+            retire(stream);
+        }
+    }
+}
+
+// Reads whole chunks while the ring has room for them. A looping stream
+// rewinds as often as it takes to fill the chunk, so short sources loop
+// without gaps.
+void PlaybackMixer::fill(Stream& stream) {
+    float* scratch = scratch_.get();
+    while (!stream.ended.load(std::memory_order_relaxed) &&
+           stream.ring.space() >= static_cast<size_t>(2 * FILL_FRAMES)) {
+        size_t n = stream.source->read(scratch, FILL_FRAMES);
+        while (n < static_cast<size_t>(FILL_FRAMES) && stream.loop && stream.source->rewind()) {
+            size_t more = stream.source->read(scratch + 2 * n, FILL_FRAMES - n);
+            if (more == 0) break;
+            n += more;
+        }
+        stream.ring.write(scratch, 2 * n);
+        if (n < static_cast<size_t>(FILL_FRAMES)) {
+            stream.ended.store(true);
+        }
+    }
+}
+
+// Stopping streams are invisible to callbacks that start from now on; once
+// any callback already in flight returns, nothing else refers to the slot.
+void PlaybackMixer::retire(Stream& stream) {
+    while (inCallback_.load()) {
+        std::this_thread::yield();
+    }
+    stream.source.reset();
+    stream.ring.reset();
+    stream.ended.store(false);
+    stream.state.store(Free);
+}
+
+// Real-time: reads the rings in place and accumulates them into out; no
+// locks, allocation or system calls.
+void PlaybackMixer::mix(float* out, size_t frames, float masterGain) {
+    inCallback_.store(true);
+    uint64_t now = clock_.load(std::memory_order_relaxed);
+    for (int i = 0; i < MAX_STREAMS; ++i) {
+        Stream& stream = streams_[i];
+        if (stream.state.load() != Playing) continue;
+        // Not due yet, or due part way through this buffer.
+        size_t offset = stream.startFrame > now ? std::min<uint64_t>(frames, stream.startFrame - now) : 0;
+        if (offset == frames) continue;
+        float gain = stream.gain.load(std::memory_order_relaxed) * masterGain;
+        float* dest = out + 2 * offset;
+        size_t needed = 2 * (frames - offset);
+        size_t done = 0;
+        while (done < needed) {
+            size_t count = std::min<size_t>({needed - done, stream.ring.available(), stream.ring.maxWindow()});
+            const float* samples = count ? stream.ring.peek(count) : nullptr;
+            if (!samples) break;
+            DspKernels::accumulateScaled(samples, gain, dest + done, static_cast<int>(count));
+            stream.ring.consume(count);
+            done += count;
+        }
+        if (done < needed && !stream.ended.load()) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    clock_.store(now + frames, std::memory_order_relaxed);
+    inCallback_.store(false);
+}
@@ -0,0 +1,135 @@
+#include <PlaybackSource.h>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+WavPlaybackSource::WavPlaybackSource()
+    : resampling_(false),
+      flushed_(false),
+      pendingFrames_(0),
+      pendingRead_(0) {
+    samples_.resize(CHUNK_FRAMES * WavReader::MAX_CHANNELS);
+}
+
+bool WavPlaybackSource::open(const QString& path, int outputRate, Resampler::Quality quality) {
+    if (!reader_.open(path)) {
+        return false;
+    }
+    const int fileRate = reader_.format().sampleRate;
+    resampling_ = fileRate != outputRate;
+    if (resampling_) {
+        if (!resampler_.configure(fileRate, outputRate, 2, quality)) {
+            qDebug() << "WavPlaybackSource: Cannot convert" << fileRate << "Hz to" << outputRate << "Hz";
+            reader_.close();
+            return false;
+        }
+        // Room for a whole chunk, or the whole filter tail, resampled.
+        size_t input = std::max<size_t>(CHUNK_FRAMES, resampler_.latencyFrames());
+        stereo_.resize(2 * CHUNK_FRAMES);
+        pending_.resize(2 * resampler_.maxOutput(input));
+        qDebug() << "WavPlaybackSource: Resampling" << fileRate << "->" << outputRate << "Hz,"
+                 << Resampler::qualityName(quality) << "quality," << resampler_.taps() << "taps";
+        if (resampler_.wantedTaps() > resampler_.taps()) {
+            qDebug() << "WavPlaybackSource: Filter truncated to" << resampler_.taps() << "of"
+                     << resampler_.wantedTaps() << "taps, passband edge will droop";
+        }
+    }
+    flushed_ = false;
+    pendingFrames_ = 0;
+    pendingRead_ = 0;
+    return true;
+}
+
+const WavReader::Format& WavPlaybackSource::format() const {
+    return reader_.format();
+}
+
+size_t WavPlaybackSource::read(float* stereo, size_t frames) {
+    if (!resampling_) {
+        return readStereo(stereo, frames);
+    }
+    size_t done = 0;
+    while (done < frames) {
+        if (pendingRead_ < pendingFrames_) {
+            size_t n = std::min(frames - done, pendingFrames_ - pendingRead_);
+            std::copy(pending_.data() + 2 * pendingRead_, pending_.data() + 2 * (pendingRead_ + n),
+                      stereo + 2 * done);
+            pendingRead_ += n;
+            done += n;
+            continue;
+        }
+        pendingRead_ = 0;
+        size_t n = readStereo(stereo_.data(), CHUNK_FRAMES);
+        if (n > 0) {
+            pendingFrames_ = resampler_.process(stereo_.data(), n, pending_.data());
+        } else if (!flushed_) {
+            // The last latencyFrames() of the file are still in the filter.
+            pendingFrames_ = resampler_.flush(pending_.data());
+            flushed_ = true;
+        } else {
+            pendingFrames_ = 0;
+            break;
+        }
+    }
+    return done;
+}
+
+// File frames as stereo at the file rate.
+size_t WavPlaybackSource::readStereo(float* stereo, size_t frames) {
+    const int channels = reader_.format().channels;
+    const int right = channels > 1 ? 1 : 0;
+    size_t done = 0;
+    while (done < frames) {
+        size_t n = reader_.read(samples_.data(), std::min<size_t>(frames - done, CHUNK_FRAMES));
+        if (n == 0) break;
+        const float* in = samples_.data();
+        float* out = stereo + 2 * done;
+        for (size_t f = 0; f < n; ++f) {
+            out[2 * f] = in[f * channels];
+            out[2 * f + 1] = in[f * channels + right];
+        }
+        done += n;
+    }
+    return done;
+}
+
+bool WavPlaybackSource::rewind() {
+    if (!reader_.seek(0)) {
+        return false;
+    }
+    resampler_.reset();
+    flushed_ = false;
+    pendingFrames_ = 0;
+    pendingRead_ = 0;
+    return true;
+}
+
+TonePlaybackSource::TonePlaybackSource(double frequency, double amplitude, int sampleRate, uint64_t frames)
+    : phase_(0.0),
+      step_(2.0 * M_PI * frequency / std::max(sampleRate, 1)),
+      amplitude_(static_cast<float>(amplitude)),
+      length_(frames),
+      position_(0) {}
+
+size_t TonePlaybackSource::read(float* stereo, size_t frames) {
+    size_t n = frames;
+    if (length_ != 0) {
+        n = static_cast<size_t>(std::min<uint64_t>(frames, length_ - position_));
+    }
+    for (size_t f = 0; f < n; ++f) {
+        float v = amplitude_ * static_cast<float>(std::sin(phase_));
+        stereo[2 * f] = v;
+        stereo[2 * f + 1] = v;
+        phase_ += step_;
+    }
+    // Keep the phase small so it stays exact over long runs.
+    phase_ = std::fmod(phase_, 2.0 * M_PI);
+    position_ += n;
+    return n;
+}
+
+bool TonePlaybackSource::rewind() {
+    phase_ = 0.0;
+    position_ = 0;
+    return true;
+}
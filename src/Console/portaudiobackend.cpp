@@ -0,0 +1,173 @@
+#include <PortAudioBackend.h>
+#include <AudioCallbackMonitor.h>
+#include <QDebug>
+
+static_assert(AudioCallbackMonitor::InputUnderflow == paInputUnderflow &&
+              AudioCallbackMonitor::InputOverflow == paInputOverflow &&
+              AudioCallbackMonitor::OutputUnderflow == paOutputUnderflow &&
+              AudioCallbackMonitor::OutputOverflow == paOutputOverflow &&
+              AudioCallbackMonitor::PrimingOutput == paPrimingOutput,
+              "Timing::flags passes PortAudio's flags straight through");
+
+PortAudioBackend::PortAudioBackend()
+    : stream_(nullptr),
+      initialized_(false),
+      running_(false) {}
+
+PortAudioBackend::~PortAudioBackend() {
+    close();
+}
+
+const char* PortAudioBackend::name() const {
+    return "portaudio";
+}
+
+PaDeviceIndex PortAudioBackend::findDevice(const QString& name, int channels, bool input) const {
+    if (!name.isEmpty()) {
+        for (int i = 0; i < Pa_GetDeviceCount(); ++i) {
+            const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(i);
+            if (deviceInfo && QString(deviceInfo->name).contains(name) &&
+                (input ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels) >= channels) {
+                return i;
+            }
+        }
+        qDebug() << "PortAudioBackend: No" << (input ? "input" : "output") << "device matching" << name
+                 << "- using the default";
+    }
+    return input ? Pa_GetDefaultInputDevice() : Pa_GetDefaultOutputDevice();
+}
+
+bool PortAudioBackend::open(const Config& config, Callback callback) {
+    close();
+    PaError err = Pa_Initialize();
+    if (err != paNoError) {
+        qDebug() << "PortAudio initialization failed:" << Pa_GetErrorText(err);
+        return false;
+    }
+    initialized_ = true;
+
+    PaStreamParameters outputParameters;
+    outputParameters.device = findDevice(config.outputDevice, config.outputChannels, false);
+    if (outputParameters.device == paNoDevice) {
+        qDebug() << "No default output device found";
+        close();
+        return false;
+    }
+
+    const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(outputParameters.device);
+    qDebug() << "Selected audio device:" << deviceInfo->name
+             << "Host API:" << Pa_GetHostApiInfo(deviceInfo->hostApi)->name;
+
+    outputParameters.channelCount = config.outputChannels;
+    outputParameters.sampleFormat = paFloat32;
+    outputParameters.suggestedLatency =
+        config.outputLatency > 0.0 ? config.outputLatency : deviceInfo->defaultLowOutputLatency;
+    outputParameters.hostApiSpecificStreamInfo = nullptr;
+
+    PaStreamParameters inputParameters;
+    bool duplex = false;
+    if (config.inputChannels > 0) {
+        inputParameters.device = findDevice(config.inputDevice, config.inputChannels, true);
+        if (inputParameters.device == paNoDevice) {
+            qDebug() << "PortAudioBackend: No input device found, opening output only";
+        } else {
+            const PaDeviceInfo* inputInfo = Pa_GetDeviceInfo(inputParameters.device);
+            qDebug() << "Selected input device:" << inputInfo->name
+                     << "Host API:" << Pa_GetHostApiInfo(inputInfo->hostApi)->name;
+            inputParameters.channelCount = config.inputChannels;
+            inputParameters.sampleFormat = paFloat32;
+            inputParameters.suggestedLatency =
+                config.inputLatency > 0.0 ? config.inputLatency : inputInfo->defaultLowInputLatency;
+            inputParameters.hostApiSpecificStreamInfo = nullptr;
+            duplex = true;
+        }
+    }
+
+    callback_ = std::move(callback);
+    err = Pa_OpenStream(
+        &stream_,
+        duplex ? &inputParameters : nullptr,
+        &outputParameters,
+        config.sampleRate,
+        config.framesPerBuffer,
+        paClipOff,
+        streamCallback,
+        this
+    );
+    if (err != paNoError && duplex) {
+        qDebug() << "PortAudioBackend: Cannot open the input and output devices together:"
+                 << Pa_GetErrorText(err) << "- opening output only";
+        duplex = false;
+        err = Pa_OpenStream(&stream_, nullptr, &outputParameters, config.sampleRate, config.framesPerBuffer,
+                            paClipOff, streamCallback, this);
+    }
+    if (err != paNoError) {
+        qDebug() << "Failed to open PortAudio stream:" << Pa_GetErrorText(err);
+        stream_ = nullptr;
+        close();
+        return false;
+    }
+    const PaStreamInfo* info = Pa_GetStreamInfo(stream_);
+    if (info) {
+        qDebug() << "PortAudioBackend: Latency output" << info->outputLatency * 1000.0 << "ms, input"
+                 << (duplex ? info->inputLatency * 1000.0 : 0.0) << "ms";
+    }
+    return true;
+}
+
+bool PortAudioBackend::start() {
+    if (!stream_) return false;
+    PaError err = Pa_StartStream(stream_);
+    if (err != paNoError) {
+        qDebug() << "Failed to start PortAudio stream:" << Pa_GetErrorText(err);
+        return false;
+    }
+    running_ = true;
+    return true;
+}
+
+void PortAudioBackend::stop() {
+    if (stream_ && running_) {
+        Pa_StopStream(stream_);
+    }
+    running_ = false;
+}
+
+void PortAudioBackend::close() {
+    stop();
+    if (stream_) {
+        Pa_CloseStream(stream_);
+        stream_ = nullptr;
+    }
+    if (initialized_) {
+        Pa_Terminate();
+        initialized_ = false;
+    }
+}
+
+bool PortAudioBackend::isOpen() const {
+    return stream_ != nullptr;
+}
+
+bool PortAudioBackend::isRunning() const {
+    return running_;
+}
+
+double PortAudioBackend::streamTime() const {
+    return stream_ ? Pa_GetStreamTime(stream_) : 0.0;
+}
+
+int PortAudioBackend::streamCallback(const void* input, void* output, unsigned long frameCount,
+                                     const PaStreamCallbackTimeInfo* timeInfo,
+                                     PaStreamCallbackFlags statusFlags, void* userData) {
+    PortAudioBackend* backend = static_cast<PortAudioBackend*>(userData);
+    Timing timing;
+    if (timeInfo) {
+        timing.currentTime = timeInfo->currentTime;
+        timing.outputDacTime = timeInfo->outputBufferDacTime;
+        timing.inputAdcTime = input ? timeInfo->inputBufferAdcTime : 0.0;
+    }
+    timing.flags = statusFlags;
+    backend->callback_(static_cast<const float*>(input), static_cast<float*>(output), frameCount, timing);
+    return paContinue;
+}
@@ -52,10 +52,11 @@ void Radio::setMode(const QString& mode) {
         return;
     }
     QStringList validModes = {"LSB", "USB", "AM", "CW"}; // Simplified from radio.cs
-    if (validModes.contains(mode, Qt::CaseInsensitive)) {
+    QStringList consoleModes = {"1", "2", "3", "6"};      // Console's DSP mode codes
+    int index = validModes.indexOf(mode.toUpper());
+    if (index >= 0) {
         qDebug() << "Radio: Setting mode to:" << mode;
-        // Placeholder: WDSP mode setting
-        // SetRXMode(console_->channel(), mode);
+        console_->setMode(consoleModes[index]);
         emit modeChanged(mode);
     } else {
         qDebug() << "Radio: Invalid mode:" << mode;
@@ -0,0 +1,284 @@
+#include <Resampler.h>
+#include <DspKernels.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+// Polyphase table for one quality and cutoff. Row p holds the prototype at
+// sub-sample offset p/phases, tap j multiplying the sample j steps back from
+// the newest; there are phases+1 rows so row p+1 is always there to
+// interpolate towards.
+struct Resampler::Design {
+    int taps = 0;
+    int phases = 0;
+    int wantedTaps = 0;             // Before the MAX_TAPS cap
+    std::vector<float> rows;
+};
+
+namespace {
+
+struct QualitySpec {
+    double passband;      // Fraction of the lower Nyquist frequency
+    double stopbandDb;
+    int phases;           // Table resolution at 1:1
+};
+
+const QualitySpec QUALITY_SPECS[] = {
+    {0.80, 60.0, 64},
+    {0.88, 80.0, 128},
+    {0.92, 100.0, 256},
+    {0.95, 120.0, 1024},
+};
+
+const int MIN_PHASES = 16;
+// Kaiser's length estimate runs a little short; design for this much more.
+const double DESIGN_MARGIN_DB = 3.0;
+
+const QualitySpec& specFor(Resampler::Quality quality) {
+    return QUALITY_SPECS[static_cast<int>(quality)];
+}
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+// Kaiser's estimates for the window shape and length meeting attenuationDb
+// with a transition width of transition cycles per sample.
+double kaiserBeta(double attenuationDb) {
+    return attenuationDb > 50.0 ? 0.1102 * (attenuationDb - 8.7)
+                                : 0.5842 * std::pow(attenuationDb - 21.0, 0.4) + 0.07886 * (attenuationDb - 21.0);
+}
+
+int kaiserLength(double attenuationDb, double transition) {
+    return static_cast<int>(std::ceil((attenuationDb - 8.0) / (2.285 * 2.0 * M_PI * transition)));
+}
+
+// scale = min(1, outputRate/inputRate): the lower Nyquist frequency in
+// cycles per input sample is scale/2.
+std::unique_ptr<Resampler::Design> design(Resampler::Quality quality, double scale) {
+    const QualitySpec& spec = specFor(quality);
+    double transition = 0.5 * scale * (1.0 - spec.passband);
+    double cutoff = 0.5 * scale * (1.0 + spec.passband) / 2.0;
+    double attenuationDb = spec.stopbandDb + DESIGN_MARGIN_DB;
+    double beta = kaiserBeta(attenuationDb);
+
+    std::unique_ptr<Resampler::Design> result(new Resampler::Design);
+    // A multiple of 8 keeps the dot products on whole AVX2 vectors.
+    int wantedTaps = (kaiserLength(attenuationDb, transition) + 7) / 8 * 8;
+    int taps = std::min(wantedTaps, static_cast<int>(Resampler::MAX_TAPS));
+    // A narrower filter is smoother between phases, so needs fewer of them.
+    int phases = std::max(MIN_PHASES, static_cast<int>(std::lround(spec.phases * scale)));
+    result->taps = taps;
+    result->phases = phases;
+    result->wantedTaps = wantedTaps;
+
+    // Prototype sampled at t = m/phases - taps/2 input samples.
+    std::vector<double> prototype(static_cast<size_t>(taps) * phases + 1);
+    double half = 0.5 * taps;
+    double sum = 0.0;
+    for (size_t m = 0; m < prototype.size(); ++m) {
+        double t = static_cast<double>(m) / phases - half;
+        double x = 2.0 * cutoff * t;
+        double sinc = std::abs(x) < 1e-12 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        double r = t / half;
+        double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+        prototype[m] = 2.0 * cutoff * sinc * window;
+        if (m + 1 < prototype.size()) sum += prototype[m];
+    }
+    // Unity DC gain: every row sums to about 1.
+    double gain = phases / sum;
+
+    result->rows.resize(static_cast<size_t>(phases + 1) * taps);
+    for (int p = 0; p <= phases; ++p) {
+        float* row = result->rows.data() + static_cast<size_t>(p) * taps;
+        for (int j = 0; j < taps; ++j) {
+            row[j] = static_cast<float>(prototype[static_cast<size_t>(j) * phases + p] * gain);
+        }
+    }
+    return result;
+}
+
+const Resampler::Design* designFor(Resampler::Quality quality, double scale) {
+    static std::mutex mutex;
+    static std::map<std::tuple<int, long>, std::unique_ptr<Resampler::Design>> designs;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto key = std::make_tuple(static_cast<int>(quality), std::lround(scale * 1e9));
+    auto it = designs.find(key);
+    if (it != designs.end()) return it->second.get();
+    std::unique_ptr<Resampler::Design> made = design(quality, scale);
+    const Resampler::Design* result = made.get();
+    designs.emplace(key, std::move(made));
+    return result;
+}
+
+} // namespace
+
+Resampler::Resampler()
+    : design_(nullptr),
+      inputRate_(0),
+      outputRate_(0),
+      channels_(0),
+      quality_(Quality::High),
+      nominalStep_(1.0),
+      adjustPpm_(0.0),
+      step_(1.0),
+      time_(0.0),
+      index_(0) {}
+
+Resampler::~Resampler() = default;
+
+bool Resampler::configure(int inputRate, int outputRate, int channels, Quality quality) {
+    if (inputRate <= 0 || outputRate <= 0 || channels < 1 || channels > MAX_CHANNELS) {
+        return false;
+    }
+    double scale = std::min(1.0, static_cast<double>(outputRate) / inputRate);
+    design_ = designFor(quality, scale);
+    inputRate_ = inputRate;
+    outputRate_ = outputRate;
+    channels_ = channels;
+    quality_ = quality;
+    nominalStep_ = static_cast<double>(inputRate) / outputRate;
+    adjustPpm_ = 0.0;
+    step_ = nominalStep_;
+    history_.assign(static_cast<size_t>(channels) * 2 * design_->taps, 0.0f);
+    silence_.assign(channels, 0.0f);
+    reset();
+    return true;
+}
+
+bool Resampler::isConfigured() const {
+    return design_ != nullptr;
+}
+
+void Resampler::reset() {
+    std::fill(history_.begin(), history_.end(), 0.0f);
+    time_ = 0.0;
+    index_ = 0;
+}
+
+int Resampler::inputRate() const {
+    return inputRate_;
+}
+
+int Resampler::outputRate() const {
+    return outputRate_;
+}
+
+int Resampler::channels() const {
+    return channels_;
+}
+
+Resampler::Quality Resampler::quality() const {
+    return quality_;
+}
+
+int Resampler::taps() const {
+    return design_ ? design_->taps : 0;
+}
+
+int Resampler::phases() const {
+    return design_ ? design_->phases : 0;
+}
+
+int Resampler::wantedTaps() const {
+    return design_ ? design_->wantedTaps : 0;
+}
+
+int Resampler::latencyFrames() const {
+    return taps() / 2;
+}
+
+void Resampler::setRatioAdjust(double ppm) {
+    adjustPpm_ = std::max(-MAX_RATIO_ADJUST_PPM, std::min(ppm, MAX_RATIO_ADJUST_PPM));
+    step_ = nominalStep_ * (1.0 + adjustPpm_ * 1e-6);
+}
+
+double Resampler::ratioAdjust() const {
+    return adjustPpm_;
+}
+
+size_t Resampler::maxOutput(size_t frames) const {
+    double slowest = nominalStep_ * (1.0 - MAX_RATIO_ADJUST_PPM * 1e-6);
+    return static_cast<size_t>(std::ceil(frames / slowest)) + 1;
+}
+
+// Output n lands at time_ input samples past the centre of the window, so
+// after each input frame every output with time_ < 1 is due.
+size_t Resampler::process(const float* in, size_t frames, float* out) {
+    if (!design_) return 0;
+    size_t produced = 0;
+    for (size_t f = 0; f < frames; ++f) {
+        push(in + f * channels_);
+        while (time_ < 1.0) {
+            interpolate(out + produced * channels_);
+            ++produced;
+            time_ += step_;
+        }
+        time_ -= 1.0;
+    }
+    return produced;
+}
+
+size_t Resampler::flush(float* out) {
+    if (!design_) return 0;
+    size_t produced = 0;
+    for (int f = 0; f < latencyFrames(); ++f) {
+        produced += process(silence_.data(), 1, out + produced * channels_);
+    }
+    return produced;
+}
+
+void Resampler::push(const float* frame) {
+    const int taps = design_->taps;
+    index_ = (index_ == 0 ? taps : index_) - 1;
+    float* history = history_.data();
+    for (int c = 0; c < channels_; ++c, history += 2 * taps) {
+        history[index_] = frame[c];
+        history[index_ + taps] = frame[c];
+    }
+}
+
+// Both neighbouring phases are applied and the results blended, which is
+// the same as blending the coefficients but needs no scratch row.
+void Resampler::interpolate(float* out) {
+    const int taps = design_->taps;
+    double position = time_ * design_->phases;
+    int phase = std::min(static_cast<int>(position), design_->phases - 1);
+    float fraction = static_cast<float>(position - phase);
+    const float* lower = design_->rows.data() + static_cast<size_t>(phase) * taps;
+    const float* upper = lower + taps;
+    const float* history = history_.data() + index_;
+    const size_t stride = 2 * static_cast<size_t>(taps);
+    for (int c = 0; c < channels_; c += 2) {
+        const float* a = history + c * stride;
+        const float* b = c + 1 < channels_ ? a + stride : a;
+        float low[2];
+        float high[2];
+        DspKernels::dualDotProduct(lower, a, b, taps, low);
+        DspKernels::dualDotProduct(upper, a, b, taps, high);
+        out[c] = low[0] + fraction * (high[0] - low[0]);
+        if (c + 1 < channels_) {
+            out[c + 1] = low[1] + fraction * (high[1] - low[1]);
+        }
+    }
+}
+
+const char* Resampler::qualityName(Quality quality) {
+    switch (quality) {
+    case Quality::Fast: return "fast";
+    case Quality::Medium: return "medium";
+    case Quality::High: return "high";
+    case Quality::Best: return "best";
+    }
+    return "unknown";
+}
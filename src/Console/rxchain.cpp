@@ -0,0 +1,307 @@
+#include <RxChain.h>
+#include <DspKernels.h>
+#include <Logging.h>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+const double FILTER_BETA = 6.0;   // Kaiser beta, ~60 dB stopband
+const double AM_DC_CUTOFF = 20.0; // Hz, carrier tracking for the AM envelope
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+double kaiser(int n, int length, double beta) {
+    double r = 2.0 * n / (length - 1) - 1.0;
+    return besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+}
+
+const char* const MODE_NAMES[] = {"LSB", "USB", "AM", "CW"};
+
+} // namespace
+
+// SSB: the filter already removed the opposite sideband, so the audio is
+// the real part.
+template <>
+struct RxChain::Demodulator<RxChain::Mode::USB> {
+    static void process(const float* i, const float*, float* audio, int n, DemodState&) {
+        std::memcpy(audio, i, n * sizeof(float));
+    }
+};
+
+template <>
+struct RxChain::Demodulator<RxChain::Mode::LSB> : RxChain::Demodulator<RxChain::Mode::USB> {};
+
+// AM: envelope, less a slowly tracked carrier level.
+template <>
+struct RxChain::Demodulator<RxChain::Mode::AM> {
+    static void process(const float* i, const float* q, float* audio, int n, DemodState& state) {
+        float dc = state.dc;
+        for (int k = 0; k < n; ++k) {
+            float envelope = std::sqrt(i[k] * i[k] + q[k] * q[k]);
+            dc += state.dcCoefficient * (envelope - dc);
+            audio[k] = envelope - dc;
+        }
+        state.dc = dc;
+    }
+};
+
+// CW: the carrier sits at DC; a beat oscillator lifts it to the pitch and
+// the real part is the tone. The recursive phasor is renormalised per block.
+template <>
+struct RxChain::Demodulator<RxChain::Mode::CW> {
+    static void process(const float* i, const float* q, float* audio, int n, DemodState& state) {
+        float re = state.phasor[0];
+        float im = state.phasor[1];
+        for (int k = 0; k < n; ++k) {
+            audio[k] = i[k] * re - q[k] * im;
+            float next = re * state.step[0] - im * state.step[1];
+            im = re * state.step[1] + im * state.step[0];
+            re = next;
+        }
+        float norm = 1.0f / std::sqrt(re * re + im * im);
+        state.phasor[0] = re * norm;
+        state.phasor[1] = im * norm;
+    }
+};
+
+RxChain::RxChain()
+    : configDirty_(true),
+      demodulate_(&Demodulator<Mode::USB>::process),
+      taps_(0),
+      index_(0),
+      audioRing_(AUDIO_CAPACITY, AUDIO_WINDOW) {
+    // Sized once for the longest filter so retuning never allocates.
+    tapsRe_.reserve(MAX_FILTER_TAPS);
+    tapsIm_.reserve(MAX_FILTER_TAPS);
+    historyI_.assign(2 * MAX_FILTER_TAPS, 0.0f);
+    historyQ_.assign(2 * MAX_FILTER_TAPS, 0.0f);
+    filteredI_.resize(BLOCK_SIZE);
+    filteredQ_.resize(BLOCK_SIZE);
+    audio_.resize(BLOCK_SIZE);
+}
+
+void RxChain::setConfig(const Config& config) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    pending_ = config;
+    configDirty_.store(true, std::memory_order_release);
+}
+
+RxChain::Config RxChain::getConfig() const {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return pending_;
+}
+
+void RxChain::setMode(Mode mode) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    pending_.mode = mode;
+    configDirty_.store(true, std::memory_order_release);
+    qDebug() << "RxChain: Mode set to" << modeName(mode);
+}
+
+void RxChain::setBandwidth(int hz) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    pending_.bandwidth = hz;
+    configDirty_.store(true, std::memory_order_release);
+    qDebug() << "RxChain: Bandwidth set to" << hz << "Hz";
+}
+
+void RxChain::setSampleRate(int rate) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    pending_.sampleRate = rate;
+    configDirty_.store(true, std::memory_order_release);
+}
+
+void RxChain::setVolume(double volume) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    pending_.volume = volume;
+    configDirty_.store(true, std::memory_order_release);
+}
+
+bool RxChain::modeFromName(const char* name, Mode* mode) {
+    for (int m = 0; m < 4; ++m) {
+        if (strcasecmp(name, MODE_NAMES[m]) == 0) {
+            *mode = static_cast<Mode>(m);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* RxChain::modeName(Mode mode) {
+    return MODE_NAMES[static_cast<int>(mode)];
+}
+
+AudioRingBuffer& RxChain::audioBuffer() {
+    return audioRing_;
+}
+
+void RxChain::reset() {
+    std::fill(historyI_.begin(), historyI_.end(), 0.0f);
+    std::fill(historyQ_.begin(), historyQ_.end(), 0.0f);
+    index_ = 0;
+    demodState_.dc = 0.0f;
+    demodState_.phasor[0] = 1.0f;
+    demodState_.phasor[1] = 0.0f;
+    agc_.reset();
+}
+
+void RxChain::applyPendingConfig() {
+    if (!configDirty_.load(std::memory_order_acquire)) return;
+    Config config;
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config = pending_;
+        configDirty_.store(false, std::memory_order_relaxed);
+    }
+    config.sampleRate = std::max(config.sampleRate, 8000);
+    config.bandwidth = std::max(100, std::min(config.bandwidth, config.sampleRate / 2 - FILTER_TRANSITION));
+    config.cwPitch = std::max(SSB_LOW_CUT + 100, std::min(config.cwPitch, 2000));
+
+    switch (config.mode) {
+    case Mode::LSB: demodulate_ = &Demodulator<Mode::LSB>::process; break;
+    case Mode::USB: demodulate_ = &Demodulator<Mode::USB>::process; break;
+    case Mode::AM: demodulate_ = &Demodulator<Mode::AM>::process; break;
+    case Mode::CW: demodulate_ = &Demodulator<Mode::CW>::process; break;
+    }
+    demodState_.dcCoefficient = static_cast<float>(1.0 - std::exp(-2.0 * M_PI * AM_DC_CUTOFF / config.sampleRate));
+    double pitch = 2.0 * M_PI * config.cwPitch / config.sampleRate;
+    demodState_.step[0] = static_cast<float>(std::cos(pitch));
+    demodState_.step[1] = static_cast<float>(std::sin(pitch));
+
+    bool redesign = config.mode != active_.mode || config.bandwidth != active_.bandwidth ||
+                    config.sampleRate != active_.sampleRate || config.cwPitch != active_.cwPitch ||
+                    taps_ == 0;
+    active_ = config;
+    if (redesign) designFilter(config);
+    agc_.setup(config);
+}
+
+// Kaiser-windowed sinc low-pass, shifted to the centre of the passband.
+// Tap n multiplies the sample n steps back, matching the history layout.
+void RxChain::designFilter(const Config& config) {
+    double low;
+    double high;
+    switch (config.mode) {
+    case Mode::LSB:
+        low = -config.bandwidth;
+        high = -SSB_LOW_CUT;
+        break;
+    case Mode::USB:
+        low = SSB_LOW_CUT;
+        high = config.bandwidth;
+        break;
+    case Mode::CW: {
+        double half = std::min(config.bandwidth / 2.0, static_cast<double>(config.cwPitch - SSB_LOW_CUT));
+        low = -half;
+        high = half;
+        break;
+    }
+    case Mode::AM:
+    default:
+        low = -config.bandwidth / 2.0;
+        high = config.bandwidth / 2.0;
+        break;
+    }
+
+    double rate = config.sampleRate;
+    int taps = static_cast<int>(std::ceil(3.6 * rate / FILTER_TRANSITION)) | 1;
+    taps = std::min(taps, MAX_FILTER_TAPS);
+    double cutoff = (high - low) / 2.0 / rate + FILTER_TRANSITION / 2.0 / rate;
+    double centre = 2.0 * M_PI * (high + low) / 2.0 / rate;
+    tapsRe_.resize(taps);
+    tapsIm_.resize(taps);
+    int middle = taps / 2;
+    for (int n = 0; n < taps; ++n) {
+        int t = n - middle;
+        double h = t == 0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        h *= kaiser(n, taps, FILTER_BETA);
+        tapsRe_[n] = static_cast<float>(h * std::cos(centre * t));
+        tapsIm_[n] = static_cast<float>(h * std::sin(centre * t));
+    }
+    taps_ = taps;
+    std::fill(historyI_.begin(), historyI_.end(), 0.0f);
+    std::fill(historyQ_.begin(), historyQ_.end(), 0.0f);
+    index_ = 0;
+    qDebug() << "RxChain:" << modeName(config.mode) << "filter" << low << "to" << high
+             << "Hz," << taps << "taps at" << config.sampleRate << "Hz";
+}
+
+// Complex FIR: four real dot products per output, two kernel calls.
+void RxChain::filter(const float* iq, int n) {
+    for (int k = 0; k < n; ++k) {
+        index_ = index_ == 0 ? taps_ - 1 : index_ - 1;
+        historyI_[index_] = historyI_[index_ + taps_] = iq[2 * k];
+        historyQ_[index_] = historyQ_[index_ + taps_] = iq[2 * k + 1];
+        float re[2];
+        float im[2];
+        DspKernels::dualDotProduct(tapsRe_.data(), &historyI_[index_], &historyQ_[index_], taps_, re);
+        DspKernels::dualDotProduct(tapsIm_.data(), &historyI_[index_], &historyQ_[index_], taps_, im);
+        filteredI_[k] = re[0] - im[1];
+        filteredQ_[k] = re[1] + im[0];
+    }
+}
+
+void RxChain::process(const float* iq, int count) {
+    applyPendingConfig();
+    float volume = static_cast<float>(active_.volume);
+    while (count > 0) {
+        int n = std::min(count, static_cast<int>(BLOCK_SIZE));
+        filter(iq, n);
+        demodulate_(filteredI_.data(), filteredQ_.data(), audio_.data(), n, demodState_);
+        agc_.process(audio_.data(), n, volume);
+        size_t written = audioRing_.write(audio_.data(), n);
+        if (written < static_cast<size_t>(n)) {
+            THETIS_WARNING_EVERY_MS(lcAudio, 1000) << "RxChain: Audio buffer full, samples dropped:"
+                                                   << audioRing_.droppedItems();
+        }
+        iq += 2 * n;
+        count -= n;
+    }
+}
+
+void RxChain::Agc::setup(const Config& config) {
+    double rate = config.sampleRate;
+    target = static_cast<float>(config.agcTarget);
+    minEnvelope = static_cast<float>(config.agcTarget / std::pow(10.0, config.agcMaxGainDb / 20.0));
+    attack = static_cast<float>(1.0 - std::exp(-1000.0 / (config.agcAttackMs * rate)));
+    decay = static_cast<float>(std::exp(-1000.0 / (config.agcDecayMs * rate)));
+    hangSamples = static_cast<int>(config.agcHangMs * rate / 1000.0);
+    envelope = std::max(envelope, minEnvelope);
+}
+
+void RxChain::Agc::reset() {
+    envelope = minEnvelope;
+    hang = 0;
+}
+
+void RxChain::Agc::process(float* audio, int n, float volume) {
+    float env = envelope;
+    for (int k = 0; k < n; ++k) {
+        float level = std::fabs(audio[k]);
+        if (level > env) {
+            env += attack * (level - env);
+            hang = hangSamples;
+        } else if (hang > 0) {
+            --hang;
+        } else {
+            env = std::max(env * decay, minEnvelope);
+        }
+        // The attack is not instantaneous, so clamp the onset overshoot.
+        float out = audio[k] * (target / env) * volume;
+        audio[k] = std::max(-1.0f, std::min(out, 1.0f));
+    }
+    envelope = env;
+}
@@ -0,0 +1,259 @@
+#include <SpectrumEngine.h>
+#include <DspKernels.h>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+SpectrumEngine::SpectrumEngine(FFTPlanCache* cache)
+    : cache_(cache),
+      configDirty_(true),
+      clearPeak_(false),
+      plan_(nullptr),
+      hop_(1),
+      offsetDb_(0.0f),
+      framePeriodSamples_(1.0),
+      samplesSinceFrame_(0.0),
+      segments_(0),
+      averageValid_(false),
+      peakValid_(false) {
+    qDebug() << "SpectrumEngine initialized";
+}
+
+SpectrumEngine::~SpectrumEngine() {
+    qDebug() << "SpectrumEngine destroyed";
+}
+
+SpectrumEngine::Config SpectrumEngine::validate(Config config) {
+    int size = MIN_FFT_SIZE;
+    while (size < config.fftSize && size < MAX_FFT_SIZE) size <<= 1;
+    config.fftSize = size;
+    config.overlap = std::max(0.0, std::min(MAX_OVERLAP, config.overlap));
+    config.averagingTime = std::max(0.001, config.averagingTime);
+    config.frameRate = std::max(1.0, std::min(120.0, config.frameRate));
+    if (config.sampleRate <= 0) config.sampleRate = 48000;
+    return config;
+}
+
+void SpectrumEngine::setConfig(const Config& config) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    pending_ = validate(config);
+    configDirty_.store(true, std::memory_order_release);
+}
+
+SpectrumEngine::Config SpectrumEngine::getConfig() const {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return pending_;
+}
+
+void SpectrumEngine::setFftSize(int size) {
+    Config config = getConfig();
+    config.fftSize = size;
+    setConfig(config);
+    qDebug() << "SpectrumEngine: FFT size set to" << getConfig().fftSize;
+}
+
+void SpectrumEngine::setOverlap(double overlap) {
+    Config config = getConfig();
+    config.overlap = overlap;
+    setConfig(config);
+    qDebug() << "SpectrumEngine: Overlap set to" << getConfig().overlap;
+}
+
+void SpectrumEngine::setAveraging(Averaging mode, double timeSeconds) {
+    Config config = getConfig();
+    config.averaging = mode;
+    config.averagingTime = timeSeconds;
+    setConfig(config);
+    qDebug() << "SpectrumEngine: Averaging mode" << static_cast<int>(mode)
+             << "time" << timeSeconds << "s";
+}
+
+void SpectrumEngine::setPeakHold(bool enabled) {
+    Config config = getConfig();
+    config.peakHold = enabled;
+    setConfig(config);
+    clearPeak_.store(true, std::memory_order_release);
+    qDebug() << "SpectrumEngine: Peak hold" << (enabled ? "enabled" : "disabled");
+}
+
+void SpectrumEngine::clearPeakHold() {
+    clearPeak_.store(true, std::memory_order_release);
+}
+
+void SpectrumEngine::setFrameRate(double fps) {
+    Config config = getConfig();
+    config.frameRate = fps;
+    setConfig(config);
+    qDebug() << "SpectrumEngine: Frame rate set to" << getConfig().frameRate;
+}
+
+void SpectrumEngine::setSampleRate(int rate) {
+    Config config = getConfig();
+    config.sampleRate = rate;
+    setConfig(config);
+}
+
+void SpectrumEngine::setWindowType(FFTPlanCache::WindowType window) {
+    Config config = getConfig();
+    config.window = window;
+    setConfig(config);
+}
+
+void SpectrumEngine::setGain(double gain) {
+    Config config = getConfig();
+    config.gain = gain;
+    setConfig(config);
+}
+
+void SpectrumEngine::setFrameHandler(FrameHandler handler) {
+    handler_ = std::move(handler);
+}
+
+bool SpectrumEngine::applyPendingConfig() {
+    if (clearPeak_.exchange(false, std::memory_order_acquire)) {
+        peakValid_ = false;
+    }
+    if (!configDirty_.load(std::memory_order_acquire)) {
+        return plan_ != nullptr;
+    }
+
+    Config config;
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config = pending_ = validate(pending_);
+        configDirty_.store(false, std::memory_order_relaxed);
+    }
+
+    bool geometryChanged = !plan_ || config.fftSize != active_.fftSize ||
+                           config.window != active_.window;
+    if (geometryChanged) {
+        const FFTPlanCache::Plan* plan = cache_->acquire(config.fftSize,
+                                                         FFTPlanCache::Direction::Forward,
+                                                         FFTPlanCache::Precision::Single,
+                                                         config.window);
+        cache_->saveWisdom();
+        if (!plan) {
+            qDebug() << "SpectrumEngine: No FFT plan for size" << config.fftSize;
+            return false;
+        }
+        plan_ = plan;
+        welchSum_.assign(config.fftSize, 0.0f);
+        frameDb_.assign(config.fftSize, 0.0f);
+        average_.assign(config.fftSize, 0.0f);
+        peak_.assign(config.fftSize, 0.0f);
+        segments_ = 0;
+        samplesSinceFrame_ = 0.0;
+        averageValid_ = false;
+        peakValid_ = false;
+    }
+    if (config.averaging != active_.averaging) {
+        averageValid_ = false;
+    }
+
+    active_ = config;
+    hop_ = std::max(1, static_cast<int>(std::lround(config.fftSize * (1.0 - config.overlap))));
+    framePeriodSamples_ = config.sampleRate / config.frameRate;
+    // Full-scale complex tone reads 0 dBFS regardless of FFT size and window.
+    offsetDb_ = static_cast<float>(-20.0 * std::log10(config.fftSize * plan_->windowGain));
+    qDebug() << "SpectrumEngine: Applied config - FFT size:" << config.fftSize
+             << "hop:" << hop_ << "frame period:" << framePeriodSamples_ << "samples";
+    return true;
+}
+
+int SpectrumEngine::windowSize() const {
+    return active_.fftSize;
+}
+
+int SpectrumEngine::hopSize() const {
+    return hop_;
+}
+
+int SpectrumEngine::sampleRate() const {
+    return active_.sampleRate;
+}
+
+void SpectrumEngine::reset() {
+    std::fill(welchSum_.begin(), welchSum_.end(), 0.0f);
+    segments_ = 0;
+    samplesSinceFrame_ = 0.0;
+    averageValid_ = false;
+    peakValid_ = false;
+}
+
+void SpectrumEngine::processWindow(const float* iq) {
+    if (!plan_) return;
+    int size = active_.fftSize;
+    DspKernels::windowDeinterleave(iq, plan_->window.data(), static_cast<float>(active_.gain),
+                                   plan_->bufferRe, plan_->bufferIm, size);
+    plan_->execute();
+    DspKernels::accumulatePower(plan_->bufferRe, plan_->bufferIm, welchSum_.data(), size);
+    ++segments_;
+
+    samplesSinceFrame_ += hop_;
+    if (samplesSinceFrame_ >= framePeriodSamples_) {
+        emitFrame();
+        samplesSinceFrame_ = std::fmod(samplesSinceFrame_, framePeriodSamples_);
+    }
+}
+
+void SpectrumEngine::emitFrame() {
+    int size = active_.fftSize;
+    float scale = 1.0f / segments_;
+    // Time constant in seconds whatever the frame spacing: when the hop is
+    // longer than the frame period, frames come once per hop, not at
+    // frameRate.
+    double interval = static_cast<double>(segments_) * hop_ / active_.sampleRate;
+    double alpha = 1.0 - std::exp(-interval / active_.averagingTime);
+    const float* out = frameDb_.data();
+
+    switch (active_.averaging) {
+    case Averaging::LinearPower:
+        // Average linear power (unshifted) across frames, then convert.
+        if (!averageValid_) {
+            for (int i = 0; i < size; ++i) average_[i] = welchSum_[i] * scale;
+            averageValid_ = true;
+        } else {
+            float a = static_cast<float>(alpha);
+            for (int i = 0; i < size; ++i) {
+                average_[i] += a * (welchSum_[i] * scale - average_[i]);
+            }
+        }
+        DspKernels::fftShiftPowerToDb(average_.data(), 1.0f, offsetDb_, frameDb_.data(), size);
+        break;
+    case Averaging::LogPower:
+        DspKernels::fftShiftPowerToDb(welchSum_.data(), scale, offsetDb_, frameDb_.data(), size);
+        if (!averageValid_) {
+            std::copy(frameDb_.begin(), frameDb_.end(), average_.begin());
+            averageValid_ = true;
+        } else {
+            float a = static_cast<float>(alpha);
+            for (int i = 0; i < size; ++i) {
+                average_[i] += a * (frameDb_[i] - average_[i]);
+            }
+        }
+        out = average_.data();
+        break;
+    case Averaging::None:
+    default:
+        DspKernels::fftShiftPowerToDb(welchSum_.data(), scale, offsetDb_, frameDb_.data(), size);
+        break;
+    }
+
+    const float* peak = nullptr;
+    if (active_.peakHold) {
+        if (!peakValid_) {
+            std::copy(out, out + size, peak_.begin());
+            peakValid_ = true;
+        } else {
+            for (int i = 0; i < size; ++i) peak_[i] = std::max(peak_[i], out[i]);
+        }
+        peak = peak_.data();
+    }
+
+    std::fill(welchSum_.begin(), welchSum_.end(), 0.0f);
+    segments_ = 0;
+
+    if (handler_) {
+        handler_(out, peak, size);
+    }
+}
@@ -0,0 +1,143 @@
+#include <SpectrumFrame.h>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+
+SpectrumFrame::SpectrumFrame()
+    : hasPeak_(false),
+      size_(0),
+      timestampNs_(0),
+      centerFrequency_(0.0),
+      span_(0.0),
+      refs_(0) {
+}
+
+SpectrumFrameRef::SpectrumFrameRef(const SpectrumFrameRef& other) noexcept
+    : frame_(other.frame_) {
+    if (frame_) frame_->refs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+SpectrumFrameRef::SpectrumFrameRef(SpectrumFrameRef&& other) noexcept
+    : frame_(other.frame_) {
+    other.frame_ = nullptr;
+}
+
+SpectrumFrameRef& SpectrumFrameRef::operator=(const SpectrumFrameRef& other) noexcept {
+    if (frame_ != other.frame_) {
+        SpectrumFrameRef copy(other);
+        std::swap(frame_, copy.frame_);
+    }
+    return *this;
+}
+
+SpectrumFrameRef& SpectrumFrameRef::operator=(SpectrumFrameRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        frame_ = other.frame_;
+        other.frame_ = nullptr;
+    }
+    return *this;
+}
+
+SpectrumFrameRef::~SpectrumFrameRef() {
+    reset();
+}
+
+void SpectrumFrameRef::reset() {
+    SpectrumFrame* frame = frame_;
+    frame_ = nullptr;
+    if (frame && frame->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        frame->pool_->recycle(frame);
+    }
+}
+
+std::shared_ptr<SpectrumFramePool> SpectrumFramePool::create(int frameCount) {
+    return std::shared_ptr<SpectrumFramePool>(new SpectrumFramePool(frameCount));
+}
+
+SpectrumFramePool::SpectrumFramePool(int frameCount)
+    : droppedFrames_(0) {
+    storage_.reserve(frameCount);
+    freeList_.reserve(frameCount);
+    for (int i = 0; i < frameCount; ++i) {
+        storage_.emplace_back(new SpectrumFrame());
+        freeList_.push_back(storage_.back().get());
+    }
+    qDebug() << "SpectrumFramePool initialized with" << frameCount << "frames";
+}
+
+SpectrumFramePool::~SpectrumFramePool() {
+    qDebug() << "SpectrumFramePool destroyed, dropped frames:" << droppedFrames();
+}
+
+SpectrumFrameRef SpectrumFramePool::acquire(const float* bins, const float* peak, int size,
+                                            double centerFrequency, double span) {
+    SpectrumFrame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!freeList_.empty()) {
+            frame = freeList_.back();
+            freeList_.pop_back();
+        }
+    }
+    if (!frame) {
+        droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+        return SpectrumFrameRef();
+    }
+
+    if (static_cast<int>(frame->bins_.size()) < size) {
+        frame->bins_.resize(size); // Only grows; reused once at the largest size
+    }
+    std::copy(bins, bins + size, frame->bins_.begin());
+    frame->hasPeak_ = peak != nullptr;
+    if (peak) {
+        if (static_cast<int>(frame->peak_.size()) < size) frame->peak_.resize(size);
+        std::copy(peak, peak + size, frame->peak_.begin());
+    }
+    frame->size_ = size;
+    frame->timestampNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    frame->centerFrequency_ = centerFrequency;
+    frame->span_ = span;
+    frame->pool_ = shared_from_this();
+    frame->refs_.store(1, std::memory_order_release);
+    return SpectrumFrameRef(frame);
+}
+
+int SpectrumFramePool::freeFrames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(freeList_.size());
+}
+
+uint64_t SpectrumFramePool::droppedFrames() const {
+    return droppedFrames_.load(std::memory_order_relaxed);
+}
+
+void SpectrumFramePool::recycle(SpectrumFrame* frame) {
+    // The frame's pool reference may be the last one; keep the pool alive
+    // until the frame is back on the free list.
+    std::shared_ptr<SpectrumFramePool> keepAlive = std::move(frame->pool_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeList_.push_back(frame);
+}
+
+SpectrumFrameMailbox::SpectrumFrameMailbox()
+    : slot_(nullptr) {
+}
+
+SpectrumFrameMailbox::~SpectrumFrameMailbox() {
+    take();
+}
+
+bool SpectrumFrameMailbox::post(SpectrumFrameRef frame) {
+    SpectrumFrame* incoming = frame.frame_;
+    frame.frame_ = nullptr; // The mailbox now owns this reference
+    SpectrumFrame* previous = slot_.exchange(incoming, std::memory_order_acq_rel);
+    if (!previous) return false;
+    SpectrumFrameRef unread(previous); // Released here
+    return true;
+}
+
+SpectrumFrameRef SpectrumFrameMailbox::take() {
+    return SpectrumFrameRef(slot_.exchange(nullptr, std::memory_order_acq_rel));
+}
@@ -0,0 +1,248 @@
+#include <SpectrumRenderer.h>
+#include <DspKernels.h>
+#include <Logging.h>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <algorithm>
+
+SpectrumRenderer::SpectrumRenderer(QObject* parent)
+    : QThread(parent),
+      wakeup_(0),
+      stopRequested_(false),
+      readyFresh_(false),
+      notifyPending_(false),
+      rendered_(0),
+      skipped_(0),
+      lastRenderMs_(0.0) {
+    buildPalette();
+    qDebug() << "SpectrumRenderer initialized";
+}
+
+SpectrumRenderer::~SpectrumRenderer() {
+    requestStop();
+    wait();
+    qDebug() << "SpectrumRenderer destroyed, frames rendered:" << getFramesRendered()
+             << "skipped:" << getFramesSkipped();
+}
+
+// Black -> blue -> cyan -> green -> yellow -> red -> white.
+void SpectrumRenderer::buildPalette() {
+    static const int stops[][3] = {
+        {0, 0, 0}, {0, 0, 160}, {0, 160, 255}, {0, 220, 0},
+        {255, 255, 0}, {255, 0, 0}, {255, 255, 255},
+    };
+    const int segments = sizeof(stops) / sizeof(stops[0]) - 1;
+    palette_.resize(PALETTE_SIZE);
+    for (int i = 0; i < PALETTE_SIZE; ++i) {
+        double position = static_cast<double>(i) / (PALETTE_SIZE - 1) * segments;
+        int segment = std::min(static_cast<int>(position), segments - 1);
+        double t = position - segment;
+        int rgb[3];
+        for (int c = 0; c < 3; ++c) {
+            rgb[c] = static_cast<int>(stops[segment][c] + t * (stops[segment + 1][c] - stops[segment][c]));
+        }
+        palette_[i] = qRgb(rgb[0], rgb[1], rgb[2]);
+    }
+}
+
+void SpectrumRenderer::setView(const View& view) {
+    std::lock_guard<std::mutex> lock(viewMutex_);
+    view_ = view;
+}
+
+SpectrumRenderer::View SpectrumRenderer::getView() const {
+    std::lock_guard<std::mutex> lock(viewMutex_);
+    return view_;
+}
+
+void SpectrumRenderer::submit(const SpectrumFrameRef& frame) {
+    if (!frame || frame->size() <= 0) return;
+    if (mailbox_.post(frame)) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (wakeup_.available() == 0) {
+        wakeup_.release();
+    }
+}
+
+void SpectrumRenderer::requestStop() {
+    stopRequested_.store(true);
+    wakeup_.release();
+}
+
+quint64 SpectrumRenderer::getFramesRendered() const {
+    return rendered_.load(std::memory_order_relaxed);
+}
+
+quint64 SpectrumRenderer::getFramesSkipped() const {
+    return skipped_.load(std::memory_order_relaxed);
+}
+
+double SpectrumRenderer::getLastRenderMs() const {
+    return lastRenderMs_.load(std::memory_order_relaxed);
+}
+
+bool SpectrumRenderer::takeResult(Result* result) {
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    notifyPending_.store(false, std::memory_order_relaxed);
+    if (!readyFresh_) return false;
+    std::swap(*result, ready_);
+    readyFresh_ = false;
+    return true;
+}
+
+void SpectrumRenderer::run() {
+    while (!stopRequested_.load(std::memory_order_relaxed)) {
+        wakeup_.tryAcquire(1, WAIT_TIMEOUT_MS);
+        if (stopRequested_.load(std::memory_order_relaxed)) break;
+        SpectrumFrameRef frame = mailbox_.take();
+        if (!frame) continue;
+        View view = getView();
+        if (view.width <= 0 || view.height <= 0) continue;
+
+        QElapsedTimer timer;
+        timer.start();
+        render(*frame, view, &back_);
+        {
+            std::lock_guard<std::mutex> lock(resultMutex_);
+            std::swap(back_, ready_);
+            readyFresh_ = true;
+        }
+        rendered_.fetch_add(1, std::memory_order_relaxed);
+        lastRenderMs_.store(timer.nsecsElapsed() / 1e6, std::memory_order_relaxed);
+        THETIS_TRACE("display.render", frame->size(), timer.nsecsElapsed());
+        if (!notifyPending_.exchange(true, std::memory_order_relaxed)) {
+            emit resultReady();
+        }
+    }
+    wakeup_.tryAcquire(wakeup_.available());
+    qDebug() << "SpectrumRenderer: Exiting";
+}
+
+// Background, grid and labels; redrawn only when the size or view changes.
+void SpectrumRenderer::renderGrid(const View& view) {
+    int width = view.width;
+    int height = view.height;
+    grid_ = QImage(width, height, QImage::Format_RGB32);
+    grid_.fill(Qt::white);
+    QPainter painter(&grid_);
+    painter.setPen(Qt::lightGray);
+    for (int x = 0; x <= width; x += std::max(1, width / 10)) {
+        painter.drawLine(x, 0, x, height);
+    }
+    for (int y = 0; y <= height; y += std::max(1, height / 6)) {
+        painter.drawLine(0, y, width, y);
+    }
+    painter.setPen(Qt::black);
+    painter.setFont(QFont("Arial", 8));
+    double freqMin = view.centerFrequency - view.span / 2.0;
+    double freqMax = view.centerFrequency + view.span / 2.0;
+    float top = view.autoReference ? 0.0f : view.topDb;
+    painter.drawText(QRectF(0, height - 20, 60, 20),
+                     QString("%1 MHz").arg(freqMin / 1e6, 0, 'f', 3));
+    painter.drawText(QRectF(width - 60, height - 20, 60, 20),
+                     QString("%1 MHz").arg(freqMax / 1e6, 0, 'f', 3));
+    painter.drawText(QRectF(0, 0, 50, 20), QString("%1 dB").arg(top));
+    painter.drawText(QRectF(0, height - 20, 50, 20), QString("%1 dB").arg(top - view.rangeDb));
+    gridView_ = view;
+}
+
+void SpectrumRenderer::render(const SpectrumFrame& frame, const View& view, Result* result) {
+    bool gridStale = grid_.isNull() || view.width != gridView_.width || view.height != gridView_.height ||
+                     view.centerFrequency != gridView_.centerFrequency || view.span != gridView_.span ||
+                     view.autoReference != gridView_.autoReference || view.topDb != gridView_.topDb ||
+                     view.rangeDb != gridView_.rangeDb;
+    if (gridStale) renderGrid(view);
+    if (result->spectrum.width() != view.width || result->spectrum.height() != view.height) {
+        result->spectrum = QImage(view.width, view.height, QImage::Format_RGB32);
+    }
+
+    int width = view.width;
+    int height = view.height;
+    columnMin_.resize(width);
+    columnMax_.resize(width);
+    columnMean_.resize(width);
+    DspKernels::columnStats(frame.bins(), frame.size(), width,
+                            columnMin_.data(), columnMax_.data(), columnMean_.data());
+    float top = view.autoReference ? *std::max_element(columnMax_.begin(), columnMax_.end())
+                                   : view.topDb;
+    float yScale = height / std::max(1.0f, view.rangeDb);
+    auto toY = [&](float db) {
+        return std::max(0.0f, std::min(static_cast<float>(height), (top - db) * yScale));
+    };
+
+    trace_.clear();
+    switch (view.style) {
+    case TraceStyle::Peak:
+        for (int x = 0; x < width; ++x) {
+            trace_.append(QPointF(x, toY(columnMax_[x])));
+            if (columnMin_[x] != columnMax_[x]) trace_.append(QPointF(x, toY(columnMin_[x])));
+        }
+        break;
+    case TraceStyle::Average:
+        for (int x = 0; x < width; ++x) {
+            trace_.append(QPointF(x, toY(columnMean_[x])));
+        }
+        break;
+    case TraceStyle::Fill:
+        trace_.append(QPointF(0, height));
+        for (int x = 0; x < width; ++x) {
+            trace_.append(QPointF(x, toY(columnMax_[x])));
+        }
+        trace_.append(QPointF(width - 1, height));
+        break;
+    }
+    // Held peaks are drawn over the trace as a line through each column's
+    // strongest bin.
+    peakTrace_.clear();
+    if (frame.peak()) {
+        DspKernels::columnStats(frame.peak(), frame.size(), width,
+                                columnMin_.data(), columnMax_.data(), columnMean_.data());
+        for (int x = 0; x < width; ++x) {
+            peakTrace_.append(QPointF(x, toY(columnMax_[x])));
+        }
+    }
+
+    QPainter painter(&result->spectrum);
+    painter.drawImage(0, 0, grid_);
+    if (view.style == TraceStyle::Fill) {
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(0, 0, 255, 80));
+        painter.drawPolygon(trace_);
+        painter.setPen(QPen(Qt::blue, 1));
+        painter.drawPolyline(trace_.constData() + 1, trace_.size() - 2);
+    } else {
+        painter.setPen(QPen(Qt::blue, 1));
+        painter.drawPolyline(trace_);
+    }
+    if (!peakTrace_.isEmpty()) {
+        painter.setPen(QPen(QColor(255, 140, 0), 1));
+        painter.drawPolyline(peakTrace_);
+    }
+    painter.end();
+
+    renderWaterfallLine(frame, view, result);
+    result->timestampNs = frame.timestampNs();
+    THETIS_DEBUG_EVERY_MS(lcDisplay, 1000) << "SpectrumRenderer: Rendered" << frame.size() << "bins as"
+                                           << trace_.size() << "points, top:" << top << "dB";
+}
+
+// Each pixel column takes the strongest bin it covers, so narrow carriers
+// stay visible at any zoom.
+void SpectrumRenderer::renderWaterfallLine(const SpectrumFrame& frame, const View& view, Result* result) {
+    int columns = view.waterfallWidth;
+    result->waterfallLine.resize(std::max(0, columns));
+    if (columns <= 0) return;
+    columnMin_.resize(columns);
+    columnMax_.resize(columns);
+    columnMean_.resize(columns);
+    DspKernels::columnStats(frame.bins(), frame.size(), columns,
+                            columnMin_.data(), columnMax_.data(), columnMean_.data());
+    float scale = (PALETTE_SIZE - 1) / std::max(1.0f, view.waterfallCeilingDb - view.waterfallFloorDb);
+    QRgb* line = result->waterfallLine.data();
+    for (int x = 0; x < columns; ++x) {
+        int index = static_cast<int>((columnMax_[x] - view.waterfallFloorDb) * scale);
+        line[x] = palette_[std::max(0, std::min(PALETTE_SIZE - 1, index))];
+    }
+}
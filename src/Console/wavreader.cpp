@@ -0,0 +1,256 @@
+#include <WavReader.h>
+#include <DspKernels.h>
+#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const uint16_t FORMAT_PCM = 1;
+const uint16_t FORMAT_FLOAT = 3;
+const uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+const uint32_t SIZE_IN_DS64 = 0xFFFFFFFF; // RF64 placeholder for a 64-bit size
+
+uint16_t le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t le64(const uint8_t* p) {
+    return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32);
+}
+
+uint64_t pageSize() {
+    static const uint64_t size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+uint64_t pageDown(uint64_t offset) {
+    return offset & ~(pageSize() - 1);
+}
+
+} // namespace
+
+WavReader::WavReader()
+    : map_(nullptr),
+      mapSize_(0),
+      dataOffset_(0),
+      dataSize_(0),
+      frameBytes_(0),
+      position_(0),
+      releasedTo_(0),
+      prefetchedTo_(0) {}
+
+WavReader::~WavReader() {
+    close();
+}
+
+bool WavReader::open(const QString& path) {
+    close();
+    int fd = ::open(path.toStdString().c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        qDebug() << "WavReader: Failed to open" << path << ":" << strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < 12) {
+        qDebug() << "WavReader: File too short:" << path;
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        qDebug() << "WavReader: Failed to map" << path << ":" << strerror(errno);
+        return false;
+    }
+    map_ = static_cast<const uint8_t*>(map);
+    mapSize_ = static_cast<uint64_t>(info.st_size);
+    madvise(map, mapSize_, MADV_SEQUENTIAL);
+
+    if (!parse(path)) {
+        close();
+        return false;
+    }
+    seek(0);
+    qDebug() << "WavReader: Opened" << path << "Channels:" << format_.channels
+             << "SampleRate:" << format_.sampleRate << "Encoding:" << encodingName(format_.encoding)
+             << "Frames:" << format_.frames;
+    return true;
+}
+
+void WavReader::close() {
+    if (map_) {
+        munmap(const_cast<uint8_t*>(map_), mapSize_);
+    }
+    map_ = nullptr;
+    mapSize_ = 0;
+    dataOffset_ = 0;
+    dataSize_ = 0;
+    frameBytes_ = 0;
+    format_ = Format();
+    position_ = 0;
+}
+
+bool WavReader::isOpen() const {
+    return map_ != nullptr;
+}
+
+const WavReader::Format& WavReader::format() const {
+    return format_;
+}
+
+const char* WavReader::encodingName(Encoding encoding) {
+    switch (encoding) {
+    case Encoding::Int16: return "int16";
+    case Encoding::Int24: return "int24";
+    case Encoding::Int32: return "int32";
+    case Encoding::Float32: return "float32";
+    }
+    return "unknown";
+}
+
+// Walks the chunk list from the WAVE tag. Chunks are word-aligned: an odd
+// size is followed by one pad byte.
+bool WavReader::parse(const QString& path) {
+    bool rf64 = std::memcmp(map_, "RF64", 4) == 0 || std::memcmp(map_, "BW64", 4) == 0;
+    if ((!rf64 && std::memcmp(map_, "RIFF", 4) != 0) || std::memcmp(map_ + 8, "WAVE", 4) != 0) {
+        qDebug() << "WavReader: Not a WAV file:" << path;
+        return false;
+    }
+
+    bool haveFormat = false;
+    bool haveData = false;
+    uint16_t tag = 0;
+    uint64_t ds64DataSize = 0;
+    bool haveDs64 = false;
+    uint64_t pos = 12;
+    while (pos + 8 <= mapSize_ && !(haveFormat && haveData)) {
+        const uint8_t* chunk = map_ + pos;
+        uint64_t size = le32(chunk + 4);
+        uint64_t body = pos + 8;
+        if (std::memcmp(chunk, "ds64", 4) == 0 && size >= 24 && body + 24 <= mapSize_) {
+            ds64DataSize = le64(chunk + 16);
+            haveDs64 = true;
+        } else if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (size < 16 || body + size > mapSize_) {
+                qDebug() << "WavReader: Truncated fmt chunk:" << path;
+                return false;
+            }
+            tag = le16(chunk + 8);
+            format_.channels = le16(chunk + 10);
+            format_.sampleRate = static_cast<int>(le32(chunk + 12));
+            format_.bitsPerSample = le16(chunk + 22);
+            // The real format is the first two bytes of the sub-format GUID.
+            if (tag == FORMAT_EXTENSIBLE && size >= 40) {
+                tag = le16(chunk + 32);
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (size == SIZE_IN_DS64 && haveDs64) {
+                size = ds64DataSize;
+            } else if (size == 0 || size == SIZE_IN_DS64) {
+                // Never finalised: take everything up to the end of the file.
+                size = mapSize_ - body;
+            }
+            dataOffset_ = body;
+            dataSize_ = std::min(size, mapSize_ - std::min(body, mapSize_));
+            haveData = true;
+        }
+        pos = body + size + (size & 1);
+    }
+
+    if (!haveFormat || !haveData) {
+        qDebug() << "WavReader: Missing" << (haveFormat ? "data" : "fmt") << "chunk:" << path;
+        return false;
+    }
+    if (tag == FORMAT_PCM && format_.bitsPerSample == 16) {
+        format_.encoding = Encoding::Int16;
+    } else if (tag == FORMAT_PCM && format_.bitsPerSample == 24) {
+        format_.encoding = Encoding::Int24;
+    } else if (tag == FORMAT_PCM && format_.bitsPerSample == 32) {
+        format_.encoding = Encoding::Int32;
+    } else if (tag == FORMAT_FLOAT && format_.bitsPerSample == 32) {
+        format_.encoding = Encoding::Float32;
+    } else {
+        qDebug() << "WavReader: Unsupported format tag" << tag << "with" << format_.bitsPerSample
+                 << "bits:" << path;
+        return false;
+    }
+    if (format_.channels < 1 || format_.channels > MAX_CHANNELS || format_.sampleRate <= 0) {
+        qDebug() << "WavReader: Unsupported layout," << format_.channels << "channels at"
+                 << format_.sampleRate << "Hz:" << path;
+        return false;
+    }
+    frameBytes_ = format_.channels * format_.bitsPerSample / 8;
+    format_.frames = dataSize_ / frameBytes_;
+    return true;
+}
+
+uint64_t WavReader::position() const {
+    return position_;
+}
+
+bool WavReader::seek(uint64_t frame) {
+    if (!map_ || frame > format_.frames) return false;
+    position_ = frame;
+    uint64_t offset = dataOffset_ + frame * frameBytes_;
+    releasedTo_ = pageDown(offset);
+    prefetchedTo_ = releasedTo_;
+    return true;
+}
+
+// Keeps READAHEAD_BYTES requested ahead of the read position and hands
+// pages more than RELEASE_BYTES behind it back to the page cache. Both are
+// hints; a failure only costs memory or a page fault.
+void WavReader::advise(uint64_t begin, uint64_t end) {
+    uint8_t* base = const_cast<uint8_t*>(map_);
+    uint64_t wanted = std::min(end + READAHEAD_BYTES, mapSize_);
+    if (wanted > prefetchedTo_) {
+        uint64_t from = pageDown(std::max(prefetchedTo_, begin));
+        madvise(base + from, wanted - from, MADV_WILLNEED);
+        prefetchedTo_ = wanted;
+    }
+    uint64_t done = pageDown(begin);
+    if (done >= releasedTo_ + RELEASE_BYTES) {
+        madvise(base + releasedTo_, done - releasedTo_, MADV_DONTNEED);
+        releasedTo_ = done;
+    }
+}
+
+size_t WavReader::read(float* out, size_t frames) {
+    if (!map_) return 0;
+    size_t n = static_cast<size_t>(std::min<uint64_t>(frames, format_.frames - position_));
+    if (n == 0) return 0;
+    uint64_t offset = dataOffset_ + position_ * frameBytes_;
+    advise(offset, offset + n * frameBytes_);
+
+    const uint8_t* in = map_ + offset;
+    int samples = static_cast<int>(n * format_.channels);
+    switch (format_.encoding) {
+    case Encoding::Int16:
+        DspKernels::int16LEToFloat(in, 1.0f / 32768.0f, out, samples);
+        break;
+    case Encoding::Int24:
+        DspKernels::int24LEToFloat(in, 1.0f / 8388608.0f, out, samples);
+        break;
+    case Encoding::Int32:
+        DspKernels::int32LEToFloat(in, 1.0f / 2147483648.0f, out, samples);
+        break;
+    case Encoding::Float32:
+        std::memcpy(out, in, samples * sizeof(float));
+        break;
+    }
+    position_ += n;
+    return n;
+}
@@ -0,0 +1,426 @@
+#include <WavRecorder.h>
+#include <DspThread.h>
+#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+const size_t BUFFER_ALIGNMENT = 4096;
+const uint64_t MAX_RIFF_SIZE = 0xFFFFFFFF;
+const uint32_t SIZE_IN_DS64 = 0xFFFFFFFF; // RF64 placeholder for a 64-bit size
+
+void put16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+void put64(uint8_t* p, uint64_t v) {
+    put32(p, static_cast<uint32_t>(v));
+    put32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+int bytesPerSample(WavRecorder::Encoding encoding) {
+    switch (encoding) {
+    case WavRecorder::Encoding::Int16: return 2;
+    case WavRecorder::Encoding::Int24: return 3;
+    case WavRecorder::Encoding::Int32:
+    case WavRecorder::Encoding::Float32: return 4;
+    }
+    return 4;
+}
+
+} // namespace
+
+void WavRecorder::AlignedFree::operator()(uint8_t* p) const {
+    std::free(p);
+}
+
+WavRecorder::WavRecorder()
+    : fd_(-1),
+      sampleBytes_(2),
+      frameBytes_(4),
+      bufferUsed_(0),
+      resampling_(false),
+      dataBytes_(0),
+      rf64_(false),
+      failed_(false),
+      ditherState_(0x12345678),
+      writerThread_(new DspThread()),
+      active_(false),
+      inWrite_(false),
+      channels_(1),
+      framesWritten_(0),
+      droppedFrames_(0) {
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, BUFFER_ALIGNMENT, BUFFER_BYTES) == 0) {
+        buffer_.reset(static_cast<uint8_t*>(buffer));
+    }
+    writerThread_->setWorkFunction([this]() { service(); });
+    writerThread_->startProcessing(QThread::NormalPriority);
+}
+
+WavRecorder::~WavRecorder() {
+    writerThread_->requestStop();
+    writerThread_->wait();
+    stop();
+}
+
+bool WavRecorder::start(const QString& path, const Format& format) {
+    stop();
+    const int inputRate = format.inputRate > 0 ? format.inputRate : format.sampleRate;
+    if (format.channels < 1 || format.channels > WavReader::MAX_CHANNELS || format.sampleRate <= 0) {
+        qDebug() << "WavRecorder: Unsupported layout," << format.channels << "channels at"
+                 << format.sampleRate << "Hz";
+        return false;
+    }
+    if (!buffer_) {
+        qDebug() << "WavRecorder: No write buffer";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    int fd = ::open(path.toStdString().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        qDebug() << "WavRecorder: Failed to create" << path << ":" << strerror(errno);
+        return false;
+    }
+    fd_ = fd;
+    format_ = format;
+    format_.inputRate = inputRate;
+    resampling_ = inputRate != format.sampleRate;
+    if (resampling_) {
+        resampler_.configure(inputRate, format.sampleRate, format.channels, format.quality);
+        if (resampler_.wantedTaps() > resampler_.taps()) {
+            qDebug() << "WavRecorder: Filter truncated to" << resampler_.taps() << "of"
+                     << resampler_.wantedTaps() << "taps, passband edge will droop";
+        }
+        resampled_.resize(resampler_.maxOutput(RING_WINDOW / format.channels) * format.channels);
+    }
+    sampleBytes_ = bytesPerSample(format.encoding);
+    frameBytes_ = sampleBytes_ * format.channels;
+    bufferUsed_ = 0;
+    dataBytes_ = 0;
+    rf64_ = false;
+    failed_ = false;
+    if (!writeHeader()) {
+        qDebug() << "WavRecorder: Failed to write header to" << path << ":" << strerror(errno);
+        closeFile();
+        return false;
+    }
+    size_t capacity = static_cast<size_t>(inputRate) * format.channels * RING_MS / 1000;
+    ring_.reset(new AudioRingBuffer(std::max<size_t>(capacity, RING_WINDOW), RING_WINDOW));
+    lastCheckpoint_ = std::chrono::steady_clock::now();
+    framesWritten_.store(0);
+    droppedFrames_.store(0);
+    channels_.store(format.channels);
+    active_.store(true);
+    qDebug() << "WavRecorder: Recording to" << path << "Channels:" << format.channels
+             << "SampleRate:" << format.sampleRate << "InputRate:" << inputRate
+             << "Encoding:" << WavReader::encodingName(format.encoding);
+    return true;
+}
+
+void WavRecorder::stop() {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (fd_ < 0) return;
+    active_.store(false);
+    waitForProducer();
+    drain();
+    if (resampling_ && !failed_) {
+        // The last latencyFrames() of input are still in the filter.
+        std::vector<float> tail(resampler_.maxOutput(resampler_.latencyFrames()) * format_.channels);
+        append(tail.data(), resampler_.flush(tail.data()) * format_.channels);
+    }
+    flushBuffer();
+    // An odd-sized data chunk is followed by a pad byte.
+    if (dataBytes_ & 1) {
+        uint8_t pad = 0;
+        if (pwrite(fd_, &pad, 1, HEADER_BYTES + dataBytes_) != 1) failed_ = true;
+    }
+    writeHeader();
+    fdatasync(fd_);
+    qDebug() << "WavRecorder: Stopped," << framesWritten_.load() << "frames written,"
+             << droppedFrames_.load() << "dropped" << (rf64_ ? "(RF64)" : "");
+    closeFile();
+}
+
+bool WavRecorder::isRecording() const {
+    return active_.load(std::memory_order_relaxed);
+}
+
+WavRecorder::Format WavRecorder::format() const {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    return format_;
+}
+
+uint64_t WavRecorder::framesWritten() const {
+    return framesWritten_.load(std::memory_order_relaxed);
+}
+
+uint64_t WavRecorder::droppedFrames() const {
+    return droppedFrames_.load(std::memory_order_relaxed);
+}
+
+bool WavRecorder::isRf64() const {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    return rf64_;
+}
+
+// Same handshake as AudioProcessor: the producer raises inWrite_ before it
+// checks active_, so once active_ is cleared and inWrite_ reads false the
+// ring is no longer in use.
+void WavRecorder::waitForProducer() const {
+    while (inWrite_.load()) {
+        std::this_thread::yield();
+    }
+}
+
+bool WavRecorder::write(const float* interleaved, size_t frames) {
+    inWrite_.store(true);
+    bool queued = false;
+    if (active_.load()) {
+        size_t count = frames * channels_.load(std::memory_order_relaxed);
+        if (ring_->space() >= count) {
+            ring_->write(interleaved, count);
+            queued = true;
+        } else {
+            droppedFrames_.fetch_add(frames, std::memory_order_relaxed);
+        }
+    }
+    inWrite_.store(false);
+    return queued;
+}
+
+bool WavRecorder::write(const float* interleaved, size_t frames, int inputChannels) {
+    const int channels = channels_.load(std::memory_order_relaxed);
+    if (inputChannels == channels) {
+        return write(interleaved, frames);
+    }
+    inWrite_.store(true);
+    bool queued = false;
+    if (active_.load() && inputChannels > 0) {
+        if (ring_->space() >= frames * channels) {
+            // Single producer: the space only grows while this copies.
+            float chunk[1024];
+            const size_t chunkFrames = sizeof(chunk) / sizeof(chunk[0]) / channels;
+            for (size_t done = 0; done < frames;) {
+                size_t count = std::min(frames - done, chunkFrames);
+                for (size_t f = 0; f < count; ++f) {
+                    const float* frame = interleaved + (done + f) * inputChannels;
+                    for (int c = 0; c < channels; ++c) {
+                        chunk[f * channels + c] = frame[std::min(c, inputChannels - 1)];
+                    }
+                }
+                ring_->write(chunk, count * channels);
+                done += count;
+            }
+            queued = true;
+        } else {
+            droppedFrames_.fetch_add(frames, std::memory_order_relaxed);
+        }
+    }
+    inWrite_.store(false);
+    return queued;
+}
+
+bool WavRecorder::writeWait(const float* interleaved, size_t frames) {
+    for (;;) {
+        inWrite_.store(true);
+        if (!active_.load()) {
+            inWrite_.store(false);
+            return false;
+        }
+        size_t count = frames * channels_.load(std::memory_order_relaxed);
+        if (count > ring_->capacity()) {
+            inWrite_.store(false);
+            return false;
+        }
+        if (ring_->space() >= count) {
+            ring_->write(interleaved, count);
+            inWrite_.store(false);
+            return true;
+        }
+        inWrite_.store(false);
+        writerThread_->wake();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void WavRecorder::service() {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (fd_ < 0) return;
+    drain();
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastCheckpoint_ >= std::chrono::milliseconds(static_cast<int>(CHECKPOINT_MS))) {
+        checkpoint();
+        lastCheckpoint_ = now;
+    }
+}
+
+// Converts whole frames from the ring, resampled if need be, into the write
+// buffer. After a write error the queue is discarded so the producer keeps
+// running; the failure has already been logged.
+void WavRecorder::drain() {
+    const size_t channels = format_.channels;
+    const size_t window = ring_->maxWindow() / channels * channels;
+    size_t available;
+    while ((available = ring_->available()) >= channels) {
+        size_t count = std::min(available / channels * channels, window);
+        if (failed_) {
+            ring_->consume(count);
+            droppedFrames_.fetch_add(count / channels, std::memory_order_relaxed);
+            continue;
+        }
+        const float* samples = ring_->peek(count);
+        if (!samples) break;
+        if (resampling_) {
+            size_t frames = resampler_.process(samples, count / channels, resampled_.data());
+            append(resampled_.data(), frames * channels);
+        } else {
+            append(samples, count);
+        }
+        ring_->consume(count);
+    }
+}
+
+// Appends count samples (whole frames) to the write buffer, flushing it
+// each time it fills.
+void WavRecorder::append(const float* samples, size_t count) {
+    const size_t channels = format_.channels;
+    while (count > 0 && !failed_) {
+        size_t room = (BUFFER_BYTES - bufferUsed_) / frameBytes_ * channels;
+        if (room == 0) {
+            flushBuffer();
+            continue;
+        }
+        size_t n = std::min(count, room);
+        convert(samples, n, buffer_.get() + bufferUsed_);
+        bufferUsed_ += n * sampleBytes_;
+        samples += n;
+        count -= n;
+    }
+}
+
+// Integer encodings are scaled to full range and, below 32 bits, get TPDF
+// dither of +-1 LSB (the difference of two uniform variates) before
+// rounding. Samples are written little-endian.
+void WavRecorder::convert(const float* in, size_t samples, uint8_t* out) {
+    auto uniform = [this]() {
+        ditherState_ ^= ditherState_ << 13;
+        ditherState_ ^= ditherState_ >> 17;
+        ditherState_ ^= ditherState_ << 5;
+        return static_cast<float>(ditherState_) * (1.0f / 4294967296.0f);
+    };
+    bool dither = format_.dither;
+    switch (format_.encoding) {
+    case Encoding::Int16:
+        for (size_t i = 0; i < samples; ++i, out += 2) {
+            float v = std::max(-1.0f, std::min(in[i], 1.0f)) * 32767.0f;
+            if (dither) v += uniform() - uniform();
+            long q = std::max(-32768L, std::min(std::lrint(v), 32767L));
+            put16(out, static_cast<uint16_t>(q));
+        }
+        break;
+    case Encoding::Int24:
+        for (size_t i = 0; i < samples; ++i, out += 3) {
+            float v = std::max(-1.0f, std::min(in[i], 1.0f)) * 8388607.0f;
+            if (dither) v += uniform() - uniform();
+            long q = std::max(-8388608L, std::min(std::lrint(v), 8388607L));
+            out[0] = static_cast<uint8_t>(q);
+            out[1] = static_cast<uint8_t>(q >> 8);
+            out[2] = static_cast<uint8_t>(q >> 16);
+        }
+        break;
+    case Encoding::Int32:
+        for (size_t i = 0; i < samples; ++i, out += 4) {
+            double v = std::max(-1.0, std::min(static_cast<double>(in[i]), 1.0)) * 2147483647.0;
+            put32(out, static_cast<uint32_t>(static_cast<int32_t>(std::llrint(v))));
+        }
+        break;
+    case Encoding::Float32:
+        std::memcpy(out, in, samples * sizeof(float));
+        break;
+    }
+}
+
+bool WavRecorder::flushBuffer() {
+    size_t done = 0;
+    while (done < bufferUsed_ && !failed_) {
+        ssize_t n = pwrite(fd_, buffer_.get() + done, bufferUsed_ - done, HEADER_BYTES + dataBytes_);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            qDebug() << "WavRecorder: Write failed after" << dataBytes_ << "bytes:" << strerror(errno);
+            failed_ = true;
+            break;
+        }
+        done += n;
+        dataBytes_ += n;
+    }
+    bufferUsed_ = 0;
+    framesWritten_.store(dataBytes_ / frameBytes_, std::memory_order_relaxed);
+    return !failed_;
+}
+
+// Makes everything written so far durable and described by the header,
+// then lets the kernel drop those pages from the page cache.
+void WavRecorder::checkpoint() {
+    flushBuffer();
+    writeHeader();
+    fdatasync(fd_);
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+// RIFF while the sizes fit in 32 bits, with a JUNK chunk holding the space
+// for ds64; RF64 with the real sizes in ds64 afterwards. Only whole frames
+// are counted, so a header written mid-frame still describes valid data.
+bool WavRecorder::writeHeader() {
+    uint64_t data = dataBytes_ / frameBytes_ * frameBytes_;
+    uint64_t riffSize = HEADER_BYTES - 8 + data + (data & 1);
+    bool rf64 = riffSize > MAX_RIFF_SIZE;
+    if (rf64 && !rf64_) {
+        qDebug() << "WavRecorder: Passed 4 GB, switching to RF64";
+    }
+    rf64_ = rf64;
+
+    uint8_t header[HEADER_BYTES] = {};
+    std::memcpy(header, rf64 ? "RF64" : "RIFF", 4);
+    put32(header + 4, rf64 ? SIZE_IN_DS64 : static_cast<uint32_t>(riffSize));
+    std::memcpy(header + 8, "WAVE", 4);
+    std::memcpy(header + 12, rf64 ? "ds64" : "JUNK", 4);
+    put32(header + 16, 28);
+    if (rf64) {
+        put64(header + 20, riffSize);
+        put64(header + 28, data);
+        put64(header + 36, data / frameBytes_);
+        put32(header + 44, 0); // No table entries
+    }
+    std::memcpy(header + 48, "fmt ", 4);
+    put32(header + 52, 16);
+    put16(header + 56, format_.encoding == Encoding::Float32 ? 3 : 1);
+    put16(header + 58, static_cast<uint16_t>(format_.channels));
+    put32(header + 60, static_cast<uint32_t>(format_.sampleRate));
+    put32(header + 64, static_cast<uint32_t>(format_.sampleRate) * frameBytes_);
+    put16(header + 68, static_cast<uint16_t>(frameBytes_));
+    put16(header + 70, static_cast<uint16_t>(sampleBytes_ * 8));
+    std::memcpy(header + 72, "data", 4);
+    put32(header + 76, rf64 ? SIZE_IN_DS64 : static_cast<uint32_t>(data));
+    return pwrite(fd_, header, HEADER_BYTES, 0) == HEADER_BYTES;
+}
+
+void WavRecorder::closeFile() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+}
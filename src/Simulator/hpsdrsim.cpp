@@ -0,0 +1,395 @@
+// Minimal openHPSDR radio simulator for testing NetworkIO without hardware.
+//
+// Listens like a radio (Protocol 1 on port 1024, Protocol 2 high-priority
+// commands on port 1027). When the client sends a start command, streams a
+// test tone plus noise as 24-bit I/Q to the address the command came from
+// (Protocol 2: to that host's DDC port, 1035 + DDC, with a high-priority
+// status packet to its port 1025 ten times a second). With --target it
+// streams straight away without waiting for a start command. --loss and
+// --reorder drop or swap that percentage of packets to exercise the
+// client's jitter buffer.
+//
+//   hpsdrsim [--protocol 1|2] [--rate 48000] [--receivers 1] [--tone 1000]
+//            [--level -20] [--noise -100] [--target host:port] [--count N]
+//            [--loss 0] [--reorder 0]
+
+#include <HpsdrProtocol.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> quitRequested(false);
+
+void handleSignal(int) {
+    quitRequested = true;
+}
+
+struct Options {
+    int protocol = 1;
+    int sampleRate = 48000;
+    int receivers = 1;
+    double toneHz = 1000.0;
+    double levelDb = -20.0;
+    double noiseDb = -100.0;
+    std::string target;
+    long long count = -1; // Packets to send; -1 = until stopped
+    double lossPercent = 0.0;
+    double reorderPercent = 0.0;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: hpsdrsim [--protocol 1|2] [--rate Hz] [--receivers N] [--tone Hz]\n"
+                 "                [--level dBFS] [--noise dBFS] [--target host:port] [--count N]\n"
+                 "                [--loss percent] [--reorder percent]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--protocol") options.protocol = std::atoi(value);
+        else if (arg == "--rate") options.sampleRate = std::atoi(value);
+        else if (arg == "--receivers") options.receivers = std::atoi(value);
+        else if (arg == "--tone") options.toneHz = std::atof(value);
+        else if (arg == "--level") options.levelDb = std::atof(value);
+        else if (arg == "--noise") options.noiseDb = std::atof(value);
+        else if (arg == "--target") options.target = value;
+        else if (arg == "--count") options.count = std::atoll(value);
+        else if (arg == "--loss") options.lossPercent = std::atof(value);
+        else if (arg == "--reorder") options.reorderPercent = std::atof(value);
+        else {
+            usage();
+            return false;
+        }
+    }
+    if ((options.protocol != 1 && options.protocol != 2) || options.sampleRate <= 0 ||
+        options.receivers < 1 || options.receivers > HpsdrProtocol::MAX_DDCS) {
+        usage();
+        return false;
+    }
+    return true;
+}
+
+int openSocket(int port) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+inline void putBE32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+inline void putInt24(uint8_t* p, double value) {
+    long v = std::lround(value * 8388607.0);
+    v = std::max(-8388608L, std::min(8388607L, v));
+    uint32_t u = static_cast<uint32_t>(v) & 0xFFFFFF;
+    p[0] = static_cast<uint8_t>(u >> 16);
+    p[1] = static_cast<uint8_t>(u >> 8);
+    p[2] = static_cast<uint8_t>(u);
+}
+
+// Test signal: one tone per receiver, offset by 1 kHz per receiver so the
+// DDCs are distinguishable, plus Gaussian noise.
+class SignalSource {
+public:
+    SignalSource(const Options& options)
+        : rate_(options.sampleRate),
+          amplitude_(std::pow(10.0, options.levelDb / 20.0)),
+          noise_(std::pow(10.0, options.noiseDb / 20.0) / std::sqrt(2.0)),
+          phase_(options.receivers, 0.0),
+          tone_(options.toneHz),
+          gauss_(0.0, 1.0) {
+    }
+
+    void next(int receiver, double& i, double& q) {
+        double step = 2.0 * M_PI * (tone_ + 1000.0 * receiver) / rate_;
+        phase_[receiver] = std::fmod(phase_[receiver] + step, 2.0 * M_PI);
+        i = amplitude_ * std::cos(phase_[receiver]) + noise_ * gauss_(rng_);
+        q = amplitude_ * std::sin(phase_[receiver]) + noise_ * gauss_(rng_);
+    }
+
+private:
+    double rate_;
+    double amplitude_;
+    double noise_;
+    std::vector<double> phase_;
+    double tone_;
+    std::mt19937 rng_;
+    std::normal_distribution<double> gauss_;
+};
+
+// Fills a Protocol 1 EP6 packet; returns complex samples per receiver.
+int buildP1Packet(uint8_t* packet, uint32_t sequence, int receivers, SignalSource& source) {
+    std::memset(packet, 0, HpsdrProtocol::P1_PACKET_SIZE);
+    packet[0] = 0xEF;
+    packet[1] = 0xFE;
+    packet[2] = 0x01;
+    packet[3] = HpsdrProtocol::P1_ENDPOINT_IQ;
+    putBE32(packet + 4, sequence);
+
+    int slotBytes = 6 * receivers + 2;
+    int slotCount = (HpsdrProtocol::P1_FRAME_SIZE - HpsdrProtocol::P1_FRAME_HEADER_SIZE) / slotBytes;
+    for (int f = 0; f < 2; ++f) {
+        uint8_t* frame = packet + HpsdrProtocol::P1_HEADER_SIZE + f * HpsdrProtocol::P1_FRAME_SIZE;
+        frame[0] = frame[1] = frame[2] = 0x7F;
+        // Alternate status addresses 0 (firmware version) and 1 (power).
+        uint8_t address = static_cast<uint8_t>((sequence * 2 + f) % 2);
+        frame[3] = static_cast<uint8_t>(address << 3);
+        if (address == 0) frame[7] = 73;
+        uint8_t* slot = frame + HpsdrProtocol::P1_FRAME_HEADER_SIZE;
+        for (int s = 0; s < slotCount; ++s, slot += slotBytes) {
+            for (int r = 0; r < receivers; ++r) {
+                double i, q;
+                source.next(r, i, q);
+                putInt24(slot + 6 * r, i);
+                putInt24(slot + 6 * r + 3, q);
+            }
+        }
+    }
+    return 2 * slotCount;
+}
+
+// Fills a Protocol 2 DDC I/Q packet; returns its size.
+int buildP2Packet(uint8_t* packet, uint32_t sequence, uint64_t timestamp, int ddc,
+                  SignalSource& source) {
+    const int samples = HpsdrProtocol::P2_IQ_SAMPLES_PER_FRAME;
+    putBE32(packet, sequence);
+    putBE32(packet + 4, static_cast<uint32_t>(timestamp >> 32));
+    putBE32(packet + 8, static_cast<uint32_t>(timestamp));
+    packet[12] = 0;
+    packet[13] = 24;
+    packet[14] = static_cast<uint8_t>(samples >> 8);
+    packet[15] = static_cast<uint8_t>(samples);
+    uint8_t* p = packet + HpsdrProtocol::P2_IQ_HEADER_SIZE;
+    for (int s = 0; s < samples; ++s, p += 6) {
+        double i, q;
+        source.next(ddc, i, q);
+        putInt24(p, i);
+        putInt24(p + 3, q);
+    }
+    return HpsdrProtocol::P2_IQ_HEADER_SIZE + samples * 6;
+}
+
+// Fills a Protocol 2 high-priority status packet: no PTT, no overload,
+// all power readings zero.
+int buildP2Status(uint8_t* packet, uint32_t sequence) {
+    std::memset(packet, 0, HpsdrProtocol::P2_STATUS_SIZE);
+    putBE32(packet, sequence);
+    return HpsdrProtocol::P2_STATUS_SIZE;
+}
+
+// Sends packets, dropping some and delaying others past their successor.
+class Link {
+public:
+    Link(int fd, const Options& options)
+        : fd_(fd),
+          loss_(options.lossPercent / 100.0),
+          reorder_(options.reorderPercent / 100.0),
+          uniform_(0.0, 1.0),
+          heldSize_(0),
+          dropped_(0),
+          reordered_(0) {
+    }
+
+    void send(const uint8_t* data, int size, const struct sockaddr_in& to) {
+        if (uniform_(rng_) < loss_) {
+            ++dropped_;
+            return;
+        }
+        if (heldSize_ == 0 && uniform_(rng_) < reorder_) {
+            held_.assign(data, data + size);
+            heldSize_ = size;
+            heldTo_ = to;
+            ++reordered_;
+            return;
+        }
+        sendNow(data, size, to);
+        if (heldSize_ > 0) {
+            sendNow(held_.data(), heldSize_, heldTo_);
+            heldSize_ = 0;
+        }
+    }
+
+    long long dropped() const { return dropped_; }
+    long long reordered() const { return reordered_; }
+
+private:
+    void sendNow(const uint8_t* data, int size, const struct sockaddr_in& to) {
+        ::sendto(fd_, data, size, 0, reinterpret_cast<const struct sockaddr*>(&to), sizeof(to));
+    }
+
+    int fd_;
+    double loss_;
+    double reorder_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    std::vector<uint8_t> held_;
+    int heldSize_;
+    struct sockaddr_in heldTo_;
+    long long dropped_;
+    long long reordered_;
+};
+
+bool parseTarget(const std::string& target, struct sockaddr_in& addr) {
+    size_t colon = target.rfind(':');
+    if (colon == std::string::npos) return false;
+    std::string host = target.substr(0, colon);
+    if (host == "localhost") host = "127.0.0.1";
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(std::atoi(target.c_str() + colon + 1)));
+    return inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1;
+}
+
+void addNs(struct timespec& t, long long ns) {
+    t.tv_nsec += ns;
+    while (t.tv_nsec >= 1000000000L) {
+        t.tv_nsec -= 1000000000L;
+        ++t.tv_sec;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    int listenPort = options.protocol == 1 ? HpsdrProtocol::P1_PORT
+                                           : HpsdrProtocol::P2_HIGH_PRIORITY_TO_RADIO_PORT;
+    int fd = openSocket(listenPort);
+    if (fd < 0) {
+        std::fprintf(stderr, "hpsdrsim: cannot bind port %d: %s\n", listenPort, std::strerror(errno));
+        return 1;
+    }
+
+    struct sockaddr_in client;
+    bool streaming = false;
+    if (!options.target.empty()) {
+        if (!parseTarget(options.target, client)) {
+            std::fprintf(stderr, "hpsdrsim: bad target %s\n", options.target.c_str());
+            return 1;
+        }
+        streaming = true;
+    }
+    std::fprintf(stderr, "hpsdrsim: protocol %d, %d Hz, %d receiver(s), listening on %d\n",
+                 options.protocol, options.sampleRate, options.receivers, listenPort);
+
+    SignalSource source(options);
+    Link link(fd, options);
+    std::vector<uint8_t> packet(std::max<int>(HpsdrProtocol::P1_PACKET_SIZE,
+                                              HpsdrProtocol::P2_IQ_PACKET_SIZE));
+    std::vector<uint8_t> command(HpsdrProtocol::P2_HIGH_PRIORITY_SIZE);
+    uint32_t sequence = 0;
+    uint32_t statusSequence = 0;
+    uint64_t timestamp = 0;
+    long long sent = 0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!quitRequested && (options.count < 0 || sent < options.count)) {
+        // Handle start/stop commands without blocking the stream.
+        struct pollfd pfd = {fd, POLLIN, 0};
+        while (::poll(&pfd, 1, streaming ? 0 : 100) > 0) {
+            struct sockaddr_in from;
+            socklen_t fromLen = sizeof(from);
+            ssize_t size = ::recvfrom(fd, command.data(), command.size(), 0,
+                                      reinterpret_cast<struct sockaddr*>(&from), &fromLen);
+            if (size <= 0) break;
+            bool run = false;
+            bool isCommand = false;
+            if (options.protocol == 1 && size == HpsdrProtocol::P1_COMMAND_SIZE &&
+                command[0] == 0xEF && command[1] == 0xFE && command[2] == 0x04) {
+                isCommand = true;
+                run = command[3] & 0x01;
+                client = from;
+            } else if (options.protocol == 2 && size == HpsdrProtocol::P2_HIGH_PRIORITY_SIZE) {
+                isCommand = true;
+                run = command[4] & 0x01;
+                client = from;
+                client.sin_port = htons(HpsdrProtocol::P2_DDC_BASE_PORT);
+            }
+            if (isCommand && run != streaming) {
+                streaming = run;
+                std::fprintf(stderr, "hpsdrsim: %s streaming to %s:%d\n", run ? "start" : "stop",
+                             inet_ntoa(client.sin_addr), ntohs(client.sin_port));
+                clock_gettime(CLOCK_MONOTONIC, &next);
+            }
+        }
+        if (!streaming) continue;
+
+        int size;
+        int samples;
+        if (options.protocol == 1) {
+            samples = buildP1Packet(packet.data(), sequence, options.receivers, source);
+            size = HpsdrProtocol::P1_PACKET_SIZE;
+            link.send(packet.data(), size, client);
+        } else {
+            samples = HpsdrProtocol::P2_IQ_SAMPLES_PER_FRAME;
+            // One packet per DDC, each to its own port.
+            for (int ddc = 0; ddc < options.receivers; ++ddc) {
+                size = buildP2Packet(packet.data(), sequence, timestamp, ddc, source);
+                struct sockaddr_in to = client;
+                to.sin_port = htons(static_cast<uint16_t>(ntohs(client.sin_port) + ddc));
+                link.send(packet.data(), size, to);
+            }
+            if (timestamp / (options.sampleRate / 10) != (timestamp + samples) / (options.sampleRate / 10)) {
+                size = buildP2Status(packet.data(), statusSequence++);
+                struct sockaddr_in to = client;
+                to.sin_port = htons(HpsdrProtocol::P2_HIGH_PRIORITY_FROM_RADIO_PORT);
+                ::sendto(fd, packet.data(), size, 0, reinterpret_cast<const struct sockaddr*>(&to), sizeof(to));
+            }
+            timestamp += samples;
+        }
+        ++sequence;
+        ++sent;
+
+        // Pace packets at the sample rate.
+        addNs(next, static_cast<long long>(samples) * 1000000000LL / options.sampleRate);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+    }
+
+    std::fprintf(stderr, "hpsdrsim: sent %lld packets, dropped %lld, reordered %lld\n", sent,
+                 link.dropped(), link.reordered());
+    ::close(fd);
+    return 0;
+}